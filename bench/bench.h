@@ -0,0 +1,59 @@
+/*
+ * Host micro-benchmark harness.
+ *
+ * Each benchmark runs its body `iterations` times per call. The harness grows
+ * the iteration count until one sample takes at least BENCH_MIN_SAMPLE_NS,
+ * then keeps the fastest of BENCH_SAMPLES samples.
+ *
+ * Results are written as CSV: name,iterations,ns_per_op,ops_per_s
+ * Saved result files use the same CSV preceded by a "# commit <id>" line, so a
+ * later run can be compared against them benchmark by benchmark.
+ */
+
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include "link/transport.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BENCH_MIN_SAMPLE_NS 20000000ull
+#define BENCH_SAMPLES 5
+#define BENCH_MAX_RESULTS 64
+#define BENCH_NAME_MAX 64
+
+struct bench_result {
+    char name[BENCH_NAME_MAX];
+    uint32_t iterations;
+    double ns_per_op;
+    double ops_per_s;
+};
+
+typedef void (*bench_fn_t)(void *context, uint32_t iterations);
+
+void bench_run(const char *name, bench_fn_t fn, void *context);
+
+/* Keep a computed value alive so the optimizer cannot drop the benchmark body */
+void bench_consume(uint32_t value);
+
+/* Link transport that takes and discards every write, so output paths cost no syscalls */
+extern const link_transport_t bench_null_link;
+
+void bench_print_results(FILE *out, const struct bench_result *results, int count);
+bool bench_write_results(const char *path, const char *commit, const struct bench_result *results,
+                         int count);
+/* Returns the number of results read, or -1 if the file cannot be opened */
+int bench_read_results(const char *path, struct bench_result *results, int max_results);
+/* Prints a baseline/current table and returns the number of regressions beyond the threshold */
+int bench_compare(FILE *out, const struct bench_result *baseline, int baseline_count,
+                  const struct bench_result *current, int current_count,
+                  double threshold_percent);
+
+void bench_dshot(void);
+void bench_usb_comm(void);
+void bench_telemetry_usb(void);
+void bench_log(void);
+void bench_esc_sim(void);
+
+#endif
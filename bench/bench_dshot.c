@@ -0,0 +1,59 @@
+/* Include the implementation directly to access static functions */
+#include "../src/dshot/dshot.c"
+#include "bench.h"
+#include "support/dshot_capture_synth.h"
+
+#define BENCH_FRAME_COUNT 16
+
+struct decode_bench {
+    enum dshot_rx_capture capture;
+    struct dshot_rx_calibration calibration;
+    uint32_t buffers[BENCH_FRAME_COUNT][CAPTURE_MAX_WORDS];
+    int word_counts[BENCH_FRAME_COUNT];
+};
+
+static void decode_bench_init(struct decode_bench *bench, enum dshot_rx_capture capture) {
+    bench->capture = capture;
+    reset_rx_calibration(&bench->calibration, capture);
+
+    for (int frame = 0; frame < BENCH_FRAME_COUNT; ++frame) {
+        uint32_t gcr20 = encode_gcr20_from_final_word(build_final_word((uint16_t)(frame * 251)));
+        if (capture == DSHOT_RX_CAPTURE_EDGE) {
+            bench->word_counts[frame] = synthesize_edge_capture(gcr20, bench->buffers[frame]);
+        } else {
+            synthesize_oversampled_capture(gcr20, bench->buffers[frame]);
+            bench->word_counts[frame] = OVERSAMPLE_WORDS;
+        }
+    }
+}
+
+static void bench_decode_telemetry(void *context, uint32_t iterations) {
+    struct decode_bench *bench = context;
+    uint32_t frame = 0;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        int index = i % BENCH_FRAME_COUNT;
+        decode_oversampled_telemetry(&bench->calibration, bench->capture, bench->buffers[index],
+                                     bench->word_counts[index], &frame);
+        bench_consume(frame);
+    }
+}
+
+static void bench_compute_frame(void *context, uint32_t iterations) {
+    (void)context;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        bench_consume(dshot_compute_frame((uint16_t)(i & 0x7FF), (int)(i & 1)));
+    }
+}
+
+void bench_dshot(void) {
+    static struct decode_bench oversample;
+    static struct decode_bench edge;
+
+    decode_bench_init(&oversample, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    decode_bench_init(&edge, DSHOT_RX_CAPTURE_EDGE);
+
+    bench_run("decode_oversampled_telemetry", bench_decode_telemetry, &oversample);
+    bench_run("decode_oversampled_telemetry_edge", bench_decode_telemetry, &edge);
+    bench_run("dshot_compute_frame", bench_compute_frame, NULL);
+}
@@ -0,0 +1,77 @@
+#include "bench.h"
+#include "dshot/control.h"
+#include "dshot/dshot.h"
+#include "mocks/mock_sdk.h"
+#include "motors.h"
+#include "sim/esc_sim.h"
+
+#define ESC_SIM_BENCH_SPEED 600
+#define ESC_SIM_BENCH_LOOP_US 1000
+#define ESC_SIM_BENCH_THROTTLE 1500
+
+struct esc_sim_bench {
+    struct esc_sim_bank bank;
+    struct dshot_controller controller0;
+    struct dshot_controller controller1;
+};
+
+/* Eight spinning ESCs with EDT enabled, as after the firmware's init sequence */
+static void esc_sim_bench_init(struct esc_sim_bench *bench, enum dshot_rx_capture capture) {
+    struct esc_sim_config config;
+
+    mock_sdk_reset();
+    esc_sim_default_config(&config);
+    esc_sim_init(&bench->bank, &config, ESC_SIM_BENCH_SPEED, capture);
+    esc_sim_add_escs(&bench->bank, MOTOR0_PIN_BASE, NUM_MOTORS_0);
+    esc_sim_add_escs(&bench->bank, MOTOR1_PIN_BASE, NUM_MOTORS_1);
+
+    dshot_controller_init(&bench->controller0, ESC_SIM_BENCH_SPEED, pio0, 0, MOTOR0_PIN_BASE,
+                          NUM_MOTORS_0, capture);
+    dshot_controller_init(&bench->controller1, ESC_SIM_BENCH_SPEED, pio0, 1, MOTOR1_PIN_BASE,
+                          NUM_MOTORS_1, capture);
+    dshot_send_command_to_all(&bench->controller0, &bench->controller1,
+                              DSHOT_EXTENDED_TELEMETRY_ENABLE, 10);
+    dshot_wait_for_telemetry(&bench->controller0, &bench->controller1);
+
+    for (int i = 0; i < NUM_MOTORS_0; ++i) {
+        dshot_throttle(&bench->controller0, i, ESC_SIM_BENCH_THROTTLE);
+    }
+    for (int i = 0; i < NUM_MOTORS_1; ++i) {
+        dshot_throttle(&bench->controller1, i, ESC_SIM_BENCH_THROTTLE);
+    }
+}
+
+/* One firmware loop: a frame and its telemetry on each controller */
+static void bench_esc_sim_loop(void *context, uint32_t iterations) {
+    struct esc_sim_bench *bench = context;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        dshot_mark_activity(&bench->controller0);
+        dshot_mark_activity(&bench->controller1);
+        dshot_loop(&bench->controller0);
+        dshot_loop(&bench->controller1);
+        mock_time_advance_us(ESC_SIM_BENCH_LOOP_US);
+        bench_consume(bench->controller0.motor[0].telemetry_data[DSHOT_TELEMETRY_TYPE_ERPM]);
+    }
+}
+
+static void bench_esc_sim_quality(void *context, uint32_t iterations) {
+    struct esc_sim_bench *bench = context;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        bench_consume((uint32_t)dshot_get_telemetry_quality_percent(&bench->controller0,
+                                                                     i % NUM_MOTORS_0));
+    }
+}
+
+void bench_esc_sim(void) {
+    static struct esc_sim_bench oversample;
+    static struct esc_sim_bench edge;
+
+    esc_sim_bench_init(&oversample, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    bench_run("esc_sim_dshot_loop", bench_esc_sim_loop, &oversample);
+    bench_run("esc_sim_quality_percent", bench_esc_sim_quality, &oversample);
+
+    esc_sim_bench_init(&edge, DSHOT_RX_CAPTURE_EDGE);
+    bench_run("esc_sim_dshot_loop_edge", bench_esc_sim_loop, &edge);
+}
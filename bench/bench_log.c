@@ -0,0 +1,41 @@
+/* Include the implementation directly to access static functions */
+#include "../src/log.c"
+#include "bench.h"
+#include "link/tx.h"
+
+static void bench_send_log(void *context, uint32_t iterations) {
+    const char *message = context;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        log_count = 0;
+        send_log(LOG_LEVEL_INFO, message);
+        link_tx_flush();
+    }
+}
+
+static void bench_send_log_rate_limited(void *context, uint32_t iterations) {
+    const char *message = context;
+    log_count = LOG_MAX_PER_SECOND;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        send_log(LOG_LEVEL_INFO, message);
+    }
+}
+
+static void bench_log_infof(void *context, uint32_t iterations) {
+    (void)context;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        log_count = 0;
+        log_infof("motor %d erpm %u", (int)(i & 7), i);
+        link_tx_flush();
+    }
+}
+
+void bench_log(void) {
+    static char message[] = "DShot telemetry timeout on motor 3";
+
+    link_transport_select(&bench_null_link);
+    log_init();
+    bench_run("send_log", bench_send_log, message);
+    bench_run("send_log_rate_limited", bench_send_log_rate_limited, message);
+    bench_run("log_infof", bench_log_infof, NULL);
+    link_transport_select(&link_transport_stdio);
+}
@@ -0,0 +1,161 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_DEFAULT_THRESHOLD_PERCENT 10.0
+
+static FILE *bench_output;
+static const char *bench_filter;
+static volatile uint32_t bench_sink;
+static struct bench_result bench_results[BENCH_MAX_RESULTS];
+static int bench_result_count;
+
+static uint64_t bench_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ull) + (uint64_t)now.tv_nsec;
+}
+
+static uint64_t bench_sample_ns(bench_fn_t fn, void *context, uint32_t iterations) {
+    uint64_t start = bench_now_ns();
+    fn(context, iterations);
+    return bench_now_ns() - start;
+}
+
+void bench_consume(uint32_t value) {
+    bench_sink ^= value;
+}
+
+static size_t bench_null_read(uint8_t *buf, size_t len) {
+    (void)buf;
+    (void)len;
+    return 0;
+}
+
+static size_t bench_null_write(const uint8_t *data, size_t len) {
+    if (len > 0) {
+        bench_consume(data[0]);
+    }
+    return len;
+}
+
+static size_t bench_null_writable(void) {
+    return SIZE_MAX;
+}
+
+static void bench_null_flush(void) {}
+
+const link_transport_t bench_null_link = {
+    .name = "null",
+    .init = NULL,
+    .read = bench_null_read,
+    .write = bench_null_write,
+    .writable = bench_null_writable,
+    .flush = bench_null_flush,
+};
+
+void bench_run(const char *name, bench_fn_t fn, void *context) {
+    if ((bench_filter != NULL && strstr(name, bench_filter) == NULL) ||
+        bench_result_count >= BENCH_MAX_RESULTS) {
+        return;
+    }
+
+    uint32_t iterations = 1;
+    while (bench_sample_ns(fn, context, iterations) < BENCH_MIN_SAMPLE_NS &&
+           iterations < (UINT32_MAX / 2)) {
+        iterations *= 2;
+    }
+
+    uint64_t best_ns = UINT64_MAX;
+    for (int sample = 0; sample < BENCH_SAMPLES; ++sample) {
+        uint64_t elapsed_ns = bench_sample_ns(fn, context, iterations);
+        if (elapsed_ns < best_ns) {
+            best_ns = elapsed_ns;
+        }
+    }
+
+    struct bench_result *result = &bench_results[bench_result_count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->iterations = iterations;
+    result->ns_per_op = (double)best_ns / iterations;
+    result->ops_per_s = result->ns_per_op > 0.0 ? 1e9 / result->ns_per_op : 0.0;
+}
+
+static void usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [filter] [--save file] [--commit id] [--compare baseline]\n"
+            "       [--threshold percent]\n",
+            program);
+}
+
+int main(int argc, char **argv) {
+    const char *save_path = NULL;
+    const char *compare_path = NULL;
+    const char *commit = "unknown";
+    double threshold_percent = BENCH_DEFAULT_THRESHOLD_PERCENT;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (argv[i][0] != '-') {
+            bench_filter = argv[i];
+        } else if (value == NULL) {
+            usage(argv[0]);
+            return 2;
+        } else if (strcmp(argv[i], "--save") == 0) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--commit") == 0) {
+            commit = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0) {
+            compare_path = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0) {
+            threshold_percent = strtod(argv[++i], NULL);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    /* Firmware code writes packets to stdout; results go to the original stdout instead */
+    bench_output = fdopen(dup(STDOUT_FILENO), "w");
+    if (bench_output == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        perror("bench");
+        return 1;
+    }
+
+    bench_dshot();
+    bench_usb_comm();
+    bench_telemetry_usb();
+    bench_log();
+    bench_esc_sim();
+
+    int status = 0;
+    if (save_path != NULL && !bench_write_results(save_path, commit, bench_results,
+                                                  bench_result_count)) {
+        perror(save_path);
+        status = 1;
+    }
+
+    if (compare_path != NULL) {
+        static struct bench_result baseline[BENCH_MAX_RESULTS];
+        int baseline_count = bench_read_results(compare_path, baseline, BENCH_MAX_RESULTS);
+        if (baseline_count < 0) {
+            perror(compare_path);
+            status = 1;
+        } else if (bench_compare(bench_output, baseline, baseline_count, bench_results,
+                                 bench_result_count, threshold_percent) > 0) {
+            status = 1;
+        }
+    } else {
+        bench_print_results(bench_output, bench_results, bench_result_count);
+    }
+
+    fclose(bench_output);
+    return status;
+}
@@ -0,0 +1,97 @@
+#include "bench.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_LINE_MAX 256
+/* Changes smaller than this are timer noise on nanosecond-scale benchmarks */
+#define BENCH_MIN_DELTA_NS 1.0
+
+void bench_print_results(FILE *out, const struct bench_result *results, int count) {
+    fprintf(out, "name,iterations,ns_per_op,ops_per_s\n");
+    for (int i = 0; i < count; ++i) {
+        fprintf(out, "%s,%u,%.2f,%.0f\n", results[i].name, results[i].iterations,
+                results[i].ns_per_op, results[i].ops_per_s);
+    }
+}
+
+bool bench_write_results(const char *path, const char *commit, const struct bench_result *results,
+                         int count) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        return false;
+    }
+
+    fprintf(file, "# commit %s\n", commit);
+    bench_print_results(file, results, count);
+    return fclose(file) == 0;
+}
+
+int bench_read_results(const char *path, struct bench_result *results, int max_results) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+
+    char line[BENCH_LINE_MAX];
+    int count = 0;
+    while (count < max_results && fgets(line, sizeof(line), file) != NULL) {
+        struct bench_result *result = &results[count];
+        char *comma = strchr(line, ',');
+        if (line[0] == '#' || comma == NULL || comma - line >= (long)sizeof(result->name)) {
+            continue;
+        }
+
+        memcpy(result->name, line, (size_t)(comma - line));
+        result->name[comma - line] = '\0';
+        if (sscanf(comma + 1, "%u,%lf,%lf", &result->iterations, &result->ns_per_op,
+                   &result->ops_per_s) == 3) {
+            count++;
+        }
+    }
+
+    fclose(file);
+    return count;
+}
+
+static const struct bench_result *find_result(const struct bench_result *results, int count,
+                                              const char *name) {
+    for (int i = 0; i < count; ++i) {
+        if (strcmp(results[i].name, name) == 0) {
+            return &results[i];
+        }
+    }
+    return NULL;
+}
+
+int bench_compare(FILE *out, const struct bench_result *baseline, int baseline_count,
+                  const struct bench_result *current, int current_count,
+                  double threshold_percent) {
+    int regressions = 0;
+
+    fprintf(out, "%-36s %12s %12s %9s  %s\n", "benchmark", "base ns/op", "ns/op", "change",
+            "status");
+    for (int i = 0; i < current_count; ++i) {
+        const struct bench_result *base = find_result(baseline, baseline_count, current[i].name);
+        if (base == NULL || base->ns_per_op <= 0.0) {
+            fprintf(out, "%-36s %12s %12.2f %9s  new\n", current[i].name, "-",
+                    current[i].ns_per_op, "-");
+            continue;
+        }
+
+        double delta_ns = current[i].ns_per_op - base->ns_per_op;
+        double change_percent = (delta_ns / base->ns_per_op) * 100.0;
+        const char *status = "ok";
+        if (change_percent > threshold_percent && delta_ns > BENCH_MIN_DELTA_NS) {
+            status = "REGRESSED";
+            regressions++;
+        } else if (change_percent < -threshold_percent && -delta_ns > BENCH_MIN_DELTA_NS) {
+            status = "improved";
+        }
+        fprintf(out, "%-36s %12.2f %12.2f %+8.1f%%  %s\n", current[i].name, base->ns_per_op,
+                current[i].ns_per_op, change_percent, status);
+    }
+
+    fprintf(out, "%d regression(s) beyond %.1f%%\n", regressions, threshold_percent);
+    return regressions;
+}
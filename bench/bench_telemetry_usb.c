@@ -0,0 +1,39 @@
+#include "bench.h"
+#include "dshot/telemetry_usb.h"
+#include "link/tx.h"
+#include "motors.h"
+#include <stddef.h>
+
+#define BENCH_TELEMETRY_TYPES 4
+
+/*
+ * One loop's worth of telemetry: every motor reports eRPM, voltage, temperature
+ * and current, and the batches go out through the link's output queue
+ */
+static void bench_telemetry_flush(void *context, uint32_t iterations) {
+    (void)context;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        for (uint8_t motor = 0; motor < NUM_MOTORS; ++motor) {
+            for (uint8_t type = 0; type < BENCH_TELEMETRY_TYPES; ++type) {
+                dshot_telemetry_usb_send(motor, type, (int32_t)(i + motor));
+            }
+        }
+        dshot_telemetry_usb_flush();
+        link_tx_flush();
+    }
+}
+
+static void bench_telemetry_flush_empty(void *context, uint32_t iterations) {
+    (void)context;
+    for (uint32_t i = 0; i < iterations; ++i) {
+        dshot_telemetry_usb_flush();
+    }
+}
+
+void bench_telemetry_usb(void) {
+    link_transport_select(&bench_null_link);
+    dshot_telemetry_usb_init();
+    bench_run("dshot_telemetry_usb_flush", bench_telemetry_flush, NULL);
+    bench_run("dshot_telemetry_usb_flush_empty", bench_telemetry_flush_empty, NULL);
+    link_transport_select(&link_transport_stdio);
+}
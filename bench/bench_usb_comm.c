@@ -0,0 +1,91 @@
+/* Include the implementation directly, as the Makefile does not build usb_comm.c here */
+#include "../src/usb_comm.c"
+#include "bench.h"
+#include "link/transport.h"
+#include "motors.h"
+#include <string.h>
+
+#define BENCH_COMMAND_PACKET_SIZE USB_INPUT_PACKET_SIZE(NUM_MOTORS)
+#define BENCH_CONFIG_PACKET_SIZE 16
+
+static uint8_t bench_stream[BENCH_COMMAND_PACKET_SIZE];
+static size_t bench_stream_pos;
+
+/* Replay the same command packet back to back, one packet per read as a CDC transfer would */
+static size_t bench_link_read(uint8_t *buf, size_t len) {
+    size_t count = 0;
+    do {
+        buf[count++] = bench_stream[bench_stream_pos++];
+    } while (count < len && bench_stream_pos < sizeof(bench_stream));
+    bench_stream_pos %= sizeof(bench_stream);
+    return count;
+}
+
+static size_t bench_link_write(const uint8_t *data, size_t len) {
+    (void)data;
+    return len;
+}
+
+static size_t bench_link_writable(void) {
+    return SIZE_MAX;
+}
+
+static void bench_link_flush(void) {}
+
+static const link_transport_t bench_link = {
+    .name = "bench",
+    .init = NULL,
+    .read = bench_link_read,
+    .write = bench_link_write,
+    .writable = bench_link_writable,
+    .flush = bench_link_flush,
+};
+
+static void bench_build_command_packet(uint8_t *packet) {
+    packet[0] = USB_INPUT_START_BYTE;
+    for (int motor = 0; motor < NUM_MOTORS; ++motor) {
+        uint16_t value = (uint16_t)(1000 + (motor * 100));
+        packet[(2 * motor) + 1] = (uint8_t)(value & 0xFF);
+        packet[(2 * motor) + 2] = (uint8_t)(value >> 8);
+    }
+    packet[BENCH_COMMAND_PACKET_SIZE - 1] =
+        usb_calculate_checksum(packet, BENCH_COMMAND_PACKET_SIZE - 1);
+}
+
+static void bench_poll_multi(void *context, uint32_t iterations) {
+    (void)context;
+    uint8_t command_buf[BENCH_COMMAND_PACKET_SIZE];
+    uint8_t config_buf[BENCH_CONFIG_PACKET_SIZE];
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        usb_packet_kind_t kind =
+            usb_poll_multi(command_buf, sizeof(command_buf), config_buf, sizeof(config_buf));
+        bench_consume((uint32_t)kind);
+    }
+}
+
+static void bench_parse_packet(void *context, uint32_t iterations) {
+    const uint8_t *packet = context;
+    uint16_t raw_values[NUM_MOTORS];
+    absolute_time_t last_comm_time = 0;
+
+    for (uint32_t i = 0; i < iterations; ++i) {
+        bench_consume(usb_parse_packet(packet, BENCH_COMMAND_PACKET_SIZE, raw_values, NUM_MOTORS,
+                                       &last_comm_time));
+        bench_consume(raw_values[i % NUM_MOTORS]);
+    }
+}
+
+void bench_usb_comm(void) {
+    static uint8_t packet[BENCH_COMMAND_PACKET_SIZE];
+
+    bench_build_command_packet(packet);
+    memcpy(bench_stream, packet, sizeof(bench_stream));
+    bench_stream_pos = 0;
+    usb_comm_reset();
+    link_transport_select(&bench_link);
+
+    bench_run("usb_poll_multi", bench_poll_multi, NULL);
+    bench_run("usb_parse_packet", bench_parse_packet, packet);
+    link_transport_select(&link_transport_stdio);
+}
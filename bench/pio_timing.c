@@ -0,0 +1,176 @@
+/*
+ * DShot frame timing measured on the assembled dshot.pio programs.
+ *
+ * Runs one frame per DShot speed and capture mode through the cycle-level
+ * PIO emulator (tests/sim/pio_emu.h), with the TX words pushed by
+ * dshot_loop_async_start() and a nominal ESC response `latency` after the
+ * frame. The captured words are checked with the firmware decoder. Times
+ * include the PIO clock divider's 1/256 quantization.
+ *
+ * Output is CSV:
+ *   speed,capture,clkdiv,tx_us,wait_us,rx_us,frame_us,timeout_frame_us,max_loop_hz,decoded
+ * frame_us runs from the first TX instruction until the SM waits for the next
+ * frame; timeout_frame_us is the same with no response. max_loop_hz is the
+ * highest per-SM frame rate with a response.
+ *
+ * Usage: pio_timing [--sys-clock-mhz n] [--latency-us n] [--source path]
+ */
+
+/* Include the implementation directly to access the static decoder */
+#include "../src/dshot/dshot.c"
+#include "sim/pio_emu.h"
+#include "support/dshot_capture_synth.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TIMING_PIN 6
+#define TIMING_MAX_CYCLES 200000
+#define TIMING_DEFAULT_LATENCY_US 26.0
+#define TIMING_TELEMETRY_VALUE 0x0ABC
+
+static const uint16_t timing_speeds[] = {150, 300, 600, 1200};
+
+struct timing_cycles {
+    uint64_t first;   /* First TX falling edge */
+    uint64_t release; /* set pindirs, 0 */
+    uint64_t redrive; /* set pindirs, 1 after the RX phase */
+};
+
+struct timing_result {
+    double tx_us;
+    double wait_us;
+    double rx_us;
+    double frame_us;
+    bool decoded;
+};
+
+static void find_phases(const struct pio_emu_sm *sm, struct timing_cycles *cycles) {
+    bool driven_high = true;
+
+    memset(cycles, 0, sizeof(*cycles));
+    for (int i = 0; i < sm->event_count; ++i) {
+        const struct pio_emu_pin_event *event = &sm->events[i];
+        bool driven = (event->pindirs >> TIMING_PIN) & 0x1u;
+        bool high = (event->pins >> TIMING_PIN) & 0x1u;
+        if (driven && !high && driven_high && cycles->first == 0) {
+            cycles->first = event->cycle;
+        }
+        if (!driven && cycles->release == 0) {
+            cycles->release = event->cycle;
+        } else if (driven && cycles->release != 0 && cycles->redrive == 0) {
+            cycles->redrive = event->cycle;
+        }
+        driven_high = !driven || high;
+    }
+}
+
+static double span_us(const struct pio_emu_sm *sm, uint64_t from, uint64_t to) {
+    return (pio_emu_cycle_time_ns(sm, to) - pio_emu_cycle_time_ns(sm, from)) / 1e3;
+}
+
+static void run_timing(const struct pio_emu_program *program, enum dshot_rx_capture capture,
+                       uint16_t speed, double sys_clock_hz, double latency_us, bool respond,
+                       struct timing_result *result) {
+    struct pio_emu_sm sm;
+    struct pio_emu_line line = {.pin = TIMING_PIN};
+    uint32_t wait_cycles = (25 * speed * PIO_CYCLES_PER_TX_BIT) / 1000;
+    uint32_t tx_words[] = {~(uint32_t)dshot_compute_frame(1000, 0) << 16, wait_cycles,
+                           EDGE_CAPTURE_RUN_LIMIT};
+    uint32_t rx_words[EDGE_CAPTURE_MAX_WORDS + 1];
+    float clkdiv = (float)sys_clock_hz / (1000.0F * (float)speed * PIO_CYCLES_PER_TX_BIT);
+    uint16_t final_word = build_final_word(TIMING_TELEMETRY_VALUE);
+
+    memset(result, 0, sizeof(*result));
+    pio_emu_init(&sm, program, TIMING_PIN, (uint32_t)sys_clock_hz, clkdiv);
+    sm.pins = 1u << TIMING_PIN;
+    pio_emu_set_input(&sm, pio_emu_line_input, &line);
+
+    /* The frame's last bit ends 3 + 2000 cycles in; latency is measured from there */
+    if (respond) {
+        double cycles_per_us = (1u << 16) * 1e3 / pio_emu_cycle_time_ns(&sm, 1u << 16);
+        uint64_t start = 3 + (16 * PIO_CYCLES_PER_TX_BIT) + (uint64_t)(latency_us * cycles_per_us);
+        pio_emu_line_add_nrzi(&line, start, (1u << 20) | encode_gcr20_from_final_word(final_word),
+                              GCR_FRAME_BITS, PIO_CYCLES_PER_TX_BIT * RX_BIT_RATIO_DEN /
+                                                  (double)RX_BIT_RATIO_NUM);
+    }
+
+    int word_count = pio_emu_run_frame(&sm, tx_words, capture == DSHOT_RX_CAPTURE_EDGE ? 3 : 2,
+                                       rx_words, EDGE_CAPTURE_MAX_WORDS + 1, TIMING_MAX_CYCLES);
+    struct timing_cycles cycles;
+    find_phases(&sm, &cycles);
+    result->tx_us = span_us(&sm, cycles.first, cycles.first + (16 * PIO_CYCLES_PER_TX_BIT));
+    result->wait_us = span_us(&sm, cycles.first, cycles.release) - result->tx_us;
+    result->rx_us = span_us(&sm, cycles.release, cycles.redrive);
+    result->frame_us = span_us(&sm, 0, sm.cycle - 1);
+
+    struct dshot_rx_calibration calibration = {0};
+    uint32_t decoded = 0;
+    reset_rx_calibration(&calibration, capture);
+    if (capture == DSHOT_RX_CAPTURE_OVERSAMPLE && word_count == OVERSAMPLE_TOTAL_WORDS) {
+        word_count = OVERSAMPLE_WORDS;
+    }
+    result->decoded = word_count > 0 &&
+                      decode_oversampled_telemetry(&calibration, capture, rx_words, word_count,
+                                                   &decoded) == DECODE_OK &&
+                      decoded == final_word;
+}
+
+static void print_timing(const struct pio_emu_program *program, enum dshot_rx_capture capture,
+                         const char *capture_name, uint16_t speed, double sys_clock_hz,
+                         double latency_us) {
+    double clkdiv = sys_clock_hz / (1000.0 * speed * PIO_CYCLES_PER_TX_BIT);
+    if (clkdiv < 1.0) {
+        printf("# DShot%u %s: clock divider %.3f < 1, unsupported at %.0f MHz\n", speed,
+               capture_name, clkdiv, sys_clock_hz / 1e6);
+        return;
+    }
+
+    struct timing_result answered;
+    struct timing_result silent;
+    run_timing(program, capture, speed, sys_clock_hz, latency_us, true, &answered);
+    run_timing(program, capture, speed, sys_clock_hz, latency_us, false, &silent);
+
+    printf("%u,%s,%.4f,%.2f,%.2f,%.2f,%.2f,%.2f,%.0f,%s\n", speed, capture_name, clkdiv,
+           answered.tx_us, answered.wait_us, answered.rx_us, answered.frame_us, silent.frame_us,
+           1e6 / answered.frame_us, answered.decoded ? "yes" : "no");
+}
+
+int main(int argc, char **argv) {
+    double sys_clock_hz = 125e6;
+    double latency_us = TIMING_DEFAULT_LATENCY_US;
+    const char *source = "src/dshot/dshot.pio";
+    struct pio_emu_program oversample;
+    struct pio_emu_program edge;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--sys-clock-mhz") == 0) {
+            sys_clock_hz = strtod(argv[i + 1], NULL) * 1e6;
+        } else if (strcmp(argv[i], "--latency-us") == 0) {
+            latency_us = strtod(argv[i + 1], NULL);
+        } else if (strcmp(argv[i], "--source") == 0) {
+            source = argv[i + 1];
+        }
+    }
+
+    int error = pio_emu_assemble_file(source, "pio_dshot", &oversample);
+    if (error == 0) {
+        error = pio_emu_assemble_file(source, "pio_dshot_edge", &edge);
+    }
+    if (error != 0) {
+        fprintf(stderr, "pio_timing: cannot assemble %s (line %d)\n", source, error);
+        return 1;
+    }
+
+    printf("# pio_dshot: %u instructions, pio_dshot_edge: %u instructions\n", oversample.length,
+           edge.length);
+    printf("speed,capture,clkdiv,tx_us,wait_us,rx_us,frame_us,timeout_frame_us,max_loop_hz,"
+           "decoded\n");
+    for (size_t i = 0; i < sizeof(timing_speeds) / sizeof(timing_speeds[0]); ++i) {
+        print_timing(&oversample, DSHOT_RX_CAPTURE_OVERSAMPLE, "oversample", timing_speeds[i],
+                     sys_clock_hz, latency_us);
+        print_timing(&edge, DSHOT_RX_CAPTURE_EDGE, "edge", timing_speeds[i], sys_clock_hz,
+                     latency_us);
+    }
+    return 0;
+}
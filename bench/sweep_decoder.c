@@ -0,0 +1,222 @@
+/*
+ * Telemetry decoder timing tolerance sweep.
+ *
+ * Synthesizes oversampled captures the way pio_dshot samples a real ESC and
+ * runs them through decode_oversampled_telemetry() while sweeping:
+ *   - ESC clock skew: the ESC's bit period relative to nominal (+-10%)
+ *   - Edge jitter: each line transition moved by up to +-N% of a bit
+ *   - Sample phase: delay from the response's falling edge, which starts the
+ *     PIO sampling loop, to the first sample
+ *
+ * The PIO samples every PIO_CYCLES_PER_SAMPLE cycles of a clock divided from
+ * clk_sys, so each DShot speed differs only in its clock divider: the divider
+ * is quantized to 1/256 and every PIO cycle starts on a clk_sys edge. Both
+ * effects are modelled. Speeds whose divider would be below 1 cannot be run.
+ *
+ * Output is CSV (speed,mode,jitter_pct,skew_pct,success_pct) followed by
+ * "#" summary lines giving the skew range decoded at >= 99% per curve.
+ *
+ * Usage: sweep_decoder [--sys-clock-mhz n] [--frames n]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+/* Include the implementation directly to access the static decoder */
+#include "../src/dshot/dshot.c"
+#include "support/dshot_capture_synth.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SWEEP_SAMPLES (OVERSAMPLE_WORDS * 32)
+#define SWEEP_SKEW_MIN_PCT (-10)
+#define SWEEP_SKEW_MAX_PCT 10
+#define SWEEP_PHASES 8
+#define SWEEP_DEFAULT_FRAMES 64
+#define SWEEP_WARMUP_FRAMES (CALIBRATION_FRAMES * 2)
+#define SWEEP_PASS_PERCENT 99.0
+#define SWEEP_CLKDIV_FRAC_BITS 8
+
+enum sweep_mode {
+    SWEEP_MODE_DEFAULT,
+    SWEEP_MODE_CALIBRATED,
+    SWEEP_MODE_STRICT,
+    SWEEP_MODE_COUNT,
+};
+
+static const char *const sweep_mode_names[SWEEP_MODE_COUNT] = {
+    [SWEEP_MODE_DEFAULT] = "default",
+    [SWEEP_MODE_CALIBRATED] = "calibrated",
+    [SWEEP_MODE_STRICT] = "strict",
+};
+
+static const uint16_t sweep_speeds[] = {150, 300, 600, 1200};
+static const int sweep_jitter_pct[] = {0, 5, 10, 15};
+
+struct sweep_timing {
+    double sys_period_ns;
+    uint32_t clkdiv_q8;    /* PIO clock divider as programmed, 8 fractional bits */
+    double esc_bit_ns;     /* ESC's telemetry bit period including skew */
+    double jitter_ns;      /* Maximum displacement of each edge */
+    double phase_cycles;   /* PIO cycles between the response's first edge and sample 0 */
+};
+
+static uint32_t sweep_rng_state = 0x12345678u;
+
+static uint32_t sweep_rand(void) {
+    sweep_rng_state ^= sweep_rng_state << 13;
+    sweep_rng_state ^= sweep_rng_state >> 17;
+    sweep_rng_state ^= sweep_rng_state << 5;
+    return sweep_rng_state;
+}
+
+static double sweep_rand_unit(void) {
+    return ((double)sweep_rand() / (double)UINT32_MAX * 2.0) - 1.0;
+}
+
+/* Time of PIO cycle n: the fractional divider advances whole clk_sys periods */
+static double pio_cycle_time_ns(const struct sweep_timing *timing, double cycle) {
+    double sys_ticks = (cycle * timing->clkdiv_q8) / (1u << SWEEP_CLKDIV_FRAC_BITS);
+    return (double)(uint64_t)(sys_ticks + 0.5) * timing->sys_period_ns;
+}
+
+static void synthesize_skewed_capture(uint32_t gcr20, const struct sweep_timing *timing,
+                                      uint32_t *buffer) {
+    uint32_t stream21 = (1u << 20) | gcr20;
+    double edges_ns[GCR_FRAME_BITS];
+    int edge_count = 0;
+
+    /*
+     * NRZI: every 1 bit is a transition at the start of its bit period. The
+     * first edge triggers sampling, so it defines time zero and is not jittered.
+     */
+    for (int bit = 0; bit < GCR_FRAME_BITS; ++bit) {
+        if ((stream21 >> (20 - bit)) & 0x1u) {
+            double jitter_ns = bit == 0 ? 0.0 : sweep_rand_unit() * timing->jitter_ns;
+            edges_ns[edge_count++] = (bit * timing->esc_bit_ns) + jitter_ns;
+        }
+    }
+
+    memset(buffer, 0, OVERSAMPLE_WORDS * sizeof(*buffer));
+    for (int sample = 0; sample < SWEEP_SAMPLES; ++sample) {
+        double t = pio_cycle_time_ns(timing, timing->phase_cycles +
+                                                 ((double)sample * PIO_CYCLES_PER_SAMPLE));
+        int toggles = 0;
+        for (int edge = 0; edge < edge_count; ++edge) {
+            toggles += edges_ns[edge] <= t;
+        }
+        uint32_t level = (toggles & 1) ? 0 : 1;
+        buffer[sample / 32] |= level << (31 - (sample % 32));
+    }
+}
+
+static void sweep_reset_calibration(struct dshot_rx_calibration *calibration,
+                                    enum sweep_mode mode) {
+    reset_rx_calibration(calibration, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    if (mode == SWEEP_MODE_STRICT) {
+        set_length_transitions(calibration, calibration->samples_per_bit_q8, true);
+    }
+}
+
+static bool sweep_decode_frame(struct dshot_rx_calibration *calibration, enum sweep_mode mode,
+                               const struct sweep_timing *timing) {
+    uint16_t final_word = build_final_word((uint16_t)(sweep_rand() & 0x0FFF));
+    uint32_t buffer[OVERSAMPLE_WORDS];
+    uint32_t decoded = 0;
+
+    synthesize_skewed_capture(encode_gcr20_from_final_word(final_word), timing, buffer);
+
+    /* Only the calibrated mode keeps what the tracking loop learns */
+    struct dshot_rx_calibration frozen = *calibration;
+    struct dshot_rx_calibration *target = mode == SWEEP_MODE_CALIBRATED ? calibration : &frozen;
+    return decode_oversampled_telemetry(target, DSHOT_RX_CAPTURE_OVERSAMPLE, buffer,
+                                        OVERSAMPLE_WORDS, &decoded) == DECODE_OK &&
+           decoded == final_word;
+}
+
+static double sweep_point(enum sweep_mode mode, struct sweep_timing timing, int frames) {
+    struct dshot_rx_calibration calibration = {0};
+    int decoded = 0;
+    int total = 0;
+
+    sweep_reset_calibration(&calibration, mode);
+    if (mode == SWEEP_MODE_CALIBRATED) {
+        for (int i = 0; i < SWEEP_WARMUP_FRAMES; ++i) {
+            timing.phase_cycles = (sweep_rand() % (PIO_CYCLES_PER_SAMPLE * 16)) / 16.0;
+            sweep_decode_frame(&calibration, mode, &timing);
+        }
+    }
+
+    for (int phase = 0; phase < SWEEP_PHASES; ++phase) {
+        timing.phase_cycles = ((double)phase * PIO_CYCLES_PER_SAMPLE) / SWEEP_PHASES;
+        for (int i = 0; i < frames; ++i) {
+            decoded += sweep_decode_frame(&calibration, mode, &timing);
+            total++;
+        }
+    }
+
+    return (100.0 * decoded) / total;
+}
+
+static void sweep_speed(uint16_t speed, double sys_clock_hz, int frames) {
+    double clkdiv = sys_clock_hz / (1000.0 * speed * PIO_CYCLES_PER_TX_BIT);
+    if (clkdiv < 1.0) {
+        printf("# DShot%u: clock divider %.3f < 1, unsupported at %.0f MHz\n", speed, clkdiv,
+               sys_clock_hz / 1e6);
+        return;
+    }
+
+    struct sweep_timing timing = {
+        .sys_period_ns = 1e9 / sys_clock_hz,
+        .clkdiv_q8 = (uint32_t)(clkdiv * (1u << SWEEP_CLKDIV_FRAC_BITS)),
+    };
+    double nominal_bit_ns = (1e6 / speed) * RX_BIT_RATIO_DEN / RX_BIT_RATIO_NUM;
+
+    for (int mode = 0; mode < SWEEP_MODE_COUNT; ++mode) {
+        for (size_t j = 0; j < sizeof(sweep_jitter_pct) / sizeof(sweep_jitter_pct[0]); ++j) {
+            int pass_min = SWEEP_SKEW_MAX_PCT + 1;
+            int pass_max = SWEEP_SKEW_MIN_PCT - 1;
+
+            for (int skew = SWEEP_SKEW_MIN_PCT; skew <= SWEEP_SKEW_MAX_PCT; ++skew) {
+                timing.esc_bit_ns = nominal_bit_ns * (100 + skew) / 100.0;
+                timing.jitter_ns = nominal_bit_ns * sweep_jitter_pct[j] / 100.0;
+
+                double success = sweep_point((enum sweep_mode)mode, timing, frames);
+                printf("%u,%s,%d,%d,%.2f\n", speed, sweep_mode_names[mode], sweep_jitter_pct[j],
+                       skew, success);
+                if (success >= SWEEP_PASS_PERCENT) {
+                    pass_min = skew < pass_min ? skew : pass_min;
+                    pass_max = skew > pass_max ? skew : pass_max;
+                }
+            }
+
+            if (pass_min <= pass_max) {
+                printf("# DShot%u %s jitter %d%%: >= %.0f%% from %+d%% to %+d%% skew\n", speed,
+                       sweep_mode_names[mode], sweep_jitter_pct[j], SWEEP_PASS_PERCENT, pass_min,
+                       pass_max);
+            } else {
+                printf("# DShot%u %s jitter %d%%: never >= %.0f%%\n", speed,
+                       sweep_mode_names[mode], sweep_jitter_pct[j], SWEEP_PASS_PERCENT);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    double sys_clock_hz = 125e6;
+    int frames = SWEEP_DEFAULT_FRAMES;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--sys-clock-mhz") == 0) {
+            sys_clock_hz = strtod(argv[i + 1], NULL) * 1e6;
+        } else if (strcmp(argv[i], "--frames") == 0) {
+            frames = atoi(argv[i + 1]) > 0 ? atoi(argv[i + 1]) : SWEEP_DEFAULT_FRAMES;
+        }
+    }
+
+    printf("speed,mode,jitter_pct,skew_pct,success_pct\n");
+    for (size_t i = 0; i < sizeof(sweep_speeds) / sizeof(sweep_speeds[0]); ++i) {
+        sweep_speed(sweep_speeds[i], sys_clock_hz, frames);
+    }
+    return 0;
+}
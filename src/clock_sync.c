@@ -0,0 +1,155 @@
+#include "clock_sync.h"
+#include "link/tx.h"
+#include "usb_comm.h"
+#include <pico/time.h>
+#include <pico/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Host time minus MCU time at ref_mcu_us; the reference moves with every sample */
+static bool synced;
+static uint32_t ref_mcu_us;
+static uint32_t ref_offset_us;
+static int32_t drift_ppb;
+static uint32_t outliers; /* Consecutive samples off by more than CLOCK_SYNC_STEP_US */
+static clock_sync_stats_t stats;
+
+/* The last ping, waiting for the round trip the next ping reports for it */
+static bool have_last_ping;
+static uint8_t last_ping_seq;
+static uint32_t last_ping_host_us;
+static uint32_t last_ping_mcu_us;
+
+static uint32_t read_u32(const uint8_t *data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint32_t offset_at(uint32_t mcu_us) {
+    int32_t elapsed_us = (int32_t)(mcu_us - ref_mcu_us);
+    return ref_offset_us + (uint32_t)(int32_t)(((int64_t)elapsed_us * drift_ppb) / 1000000000);
+}
+
+static void restart(uint32_t mcu_us, uint32_t offset_us) {
+    ref_mcu_us = mcu_us;
+    ref_offset_us = offset_us;
+    drift_ppb = 0;
+    outliers = 0;
+    stats.drift_ppb = 0;
+    synced = true;
+}
+
+static void track_rtt(uint32_t rtt_us) {
+    if (stats.rtt_mean_us == 0) {
+        stats.rtt_min_us = rtt_us;
+        stats.rtt_max_us = rtt_us;
+        stats.rtt_mean_us = rtt_us;
+    }
+    stats.rtt_last_us = rtt_us;
+    stats.rtt_min_us = rtt_us < stats.rtt_min_us ? rtt_us : stats.rtt_min_us;
+    stats.rtt_max_us = rtt_us > stats.rtt_max_us ? rtt_us : stats.rtt_max_us;
+    stats.rtt_mean_us = (uint32_t)((int32_t)stats.rtt_mean_us +
+                                   ((int32_t)(rtt_us - stats.rtt_mean_us) / 8));
+}
+
+/* Phase and frequency loop: a quarter of the error goes into the offset, a sixteenth into drift */
+static void add_sample(uint32_t mcu_us, uint32_t offset_us) {
+    if (!synced) {
+        restart(mcu_us, offset_us);
+        return;
+    }
+
+    uint32_t predicted_us = offset_at(mcu_us);
+    int32_t error_us = (int32_t)(offset_us - predicted_us);
+    stats.offset_error_us = error_us;
+    if (error_us > CLOCK_SYNC_STEP_US || error_us < -CLOCK_SYNC_STEP_US) {
+        /* One stray sample is ignored; a run of them means the host clock stepped */
+        if (++outliers >= CLOCK_SYNC_STEP_SAMPLES) {
+            restart(mcu_us, offset_us);
+        }
+        return;
+    }
+    outliers = 0;
+
+    int32_t elapsed_us = (int32_t)(mcu_us - ref_mcu_us);
+    ref_mcu_us = mcu_us;
+    ref_offset_us = predicted_us + (uint32_t)(error_us / 4);
+    if (elapsed_us > 0) {
+        int64_t drift = drift_ppb + (((int64_t)error_us * 1000000000 / elapsed_us) / 16);
+        if (drift > CLOCK_SYNC_MAX_DRIFT_PPB) {
+            drift = CLOCK_SYNC_MAX_DRIFT_PPB;
+        } else if (drift < -CLOCK_SYNC_MAX_DRIFT_PPB) {
+            drift = -CLOCK_SYNC_MAX_DRIFT_PPB;
+        }
+        drift_ppb = (int32_t)drift;
+    }
+    stats.drift_ppb = drift_ppb;
+}
+
+bool clock_sync_handle_ping(const uint8_t *packet, absolute_time_t rx_time) {
+    if (packet[0] != CLOCK_SYNC_PING_START_BYTE ||
+        usb_calculate_checksum(packet, CLOCK_SYNC_PING_PACKET_SIZE - 1) !=
+            packet[CLOCK_SYNC_PING_PACKET_SIZE - 1]) {
+        return false;
+    }
+
+    uint32_t host_time_us = read_u32(&packet[2]);
+    uint32_t previous_rtt_us = read_u32(&packet[6]);
+    uint32_t mcu_rx_us = (uint32_t)to_us_since_boot(rx_time);
+    stats.pings++;
+    if (previous_rtt_us > 0) {
+        track_rtt(previous_rtt_us);
+        /* The round trip belongs to the last ping, so that ping's transit is the sample.
+         * A slow round trip says little about which way the delay went. */
+        if (have_last_ping && packet[1] == (uint8_t)(last_ping_seq + 1) &&
+            previous_rtt_us <= stats.rtt_min_us + CLOCK_SYNC_RTT_SLACK_US) {
+            add_sample(last_ping_mcu_us,
+                       last_ping_host_us + (previous_rtt_us / 2) - last_ping_mcu_us);
+            stats.samples_used++;
+        }
+    }
+    have_last_ping = true;
+    last_ping_seq = packet[1];
+    last_ping_host_us = host_time_us;
+    last_ping_mcu_us = mcu_rx_us;
+
+    uint8_t pong[CLOCK_SYNC_PONG_PACKET_SIZE];
+    uint32_t mcu_tx_us = (uint32_t)to_us_since_boot(get_absolute_time());
+    pong[0] = CLOCK_SYNC_PONG_START_BYTE;
+    pong[1] = packet[1];
+    memcpy(&pong[2], &host_time_us, sizeof(uint32_t));
+    memcpy(&pong[6], &mcu_rx_us, sizeof(uint32_t));
+    memcpy(&pong[10], &mcu_tx_us, sizeof(uint32_t));
+    pong[CLOCK_SYNC_PONG_PACKET_SIZE - 1] =
+        usb_calculate_checksum(pong, CLOCK_SYNC_PONG_PACKET_SIZE - 1);
+    link_tx_send(LINK_STREAM_CONTROL, pong, sizeof(pong));
+    return true;
+}
+
+bool clock_sync_host_time_us(uint32_t mcu_us, uint32_t *host_us) {
+    if (!synced) {
+        return false;
+    }
+    *host_us = mcu_us + offset_at(mcu_us);
+    return true;
+}
+
+bool clock_sync_synced(void) {
+    return synced;
+}
+
+const clock_sync_stats_t *clock_sync_stats(void) {
+    return &stats;
+}
+
+void clock_sync_reset(void) {
+    synced = false;
+    ref_mcu_us = 0;
+    ref_offset_us = 0;
+    drift_ppb = 0;
+    outliers = 0;
+    have_last_ping = false;
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,67 @@
+/*
+ * Host clock estimate and link round-trip statistics.
+ *
+ * The host pings the MCU with its own time and the round trip it measured
+ * for the previous ping. That round trip turns the previous ping into an
+ * offset sample, assuming the link delay is half of it. A phase and
+ * frequency loop turns the samples into an offset and a drift. Once synced,
+ * telemetry and log packets carry host time (src/dshot/telemetry_usb.h,
+ * src/log.h).
+ *
+ * Ping packet (host to MCU, 11 bytes, little-endian):
+ *   [0xC7] [seq] [host_time_us:4] [previous_rtt_us:4] [xor_checksum]
+ * seq counts up by one per ping. previous_rtt_us is the round trip of ping
+ * seq - 1, or 0 when the host has none; other pings give no sample.
+ *
+ * Pong packet (MCU to host, 15 bytes, little-endian):
+ *   [0xE7] [seq] [host_time_us:4] [mcu_rx_us:4] [mcu_tx_us:4] [xor_checksum]
+ * host_time_us is echoed. The round trip is the host's receive time minus
+ * host_time_us, less the time the MCU held the ping (mcu_tx_us - mcu_rx_us).
+ * mcu_tx_us is taken when the pong is queued, so it leaves in the same
+ * main-loop iteration.
+ *
+ * All times are the low 32 bits of a microsecond clock and wrap.
+ */
+
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <pico/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CLOCK_SYNC_PING_START_BYTE 0xC7
+#define CLOCK_SYNC_PING_PACKET_SIZE 11
+#define CLOCK_SYNC_PONG_START_BYTE 0xE7
+#define CLOCK_SYNC_PONG_PACKET_SIZE 15
+
+/* Samples whose round trip exceeds the shortest seen by more than this are not used */
+#define CLOCK_SYNC_RTT_SLACK_US 2000
+/* Samples off by more than STEP_US are skipped; STEP_SAMPLES of them in a row mean the host
+ * clock stepped and restart the estimate */
+#define CLOCK_SYNC_STEP_US 10000
+#define CLOCK_SYNC_STEP_SAMPLES 2
+#define CLOCK_SYNC_MAX_DRIFT_PPB 500000
+
+typedef struct {
+    uint32_t pings;
+    uint32_t samples_used;
+    uint32_t rtt_last_us;
+    uint32_t rtt_min_us;
+    uint32_t rtt_max_us;
+    uint32_t rtt_mean_us; /* Moving average over about the last 8 round trips */
+    int32_t offset_error_us; /* Last sample against the estimate */
+    int32_t drift_ppb;       /* Host clock rate relative to the MCU's */
+} clock_sync_stats_t;
+
+/* Update the estimate from a ping received at rx_time and queue the pong; false if malformed */
+bool clock_sync_handle_ping(const uint8_t *packet, absolute_time_t rx_time);
+/* Host time at an MCU time, false until the first usable ping */
+bool clock_sync_host_time_us(uint32_t mcu_us, uint32_t *host_us);
+bool clock_sync_synced(void);
+
+const clock_sync_stats_t *clock_sync_stats(void);
+/* Forget the estimate and clear the stats */
+void clock_sync_reset(void);
+
+#endif
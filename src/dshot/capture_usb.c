@@ -0,0 +1,147 @@
+#include "capture_usb.h"
+#include "../link/tx.h"
+#include "../usb_comm.h"
+#include "dshot.h"
+#include "telemetry_usb.h"
+#include <hardware/sync.h>
+#include <pico/time.h>
+#include <pico/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CAPTURE_RING_CAPACITY 16
+
+typedef struct {
+    uint8_t motor_id;
+    uint8_t reason;
+    uint8_t format;
+    uint8_t word_count;
+    uint32_t timestamp_us;
+    uint32_t words[DSHOT_CAPTURE_MAX_WORDS];
+} capture_ring_entry_t;
+
+static capture_ring_entry_t capture_ring[CAPTURE_RING_CAPACITY];
+static uint8_t capture_ring_head = 0;
+static uint8_t capture_ring_tail = 0;
+static enum dshot_capture_usb_mode capture_mode = CAPTURE_USB_MODE_OFF;
+static uint32_t capture_good_frames = 0;
+static uint32_t capture_dropped = 0;
+static uint32_t capture_sent_in_window = 0;
+static absolute_time_t capture_window_start;
+
+static uint8_t capture_ring_advance(uint8_t index) {
+    return (uint8_t)((index + 1) % CAPTURE_RING_CAPACITY);
+}
+
+void dshot_capture_usb_init(void) {
+    capture_ring_head = 0;
+    capture_ring_tail = 0;
+    capture_good_frames = 0;
+    capture_dropped = 0;
+    capture_sent_in_window = 0;
+    capture_window_start = get_absolute_time();
+}
+
+void dshot_capture_usb_set_mode(enum dshot_capture_usb_mode mode) {
+    capture_mode = mode;
+}
+
+enum dshot_capture_usb_mode dshot_capture_usb_get_mode(void) {
+    return capture_mode;
+}
+
+uint32_t dshot_capture_usb_dropped(void) {
+    return capture_dropped;
+}
+
+static bool capture_rate_limit_check(void) {
+    absolute_time_t now = get_absolute_time();
+    if (absolute_time_diff_us(capture_window_start, now) >= 1000000) {
+        capture_window_start = now;
+        capture_sent_in_window = 0;
+    }
+    if (capture_sent_in_window >= CAPTURE_MAX_PER_SECOND) {
+        return false;
+    }
+    capture_sent_in_window++;
+    return true;
+}
+
+static size_t capture_encode_packet(const capture_ring_entry_t *entry, uint8_t *packet) {
+    size_t len = 0;
+
+    packet[len++] = CAPTURE_START_BYTE;
+    packet[len++] = entry->motor_id;
+    packet[len++] = entry->reason;
+    packet[len++] = entry->format;
+    memcpy(&packet[len], &entry->timestamp_us, sizeof(entry->timestamp_us));
+    len += sizeof(entry->timestamp_us);
+    packet[len++] = entry->word_count;
+    memcpy(&packet[len], entry->words, entry->word_count * sizeof(entry->words[0]));
+    len += entry->word_count * sizeof(entry->words[0]);
+    packet[len] = usb_calculate_checksum(packet, len);
+    return len + 1;
+}
+
+void dshot_capture_usb_flush(void) {
+    while (capture_ring_tail != capture_ring_head) {
+        /* Captures wait in the ring while the link is full */
+        if (link_tx_room(LINK_STREAM_CAPTURE) < CAPTURE_PACKET_MAX_SIZE ||
+            !capture_rate_limit_check()) {
+            break;
+        }
+
+        uint8_t packet[CAPTURE_PACKET_MAX_SIZE];
+        uint32_t irq_state = save_and_disable_interrupts();
+        size_t len = capture_encode_packet(&capture_ring[capture_ring_tail], packet);
+        capture_ring_tail = capture_ring_advance(capture_ring_tail);
+        restore_interrupts(irq_state);
+
+        link_tx_send(LINK_STREAM_CAPTURE, packet, len);
+    }
+}
+
+static bool capture_should_record(enum dshot_capture_reason reason) {
+    if (capture_mode == CAPTURE_USB_MODE_OFF) {
+        return false;
+    }
+    if (reason != DSHOT_CAPTURE_REASON_OK) {
+        return true;
+    }
+    if (capture_mode != CAPTURE_USB_MODE_FAILED_AND_SAMPLED) {
+        return false;
+    }
+    return (++capture_good_frames % CAPTURE_GOOD_SAMPLE_INTERVAL) == 0;
+}
+
+void dshot_capture_callback(void *context, int channel, enum dshot_capture_reason reason,
+                            enum dshot_rx_capture format, const uint32_t *words, int word_count) {
+    if (!capture_should_record(reason)) {
+        return;
+    }
+
+    dshot_telemetry_context_t *ctx = (dshot_telemetry_context_t *)context;
+    if (word_count > DSHOT_CAPTURE_MAX_WORDS) {
+        word_count = DSHOT_CAPTURE_MAX_WORDS;
+    }
+
+    uint32_t irq_state = save_and_disable_interrupts();
+    uint8_t next_head = capture_ring_advance(capture_ring_head);
+    if (next_head == capture_ring_tail) {
+        capture_ring_tail = capture_ring_advance(capture_ring_tail);
+        capture_dropped++;
+        link_tx_count_drops(LINK_STREAM_CAPTURE, 1);
+    }
+
+    capture_ring_entry_t *entry = &capture_ring[capture_ring_head];
+    entry->motor_id = ctx->controller_base_global_id + channel;
+    entry->reason = (uint8_t)reason;
+    entry->format = (uint8_t)format;
+    entry->word_count = (uint8_t)word_count;
+    entry->timestamp_us = (uint32_t)to_us_since_boot(get_absolute_time());
+    memcpy(entry->words, words, word_count * sizeof(words[0]));
+    capture_ring_head = next_head;
+    restore_interrupts(irq_state);
+}
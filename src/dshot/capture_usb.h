@@ -0,0 +1,37 @@
+/*
+ * Raw telemetry capture streaming for offline decoder tuning.
+ * Failed frames (and optionally a sample of good ones) are copied into a ring
+ * and drained to the host as rate-limited capture packets.
+ *
+ * Packet format (variable length, little-endian):
+ *   [0xA7] [motor_id] [reason] [format] [timestamp_us:4] [word_count]
+ *   [words:4 x word_count] [xor_checksum]
+ */
+
+#ifndef DSHOT_CAPTURE_USB_H
+#define DSHOT_CAPTURE_USB_H
+
+#include "dshot.h"
+#include <stdint.h>
+
+#define CAPTURE_START_BYTE 0xA7
+#define CAPTURE_HEADER_SIZE 9
+#define CAPTURE_PACKET_MAX_SIZE (CAPTURE_HEADER_SIZE + (DSHOT_CAPTURE_MAX_WORDS * 4) + 1)
+#define CAPTURE_MAX_PER_SECOND 50
+#define CAPTURE_GOOD_SAMPLE_INTERVAL 500
+
+enum dshot_capture_usb_mode {
+    CAPTURE_USB_MODE_OFF = 0,
+    CAPTURE_USB_MODE_FAILED = 1,
+    CAPTURE_USB_MODE_FAILED_AND_SAMPLED = 2,
+};
+
+void dshot_capture_usb_init(void);
+void dshot_capture_usb_set_mode(enum dshot_capture_usb_mode mode);
+enum dshot_capture_usb_mode dshot_capture_usb_get_mode(void);
+uint32_t dshot_capture_usb_dropped(void);
+void dshot_capture_usb_flush(void);
+void dshot_capture_callback(void *context, int channel, enum dshot_capture_reason reason,
+                            enum dshot_rx_capture format, const uint32_t *words, int word_count);
+
+#endif
@@ -23,8 +23,13 @@
 #include <stdint.h>
 #include <string.h>
 
-static bool dshot_pio_prog_loaded[2] = {false, false};
-static uint dshot_pio_prog_offset[2] = {0, 0};
+static bool dshot_pio_prog_loaded[2][DSHOT_RX_CAPTURE_COUNT];
+static uint dshot_pio_prog_offset[2][DSHOT_RX_CAPTURE_COUNT];
+
+static const struct pio_program *const dshot_pio_programs[DSHOT_RX_CAPTURE_COUNT] = {
+    [DSHOT_RX_CAPTURE_OVERSAMPLE] = &pio_dshot_program,
+    [DSHOT_RX_CAPTURE_EDGE] = &pio_dshot_edge_program,
+};
 
 static uint pio_index(PIO pio) {
     return pio == pio0 ? 0 : 1;
@@ -73,6 +78,19 @@ static const enum dshot_telemetry_type edt_type_lookup[8] = {
 #define RX_BIT_RATIO_NUM 5
 #define RX_BIT_RATIO_DEN 4
 
+/*
+ * Edge capture (pio_dshot_edge): one byte per line level, counted down from
+ * EDGE_CAPTURE_RUN_LIMIT at 2 PIO cycles per count. The limit (500 cycles,
+ * 5 RX bits) bounds both the wait for the response and any single run.
+ * Runs are expressed in counts, so the decoder thresholds are simply scaled.
+ */
+#define PIO_CYCLES_PER_EDGE_COUNT 2
+#define EDGE_CAPTURE_RUN_LIMIT 250
+#define EDGE_CAPTURE_RUN_OVERHEAD 1 /* 3 cycles of level-change handling per run */
+#define EDGE_CAPTURE_END_MARKER 0xFF
+#define EDGE_CAPTURE_MAX_WORDS DSHOT_CAPTURE_MAX_WORDS
+#define CAPTURE_MAX_WORDS DSHOT_CAPTURE_MAX_WORDS
+
 enum decode_result {
     DECODE_OK = 0,
     DECODE_FAIL_EDGE_COUNT,
@@ -85,29 +103,42 @@ enum decode_result {
  * Samples per RX bit = (PIO_CYCLES_PER_TX_BIT * RX_BIT_RATIO_DEN)
  *                      / (RX_BIT_RATIO_NUM * PIO_CYCLES_PER_SAMPLE)
  *                    = (125 * 4) / (5 * 18) = 500 / 90 = 5.556...
- * Default bits_per_sample = 1 / 5.556 = 0.18
+ * Held in Q8.8 fixed point (1422 = 5.555) so calibration never touches soft-float.
+ * Edge captures count 2 PIO cycles per unit instead: 50 units per bit.
  */
-#define DEFAULT_BITS_PER_SAMPLE 0.18f
+#define SAMPLES_PER_BIT_FRAC_BITS 8
+#define DEFAULT_SAMPLES_PER_BIT_Q8(cycles_per_sample)                                              \
+    (((PIO_CYCLES_PER_TX_BIT * RX_BIT_RATIO_DEN) << SAMPLES_PER_BIT_FRAC_BITS) /                   \
+     (RX_BIT_RATIO_NUM * (cycles_per_sample)))
 
+/*
+ * Bit period tracking. The first CALIBRATION_FRAMES measurements are averaged
+ * to acquire the ESC's bit period, after which every decoded frame nudges the
+ * estimate by 1/2^TRACKING_SHIFT of its error (a first-order tracking loop).
+ * Measurements more than 25% away from the estimate are discarded, and frames
+ * spanning fewer than TRACKING_MIN_BITS bits are too coarse to be useful.
+ */
 #define CALIBRATION_FRAMES 32
-#define ZERO_RPM_EDGES 15
-#define ZERO_RPM_BIT_SPAN 18
-#define ZERO_RPM_VALUE 0xFFF0
-
-static uint8_t length_transitions[4];
-static bool calibration_complete;
-static uint32_t calibration_total_span;
-static int calibration_frame_count;
-
-static void set_length_transitions(float bits_per_sample, bool strict);
-
-static void ensure_decoder_initialized(void) {
-    static bool initialized;
-
-    if (!initialized) {
-        set_length_transitions(DEFAULT_BITS_PER_SAMPLE, false);
-        initialized = true;
-    }
+#define TRACKING_SHIFT 4
+#define TRACKING_MIN_BITS 8
+#define GCR_FRAME_BITS 21
+
+static void set_length_transitions(struct dshot_rx_calibration *calibration,
+                                   uint16_t samples_per_bit_q8, bool strict);
+
+static void reset_rx_calibration(struct dshot_rx_calibration *calibration,
+                                 enum dshot_rx_capture capture) {
+    uint16_t samples_per_bit_q8 = capture == DSHOT_RX_CAPTURE_EDGE
+                                      ? DEFAULT_SAMPLES_PER_BIT_Q8(PIO_CYCLES_PER_EDGE_COUNT)
+                                      : DEFAULT_SAMPLES_PER_BIT_Q8(PIO_CYCLES_PER_SAMPLE);
+
+    calibration->complete = false;
+    calibration->total_span = 0;
+    calibration->total_bits = 0;
+    calibration->tracking_accumulator = 0;
+    calibration->frame_count = 0;
+    calibration->glitch_filter = DSHOT_GLITCH_FILTER;
+    set_length_transitions(calibration, samples_per_bit_q8, false);
 }
 
 static int collect_edge_diffs(const uint32_t *buffer, uint8_t *edge_diffs) {
@@ -144,20 +175,88 @@ static int collect_edge_diffs(const uint32_t *buffer, uint8_t *edge_diffs) {
     return edge_count;
 }
 
-static int decode_run_length(uint8_t diff) {
-    if (diff < length_transitions[1]) {
+/*
+ * Unpack an edge capture into run lengths. Bytes are consumed oldest first
+ * (most significant byte of each word). The first run is the idle line before
+ * the response and is dropped. The final word carries the end marker in its
+ * low byte and zero padding above the runs it holds; a genuine zero byte would
+ * be a run at the limit, which can never decode as a valid frame anyway.
+ */
+static int collect_edge_runs(const uint32_t *buffer, int word_count, uint8_t *edge_diffs) {
+    int edge_count = 0;
+    bool idle_run = true;
+
+    for (int w = 0; w < word_count; ++w) {
+        uint32_t word = buffer[w];
+        bool final_word = (word & 0xFF) == EDGE_CAPTURE_END_MARKER;
+        int shift = 24;
+
+        if (final_word) {
+            while (shift > 0 && ((word >> shift) & 0xFF) == 0) {
+                shift -= 8;
+            }
+        }
+
+        for (; shift >= (final_word ? 8 : 0); shift -= 8) {
+            uint8_t remaining = (word >> shift) & 0xFF;
+            if (idle_run) {
+                idle_run = false;
+                continue;
+            }
+            if (edge_count == MAX_EDGES) {
+                return edge_count;
+            }
+            uint8_t count = remaining <= EDGE_CAPTURE_RUN_LIMIT
+                                ? EDGE_CAPTURE_RUN_LIMIT - remaining
+                                : 0;
+            edge_diffs[edge_count++] = count + EDGE_CAPTURE_RUN_OVERHEAD;
+        }
+
+        if (final_word) {
+            break;
+        }
+    }
+
+    return edge_count;
+}
+
+/*
+ * Merge runs shorter than the glitch filter into their neighbours: a spike of
+ * the opposite level inside a run is absorbed, rejoining the run around it.
+ */
+static int filter_glitch_runs(uint8_t *edge_diffs, int edge_count, uint8_t min_run) {
+    if (min_run == 0) {
+        return edge_count;
+    }
+
+    int out = 0;
+    for (int i = 0; i < edge_count; ++i) {
+        if (out > 0 && edge_diffs[i] < min_run && i + 1 < edge_count) {
+            uint32_t merged = (uint32_t)edge_diffs[out - 1] + edge_diffs[i] + edge_diffs[i + 1];
+            edge_diffs[out - 1] = merged > UINT8_MAX ? UINT8_MAX : merged;
+            i++;
+            continue;
+        }
+        edge_diffs[out++] = edge_diffs[i];
+    }
+    return out;
+}
+
+static int decode_run_length(const struct dshot_rx_calibration *calibration, uint8_t diff) {
+    if (diff < calibration->length_transitions[1]) {
         return 1;
     }
-    if (diff < length_transitions[2]) {
+    if (diff < calibration->length_transitions[2]) {
         return 2;
     }
-    if (diff < length_transitions[3]) {
+    if (diff < calibration->length_transitions[3]) {
         return 3;
     }
     return 0;
 }
 
-static enum decode_result build_gcr_word(const uint8_t *edge_diffs, int edge_count,
+static enum decode_result build_gcr_word(const struct dshot_rx_calibration *calibration,
+                                         const uint8_t *edge_diffs, int edge_count,
                                          uint32_t *gcr20_out) {
     if (edge_count < 2 || edge_count > 21) {
         return DECODE_FAIL_EDGE_COUNT;
@@ -167,7 +266,7 @@ static enum decode_result build_gcr_word(const uint8_t *edge_diffs, int edge_cou
     uint32_t core_bits = 0;
 
     for (int i = 0; i < edge_count; ++i) {
-        int len = decode_run_length(edge_diffs[i]);
+        int len = decode_run_length(calibration, edge_diffs[i]);
         if (len == 0) {
             return DECODE_FAIL_GCR;
         }
@@ -215,74 +314,124 @@ static enum decode_result decode_gcr_word(uint32_t gcr20, uint32_t *out_value) {
     return DECODE_OK;
 }
 
-static void update_zero_rpm_calibration(const uint8_t *edge_diffs, int edge_count, uint32_t value) {
-    if (calibration_complete || value != ZERO_RPM_VALUE || edge_count != ZERO_RPM_EDGES) {
-        return;
-    }
-
+/*
+ * Measure samples per bit over a successfully decoded frame. The first run is
+ * skipped since it is shortened by the PIO's edge detection latency.
+ */
+static bool measure_bit_period(const struct dshot_rx_calibration *calibration,
+                               const uint8_t *edge_diffs, int edge_count, uint32_t *span_out,
+                               uint32_t *bits_out) {
+    uint32_t total_bits = decode_run_length(calibration, edge_diffs[0]);
     uint32_t span = 0;
-    for (int i = 1; i < ZERO_RPM_EDGES; ++i) {
+    uint32_t bits = 0;
+
+    for (int i = 1; i < edge_count; ++i) {
+        uint32_t len = decode_run_length(calibration, edge_diffs[i]);
+        total_bits += len;
+        if (len == 0 || total_bits > GCR_FRAME_BITS) {
+            break;
+        }
         span += edge_diffs[i];
+        bits += len;
     }
 
-    if (span >= 70 && span <= 125) {
-        calibration_total_span += span;
-        calibration_frame_count++;
+    if (bits < TRACKING_MIN_BITS) {
+        return false;
     }
 
-    if (calibration_frame_count == CALIBRATION_FRAMES) {
-        float avg_span = (float)calibration_total_span / CALIBRATION_FRAMES;
-        float samples_per_bit = avg_span / ZERO_RPM_BIT_SPAN;
+    *span_out = span;
+    *bits_out = bits;
+    return true;
+}
+
+static void update_bit_period_tracking(struct dshot_rx_calibration *calibration,
+                                       const uint8_t *edge_diffs, int edge_count) {
+    uint32_t span;
+    uint32_t bits;
+
+    if (!measure_bit_period(calibration, edge_diffs, edge_count, &span, &bits)) {
+        return;
+    }
+
+    uint32_t estimate = calibration->samples_per_bit_q8;
+    uint32_t measured = (span << SAMPLES_PER_BIT_FRAC_BITS) / bits;
+    if (measured * 4 < estimate * 3 || measured * 4 > estimate * 5) {
+        return;
+    }
+
+    if (!calibration->complete) {
+        calibration->total_span += span;
+        calibration->total_bits += bits;
+        calibration->frame_count++;
+        if (calibration->frame_count == CALIBRATION_FRAMES) {
+            measured = (calibration->total_span << SAMPLES_PER_BIT_FRAC_BITS) /
+                       calibration->total_bits;
+            set_length_transitions(calibration, (uint16_t)measured, true);
+            calibration->tracking_accumulator = measured << TRACKING_SHIFT;
+            calibration->complete = true;
+        }
+        return;
+    }
 
-        set_length_transitions(1.0f / samples_per_bit, true);
-        calibration_complete = true;
+    /* accumulator holds estimate << TRACKING_SHIFT so small errors are not lost */
+    calibration->tracking_accumulator +=
+        measured - (calibration->tracking_accumulator >> TRACKING_SHIFT);
+    uint32_t updated = (calibration->tracking_accumulator + (1U << (TRACKING_SHIFT - 1))) >>
+                       TRACKING_SHIFT;
+    if (updated != estimate) {
+        set_length_transitions(calibration, (uint16_t)updated, true);
     }
 }
 
-void dshot_controller_reset_calibration(void) {
-    calibration_complete = false;
-    calibration_total_span = 0;
-    calibration_frame_count = 0;
-    set_length_transitions(DEFAULT_BITS_PER_SAMPLE, false);
+void dshot_controller_reset_calibration(struct dshot_controller *controller) {
+    for (int i = 0; i < controller->num_channels; i++) {
+        reset_rx_calibration(&controller->motor[i].calibration, controller->rx_capture);
+    }
 }
 
-static void set_length_transitions(float bits_per_sample, bool strict) {
-    int length = 0;
-    float bits = 0.5f;
-    int samples = 0;
-    while (length < 4) {
-        bits += bits_per_sample;
-        samples++;
-        if ((int)bits >= length + 1) {
-            length_transitions[length] = samples;
-            length++;
-        }
+/*
+ * A run of N samples decodes to the first bit count L where
+ * 0.5 + N / samples_per_bit >= L + 1, i.e. N >= (L + 0.5) * samples_per_bit.
+ * Each threshold is that product rounded up, computed in Q8.8 integer math.
+ */
+static void set_length_transitions(struct dshot_rx_calibration *calibration,
+                                   uint16_t samples_per_bit_q8, bool strict) {
+    const uint32_t half_scale = 1U << (SAMPLES_PER_BIT_FRAC_BITS + 1);
+
+    calibration->samples_per_bit_q8 = samples_per_bit_q8;
+    for (uint32_t length = 0; length < 4; ++length) {
+        uint32_t threshold = ((2 * length + 1) * samples_per_bit_q8 + half_scale - 1) / half_scale;
+        calibration->length_transitions[length] = threshold > UINT8_MAX ? UINT8_MAX : threshold;
     }
-    if (!strict) {
-        length_transitions[3] += 2;
+    if (!strict && calibration->length_transitions[3] <= UINT8_MAX - 2) {
+        calibration->length_transitions[3] += 2;
     }
 }
 
 /*
- * Decode 4 words of oversampled telemetry into a 16-bit GCR value.
+ * Decode captured telemetry into a 16-bit GCR value.
  * Algorithm (from Betaflight):
  *   1. Scan 128-bit sample stream for edge transitions using __builtin_clz
+ *      (edge captures already hold run lengths and are only unpacked)
  *   2. Record run lengths between edges
  *   3. Convert run lengths to GCR bits via transition table
  *   4. Reconstruct 21-bit GCR pattern (20 data + 1 start)
  *   5. Decode 4 x 5-bit GCR symbols to nibbles, verify checksum
  * Returns 16-bit value (12-bit data + 4-bit CRC) or DSHOT_TELEMETRY_INVALID.
  */
-static enum decode_result decode_oversampled_telemetry(const uint32_t *buffer,
+static enum decode_result decode_oversampled_telemetry(struct dshot_rx_calibration *calibration,
+                                                       enum dshot_rx_capture capture,
+                                                       const uint32_t *buffer, int word_count,
                                                        uint32_t *out_value) {
     uint32_t gcr20;
     uint8_t edge_diffs[MAX_EDGES];
     enum decode_result result;
 
-    ensure_decoder_initialized();
-
-    int edge_count = collect_edge_diffs(buffer, edge_diffs);
-    result = build_gcr_word(edge_diffs, edge_count, &gcr20);
+    int edge_count = capture == DSHOT_RX_CAPTURE_EDGE
+                         ? collect_edge_runs(buffer, word_count, edge_diffs)
+                         : collect_edge_diffs(buffer, edge_diffs);
+    edge_count = filter_glitch_runs(edge_diffs, edge_count, calibration->glitch_filter);
+    result = build_gcr_word(calibration, edge_diffs, edge_count, &gcr20);
     if (result != DECODE_OK) {
         return result;
     }
@@ -292,7 +441,7 @@ static enum decode_result decode_oversampled_telemetry(const uint32_t *buffer,
         return result;
     }
 
-    update_zero_rpm_calibration(edge_diffs, edge_count, *out_value);
+    update_bit_period_tracking(calibration, edge_diffs, edge_count);
     return DECODE_OK;
 }
 
@@ -309,9 +458,10 @@ static void dshot_sm_config_set_pin(struct dshot_controller *controller, int pin
 }
 
 void dshot_controller_init(struct dshot_controller *controller, uint16_t dshot_speed, PIO pio,
-                           uint8_t sm, int pin, int channels) {
+                           uint8_t sm, int pin, int channels, enum dshot_rx_capture rx_capture) {
     memset(controller, 0, sizeof(*controller));
     controller->pio = pio;
+    controller->rx_capture = rx_capture;
     controller->sm = sm;
     controller->num_channels = channels;
     controller->speed = dshot_speed;
@@ -322,14 +472,18 @@ void dshot_controller_init(struct dshot_controller *controller, uint16_t dshot_s
         controller->motor[i].last_throttle_value = UINT16_MAX;
         dshot_throttle(controller, i, 0);
     }
+    dshot_controller_reset_calibration(controller);
 
     uint pi = pio_index(pio);
-    if (!dshot_pio_prog_loaded[pi]) {
-        dshot_pio_prog_offset[pi] = pio_add_program(pio, &pio_dshot_program);
-        dshot_pio_prog_loaded[pi] = true;
+    if (!dshot_pio_prog_loaded[pi][rx_capture]) {
+        dshot_pio_prog_offset[pi][rx_capture] = pio_add_program(pio, dshot_pio_programs[rx_capture]);
+        dshot_pio_prog_loaded[pi][rx_capture] = true;
     }
 
-    controller->c = pio_dshot_program_get_default_config(dshot_pio_prog_offset[pi]);
+    uint offset = dshot_pio_prog_offset[pi][rx_capture];
+    controller->c = rx_capture == DSHOT_RX_CAPTURE_EDGE
+                        ? pio_dshot_edge_program_get_default_config(offset)
+                        : pio_dshot_program_get_default_config(offset);
 
     sm_config_set_out_shift(&controller->c, false, false, 32);
     sm_config_set_in_shift(&controller->c, false, true, 32);
@@ -339,7 +493,7 @@ void dshot_controller_init(struct dshot_controller *controller, uint16_t dshot_s
     float clkdiv = (float)clock_get_hz(clk_sys) / (1000.0F * (float)dshot_speed * 125.0F);
     sm_config_set_clkdiv(&controller->c, clkdiv);
 
-    pio_sm_init(pio, sm, dshot_pio_prog_offset[pi], &controller->c);
+    pio_sm_init(pio, sm, offset, &controller->c);
     pio_sm_set_enabled(pio, sm, true);
 }
 
@@ -370,6 +524,12 @@ void dshot_register_telemetry_cb(struct dshot_controller *controller,
     controller->telemetry_cb_context = context;
 }
 
+void dshot_register_capture_cb(struct dshot_controller *controller,
+                               dshot_capture_callback_t capture_cb, void *context) {
+    controller->capture_cb = capture_cb;
+    controller->capture_cb_context = context;
+}
+
 /*
  * Decode eRPM from the 12-bit telemetry value (format: eeem mmmm mmmm).
  * Returns eRPM / 100 (each LSB = 100 eRPM), 0 for motor stopped,
@@ -452,38 +612,65 @@ static void dshot_update_telemetry_quality(struct dshot_telemetry_quality *quali
     }
 }
 
+static void dshot_report_capture(struct dshot_controller *controller,
+                                 enum dshot_capture_reason reason, const uint32_t *buffer,
+                                 int word_count) {
+    if (controller->capture_cb) {
+        controller->capture_cb(controller->capture_cb_context, controller->channel, reason,
+                               (enum dshot_rx_capture)controller->rx_capture, buffer, word_count);
+    }
+}
+
+/* A capture with no line activity: all-low samples, or only the idle-run end marker */
+static bool capture_is_silent(enum dshot_rx_capture capture, const uint32_t *buffer) {
+    if (capture == DSHOT_RX_CAPTURE_EDGE) {
+        return buffer[0] == EDGE_CAPTURE_END_MARKER;
+    }
+    return buffer[0] == 0 && buffer[1] == 0 && buffer[2] == 0 && buffer[3] == 0;
+}
+
 /*
- * Process oversampled telemetry received from PIO.
- * Decodes 4 words of oversampled data via edge detection → run-length → GCR,
+ * Process captured telemetry received from PIO.
+ * Decodes the capture via edge detection → run-length → GCR,
  * then extracts telemetry type/value and updates motor state.
  */
-static void dshot_receive_oversampled(struct dshot_controller *controller, const uint32_t *buffer) {
+static void dshot_receive_oversampled(struct dshot_controller *controller, const uint32_t *buffer,
+                                      int word_count) {
     struct dshot_motor *motor = &controller->motor[controller->channel];
     uint32_t now_ms = to_ms_since_boot(get_absolute_time());
 
-    if (buffer[0] == 0 && buffer[1] == 0 && buffer[2] == 0 && buffer[3] == 0) {
+    if (capture_is_silent(controller->rx_capture, buffer)) {
         motor->stats.rx_timeout++;
         dshot_update_telemetry_quality(&motor->quality, false, now_ms);
         return;
     }
 
     uint32_t frame;
-    enum decode_result result = decode_oversampled_telemetry(buffer, &frame);
+    enum decode_result result = decode_oversampled_telemetry(
+        &motor->calibration, controller->rx_capture, buffer, word_count, &frame);
     if (result != DECODE_OK) {
+        enum dshot_capture_reason reason;
         switch (result) {
         case DECODE_FAIL_EDGE_COUNT:
+            motor->stats.rx_bad_gcr++;
+            reason = DSHOT_CAPTURE_REASON_EDGE_COUNT;
+            break;
         case DECODE_FAIL_BIT_COUNT:
+            motor->stats.rx_bad_gcr++;
+            reason = DSHOT_CAPTURE_REASON_BIT_COUNT;
+            break;
         case DECODE_FAIL_GCR:
             motor->stats.rx_bad_gcr++;
+            reason = DSHOT_CAPTURE_REASON_BAD_GCR;
             break;
         case DECODE_FAIL_CRC:
-            motor->stats.rx_bad_crc++;
-            break;
         default:
             motor->stats.rx_bad_crc++;
+            reason = DSHOT_CAPTURE_REASON_BAD_CRC;
             break;
         }
         dshot_update_telemetry_quality(&motor->quality, false, now_ms);
+        dshot_report_capture(controller, reason, buffer, word_count);
         return;
     }
 
@@ -496,12 +683,14 @@ static void dshot_receive_oversampled(struct dshot_controller *controller, const
     if (decoded == DSHOT_TELEMETRY_INVALID) {
         motor->stats.rx_bad_type++;
         dshot_update_telemetry_quality(&motor->quality, false, now_ms);
+        dshot_report_capture(controller, DSHOT_CAPTURE_REASON_BAD_TYPE, buffer, word_count);
         return;
     }
 
     motor->stats.rx_frames++;
     dshot_update_telemetry_data(motor, type, decoded);
     dshot_update_telemetry_quality(&motor->quality, true, now_ms);
+    dshot_report_capture(controller, DSHOT_CAPTURE_REASON_OK, buffer, word_count);
 
     if (controller->telemetry_cb) {
         controller->telemetry_cb(controller->telemetry_cb_context, controller->channel, type,
@@ -509,17 +698,26 @@ static void dshot_receive_oversampled(struct dshot_controller *controller, const
     }
 }
 
+static uint dshot_prog_offset(const struct dshot_controller *controller) {
+    return dshot_pio_prog_offset[pio_index(controller->pio)][controller->rx_capture];
+}
+
 static void dshot_cycle_channel(struct dshot_controller *controller) {
     pio_sm_set_enabled(controller->pio, controller->sm, false);
 
     controller->channel = (controller->channel + 1) % controller->num_channels;
     dshot_sm_config_set_pin(controller, controller->pin + controller->channel);
-    pio_sm_init(controller->pio, controller->sm, dshot_pio_prog_offset[pio_index(controller->pio)],
-                &controller->c);
+    pio_sm_init(controller->pio, controller->sm, dshot_prog_offset(controller), &controller->c);
 
     pio_sm_set_enabled(controller->pio, controller->sm, true);
 }
 
+static void dshot_drain_rx_fifo(struct dshot_controller *controller) {
+    while (!pio_sm_is_rx_fifo_empty(controller->pio, controller->sm)) {
+        (void)pio_sm_get(controller->pio, controller->sm);
+    }
+}
+
 void dshot_loop_async_start(struct dshot_controller *controller) {
     if (controller->num_channels > 1) {
         dshot_cycle_channel(controller);
@@ -527,42 +725,61 @@ void dshot_loop_async_start(struct dshot_controller *controller) {
 
     struct dshot_motor *motor = &controller->motor[controller->channel];
     if (pio_sm_is_tx_fifo_empty(controller->pio, controller->sm)) {
+        /* The edge program can leave an empty word after its end marker (dshot.pio), and with
+         * one channel no pio_sm_init() clears it before the next frame */
+        if (controller->rx_capture == DSHOT_RX_CAPTURE_EDGE) {
+            dshot_drain_rx_fifo(controller);
+        }
         motor->stats.tx_frames++;
         pio_sm_put(controller->pio, controller->sm, ~(uint32_t)motor->frame << 16);
         uint32_t cycles = (25 * controller->speed * 125) / 1000;
         pio_sm_put(controller->pio, controller->sm, cycles);
+        if (controller->rx_capture == DSHOT_RX_CAPTURE_EDGE) {
+            pio_sm_put(controller->pio, controller->sm, EDGE_CAPTURE_RUN_LIMIT);
+        }
     }
 }
 
 #define RX_READ_TIMEOUT_US 500
 
-static bool dshot_read_rx_words(struct dshot_controller *controller, uint32_t *buffer) {
+/*
+ * Read one capture from the RX FIFO. Oversampled captures are a fixed
+ * 4 data words plus a completion word; edge captures end with the word
+ * carrying the end marker. Returns the number of data words, or 0 on timeout.
+ */
+static int dshot_read_rx_words(struct dshot_controller *controller, uint32_t *buffer) {
+    bool edge_capture = controller->rx_capture == DSHOT_RX_CAPTURE_EDGE;
+    int total_words = edge_capture ? EDGE_CAPTURE_MAX_WORDS : OVERSAMPLE_TOTAL_WORDS;
     absolute_time_t deadline = make_timeout_time_us(RX_READ_TIMEOUT_US);
-    for (int i = 0; i < OVERSAMPLE_TOTAL_WORDS; i++) {
+
+    for (int i = 0; i < total_words; i++) {
         while (pio_sm_is_rx_fifo_empty(controller->pio, controller->sm)) {
             if (absolute_time_diff_us(get_absolute_time(), deadline) <= 0) {
-                while (!pio_sm_is_rx_fifo_empty(controller->pio, controller->sm)) {
-                    (void)pio_sm_get(controller->pio, controller->sm);
-                }
-                return false;
+                dshot_drain_rx_fifo(controller);
+                return 0;
             }
         }
         uint32_t word = pio_sm_get(controller->pio, controller->sm);
-        if (i < OVERSAMPLE_WORDS) {
+        if (edge_capture) {
+            buffer[i] = word;
+            if ((word & 0xFF) == EDGE_CAPTURE_END_MARKER) {
+                return i + 1;
+            }
+        } else if (i < OVERSAMPLE_WORDS) {
             buffer[i] = word;
         }
     }
-    return true;
+    return edge_capture ? 0 : OVERSAMPLE_WORDS;
 }
 
 void dshot_loop_async_complete(struct dshot_controller *controller) {
-    uint32_t buffer[OVERSAMPLE_WORDS] = {0};
-    bool ok = dshot_read_rx_words(controller, buffer);
+    uint32_t buffer[CAPTURE_MAX_WORDS] = {0};
+    int word_count = dshot_read_rx_words(controller, buffer);
 
-    if (!ok) {
+    if (word_count == 0) {
         pio_sm_set_enabled(controller->pio, controller->sm, false);
-        pio_sm_init(controller->pio, controller->sm,
-                    dshot_pio_prog_offset[pio_index(controller->pio)], &controller->c);
+        pio_sm_init(controller->pio, controller->sm, dshot_prog_offset(controller),
+                    &controller->c);
         pio_sm_set_enabled(controller->pio, controller->sm, true);
 
         struct dshot_motor *motor = &controller->motor[controller->channel];
@@ -570,7 +787,7 @@ void dshot_loop_async_complete(struct dshot_controller *controller) {
         motor->stats.rx_timeout++;
         dshot_update_telemetry_quality(&motor->quality, false, now_ms);
     } else {
-        dshot_receive_oversampled(controller, buffer);
+        dshot_receive_oversampled(controller, buffer, word_count);
     }
 
     struct dshot_motor *motor = &controller->motor[controller->channel];
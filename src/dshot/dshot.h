@@ -86,6 +86,39 @@ enum dshot_commands {
     DSHOT_MAX_COMMAND = 48,
 };
 
+/*
+ * Telemetry capture format produced by the PIO program.
+ * OVERSAMPLE: 128 line samples at 18 PIO cycles each, edges found in C.
+ * EDGE: the PIO times each line level itself and pushes packed run lengths.
+ * All controllers sharing a PIO must use the same capture mode.
+ */
+/* Runs shorter than this many samples are merged into their neighbours; 0 turns the filter off */
+#ifndef DSHOT_GLITCH_FILTER
+#define DSHOT_GLITCH_FILTER 0
+#endif
+
+enum dshot_rx_capture {
+    DSHOT_RX_CAPTURE_OVERSAMPLE,
+    DSHOT_RX_CAPTURE_EDGE,
+    DSHOT_RX_CAPTURE_COUNT,
+};
+
+/*
+ * Raw capture diagnostics. When a capture callback is registered it receives
+ * the raw PIO words of every failed frame (and of good frames, tagged
+ * DSHOT_CAPTURE_REASON_OK, so the consumer can sample them).
+ */
+#define DSHOT_CAPTURE_MAX_WORDS 7
+
+enum dshot_capture_reason {
+    DSHOT_CAPTURE_REASON_OK = 0,
+    DSHOT_CAPTURE_REASON_EDGE_COUNT,
+    DSHOT_CAPTURE_REASON_BIT_COUNT,
+    DSHOT_CAPTURE_REASON_BAD_GCR,
+    DSHOT_CAPTURE_REASON_BAD_CRC,
+    DSHOT_CAPTURE_REASON_BAD_TYPE,
+};
+
 /* Telemetry quality: 600ms sliding window (6 x 100ms buckets) */
 #define DSHOT_TELEMETRY_QUALITY_BUCKET_MS 100
 #define DSHOT_TELEMETRY_QUALITY_BUCKET_COUNT 6
@@ -107,6 +140,23 @@ struct dshot_statistics {
     uint32_t rx_bad_type;
 };
 
+/*
+ * Run-length decoder calibration. Kept per motor so each ESC's clock skew is
+ * tracked independently. Thresholds are derived in Q8.8 fixed point.
+ * The bit period is acquired by averaging the first frames, then tracked
+ * continuously from every decoded frame to follow oscillator drift.
+ */
+struct dshot_rx_calibration {
+    uint16_t samples_per_bit_q8;   /* RX samples per telemetry bit (Q8.8) */
+    uint8_t length_transitions[4]; /* Run length (samples) at which a run becomes N+1 bits */
+    bool complete;                 /* Acquisition finished, strict thresholds and tracking */
+    uint8_t frame_count;           /* Frames accumulated during acquisition */
+    uint32_t total_span;           /* Sum of accumulated sample spans during acquisition */
+    uint32_t total_bits;           /* Sum of accumulated bit counts during acquisition */
+    uint32_t tracking_accumulator; /* Tracked samples_per_bit_q8, scaled up for the filter */
+    uint8_t glitch_filter;         /* DSHOT_GLITCH_FILTER unless a tool overrides it */
+};
+
 struct dshot_motor {
     uint16_t frame;               /* Current DShot frame to transmit */
     uint16_t last_throttle_frame; /* Saved throttle frame during command sequences */
@@ -118,11 +168,17 @@ struct dshot_motor {
     uint32_t max_temp;                                   /* Peak temperature observed */
     struct dshot_statistics stats;
     struct dshot_telemetry_quality quality;
+    struct dshot_rx_calibration calibration;
 };
 
 typedef void (*dshot_telemetry_callback_t)(void *context, int channel,
                                            enum dshot_telemetry_type type, uint32_t value);
 
+typedef void (*dshot_capture_callback_t)(void *context, int channel,
+                                         enum dshot_capture_reason reason,
+                                         enum dshot_rx_capture format, const uint32_t *words,
+                                         int word_count);
+
 struct dshot_controller {
     pio_sm_config c;
     PIO pio;
@@ -131,20 +187,27 @@ struct dshot_controller {
     uint8_t num_channels;
     uint8_t channel;        /* Currently active channel for PIO multiplexing */
     uint16_t speed;         /* DShot speed in kbit/s (e.g. 600) */
+    uint8_t rx_capture;     /* enum dshot_rx_capture */
     bool edt_always_decode; /* Attempt EDT decode before EDT handshake completes */
     struct dshot_motor motor[DSHOT_MAX_CHANNELS];
     absolute_time_t command_last_time;
 
     dshot_telemetry_callback_t telemetry_cb;
     void *telemetry_cb_context;
+
+    dshot_capture_callback_t capture_cb;
+    void *capture_cb_context;
 };
 
 void dshot_controller_init(struct dshot_controller *controller, uint16_t dshot_speed, PIO pio,
-                           uint8_t sm, int pin, int channels);
+                           uint8_t sm, int pin, int channels, enum dshot_rx_capture rx_capture);
 
 void dshot_register_telemetry_cb(struct dshot_controller *controller,
                                  dshot_telemetry_callback_t telemetry_cb, void *context);
 
+void dshot_register_capture_cb(struct dshot_controller *controller,
+                               dshot_capture_callback_t capture_cb, void *context);
+
 void dshot_command(struct dshot_controller *controller, uint16_t channel, uint16_t command,
                    uint8_t repeat_count);
 
@@ -158,7 +221,7 @@ void dshot_loop_async_complete(struct dshot_controller *controller);
 
 void dshot_mark_activity(struct dshot_controller *controller);
 void dshot_controller_deinit(struct dshot_controller *controller);
-void dshot_controller_reset_calibration(void);
+void dshot_controller_reset_calibration(struct dshot_controller *controller);
 
 /* Returns true if all motors have received at least one eRPM telemetry frame */
 bool dshot_is_telemetry_active(const struct dshot_controller *controller);
@@ -1,98 +1,217 @@
 #include "telemetry_usb.h"
+#include "../clock_sync.h"
+#include "../link/tx.h"
 #include "../usb_comm.h"
 #include "dshot.h"
 #include <hardware/sync.h>
+#include <pico/time.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
-#include <stdio.h>
 #include <string.h>
 
-#define TELEMETRY_QUEUE_CAPACITY 256
 #define TELEMETRY_FLUSH_BATCH_PACKETS 16
 #define TELEMETRY_BATCH_HEADER_SIZE 2
 #define TELEMETRY_BATCH_FOOTER_SIZE 1
+#define TELEMETRY_COALESCE_MOTORS 32
+#define TELEMETRY_COALESCE_TYPES (TELEMETRY_TYPE_SIGNAL_QUALITY + 1)
+#define TELEMETRY_NO_SLOT 0
 
 typedef struct {
     uint8_t motor_id;
     uint8_t type;
+    bool timed; /* Queued while synced, with its time in telemetry_queue_time_us */
     int32_t value;
 } telemetry_queue_entry_t;
 
 static telemetry_queue_entry_t telemetry_queue[TELEMETRY_QUEUE_CAPACITY];
+/* MCU time of each timed entry; apart so untimed entries stay small */
+static uint32_t telemetry_queue_time_us[TELEMETRY_QUEUE_CAPACITY];
 static uint16_t telemetry_queue_head = 0;
 static uint16_t telemetry_queue_tail = 0;
+/* Queue index + 1 of the newest queued value per motor and type, kept only while coalescing */
+static uint16_t telemetry_queued_slot[TELEMETRY_COALESCE_MOTORS][TELEMETRY_COALESCE_TYPES];
+static bool telemetry_coalescing = false;
+/* Clock sync state as of the last flush, so sends skip the time until the host pings */
+static bool telemetry_timed = false;
 
 static uint16_t telemetry_queue_advance(uint16_t index) {
     return (uint16_t)((index + 1) % TELEMETRY_QUEUE_CAPACITY);
 }
 
-void dshot_telemetry_usb_init(void) {
+static uint16_t *telemetry_slot(uint8_t motor_id, uint8_t type) {
+    if (motor_id >= TELEMETRY_COALESCE_MOTORS || type >= TELEMETRY_COALESCE_TYPES) {
+        return NULL;
+    }
+    return &telemetry_queued_slot[motor_id][type];
+}
+
+static void telemetry_queue_clear(void) {
     telemetry_queue_head = 0;
     telemetry_queue_tail = 0;
+    telemetry_coalescing = false;
+}
+
+static void telemetry_queue_pop(void) {
+    if (telemetry_coalescing) {
+        const telemetry_queue_entry_t *entry = &telemetry_queue[telemetry_queue_tail];
+        uint16_t *slot = telemetry_slot(entry->motor_id, entry->type);
+        if (slot != NULL && *slot == telemetry_queue_tail + 1) {
+            *slot = TELEMETRY_NO_SLOT;
+        }
+    }
+    telemetry_queue_tail = telemetry_queue_advance(telemetry_queue_tail);
+}
+
+/* Pick up policy changes once per flush; the slot table is rebuilt when coalescing starts */
+static void telemetry_follow_policy(void) {
+    bool coalescing = link_tx_policy() == LINK_TX_POLICY_COALESCE;
+    if (coalescing && !telemetry_coalescing) {
+        memset(telemetry_queued_slot, TELEMETRY_NO_SLOT, sizeof(telemetry_queued_slot));
+        for (uint16_t i = telemetry_queue_tail; i != telemetry_queue_head;
+             i = telemetry_queue_advance(i)) {
+            uint16_t *slot = telemetry_slot(telemetry_queue[i].motor_id, telemetry_queue[i].type);
+            if (slot != NULL) {
+                *slot = (uint16_t)(i + 1);
+            }
+        }
+    }
+    telemetry_coalescing = coalescing;
+}
+
+void dshot_telemetry_usb_init(void) {
+    telemetry_queue_clear();
+    telemetry_follow_policy();
 }
 
 void dshot_telemetry_usb_reset(void) {
-    telemetry_queue_head = 0;
-    telemetry_queue_tail = 0;
+    telemetry_queue_clear();
+    telemetry_follow_policy();
+}
+
+/* Fills in a timed batch's host time and each entry's time after it */
+static void stamp_batch(uint8_t *batch, const uint32_t *times_us) {
+    uint32_t earliest_us = times_us[0];
+    for (uint8_t i = 1; i < batch[1]; ++i) {
+        if ((int32_t)(times_us[i] - earliest_us) < 0) {
+            earliest_us = times_us[i];
+        }
+    }
+
+    uint32_t host_time_us = 0;
+    clock_sync_host_time_us(earliest_us, &host_time_us);
+    memcpy(&batch[2], &host_time_us, sizeof(host_time_us));
+    uint8_t *entry = &batch[TELEMETRY_TIMED_BATCH_HEADER_SIZE];
+    for (uint8_t i = 0; i < batch[1]; ++i, entry += TELEMETRY_TIMED_BATCH_ENTRY_SIZE) {
+        uint32_t after_us = times_us[i] - earliest_us;
+        uint16_t after = after_us > UINT16_MAX ? UINT16_MAX : (uint16_t)after_us;
+        memcpy(&entry[6], &after, sizeof(after));
+    }
 }
 
+/* Sends as many batches as the link has room for; the rest stays queued */
 void dshot_telemetry_usb_flush(void) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    telemetry_follow_policy();
+    restore_interrupts(irq_state);
+
     if (telemetry_queue_tail == telemetry_queue_head) {
         return;
     }
 
+    bool timed = clock_sync_synced();
+    telemetry_timed = timed;
+    /* Entries queued before the first timed flush count as queued now */
+    uint32_t now_us = timed ? (uint32_t)to_us_since_boot(get_absolute_time()) : 0;
+    size_t header_size = timed ? TELEMETRY_TIMED_BATCH_HEADER_SIZE : TELEMETRY_BATCH_HEADER_SIZE;
+    size_t entry_size = timed ? TELEMETRY_TIMED_BATCH_ENTRY_SIZE : TELEMETRY_BATCH_ENTRY_SIZE;
     while (true) {
-        uint8_t batch[TELEMETRY_BATCH_HEADER_SIZE +
-                      (TELEMETRY_FLUSH_BATCH_PACKETS * TELEMETRY_BATCH_ENTRY_SIZE) +
+        uint8_t batch[TELEMETRY_TIMED_BATCH_HEADER_SIZE +
+                      (TELEMETRY_FLUSH_BATCH_PACKETS * TELEMETRY_TIMED_BATCH_ENTRY_SIZE) +
                       TELEMETRY_BATCH_FOOTER_SIZE];
+        uint32_t times_us[TELEMETRY_FLUSH_BATCH_PACKETS];
         size_t batch_len = 0;
-        uint32_t irq_state = save_and_disable_interrupts();
+        size_t room = link_tx_room(LINK_STREAM_TELEMETRY);
+        if (room < header_size + entry_size + TELEMETRY_BATCH_FOOTER_SIZE) {
+            break;
+        }
+        size_t entries_room = room - header_size - TELEMETRY_BATCH_FOOTER_SIZE;
+        size_t max_entries = timed ? entries_room / TELEMETRY_TIMED_BATCH_ENTRY_SIZE
+                                   : entries_room / TELEMETRY_BATCH_ENTRY_SIZE;
+        if (max_entries > TELEMETRY_FLUSH_BATCH_PACKETS) {
+            max_entries = TELEMETRY_FLUSH_BATCH_PACKETS;
+        }
+
+        irq_state = save_and_disable_interrupts();
 
         if (telemetry_queue_tail == telemetry_queue_head) {
             restore_interrupts(irq_state);
             break;
         }
 
-        batch[0] = TELEMETRY_BATCH_START_BYTE;
+        batch[0] = timed ? TELEMETRY_TIMED_BATCH_START_BYTE : TELEMETRY_BATCH_START_BYTE;
         batch[1] = 0;
-        batch_len = TELEMETRY_BATCH_HEADER_SIZE;
+        batch_len = header_size;
 
-        while (telemetry_queue_tail != telemetry_queue_head &&
-               batch[1] < TELEMETRY_FLUSH_BATCH_PACKETS &&
-               batch_len + TELEMETRY_BATCH_ENTRY_SIZE + TELEMETRY_BATCH_FOOTER_SIZE <=
-                   sizeof(batch)) {
+        while (telemetry_queue_tail != telemetry_queue_head && batch[1] < max_entries) {
             const telemetry_queue_entry_t *entry = &telemetry_queue[telemetry_queue_tail];
             batch[batch_len] = entry->motor_id;
             batch[batch_len + 1] = entry->type;
             memcpy(&batch[batch_len + 2], &entry->value, sizeof(entry->value));
-            batch_len += TELEMETRY_BATCH_ENTRY_SIZE;
+            if (timed) {
+                times_us[batch[1]] =
+                    entry->timed ? telemetry_queue_time_us[telemetry_queue_tail] : now_us;
+            }
+            batch_len += entry_size;
             batch[1]++;
-            telemetry_queue_tail = telemetry_queue_advance(telemetry_queue_tail);
+            telemetry_queue_pop();
         }
 
         restore_interrupts(irq_state);
 
+        if (timed) {
+            stamp_batch(batch, times_us);
+        }
         batch[batch_len] = usb_calculate_checksum(batch, batch_len);
         batch_len += TELEMETRY_BATCH_FOOTER_SIZE;
-        fwrite(batch, 1, batch_len, stdout);
+        link_tx_send(LINK_STREAM_TELEMETRY, batch, batch_len);
     }
-
-    fflush(stdout);
 }
 
 void dshot_telemetry_usb_send(uint8_t motor_id, uint8_t type, int32_t value) {
     uint32_t irq_state = save_and_disable_interrupts();
-    uint16_t next_head = telemetry_queue_advance(telemetry_queue_head);
+    uint16_t *slot = telemetry_coalescing ? telemetry_slot(motor_id, type) : NULL;
+
+    bool timed = telemetry_timed;
+    if (slot != NULL && *slot != TELEMETRY_NO_SLOT) {
+        telemetry_queue[*slot - 1].value = value;
+        telemetry_queue[*slot - 1].timed = timed;
+        if (timed) {
+            telemetry_queue_time_us[*slot - 1] = (uint32_t)to_us_since_boot(get_absolute_time());
+        }
+        link_tx_count_drops(LINK_STREAM_TELEMETRY, 1);
+        restore_interrupts(irq_state);
+        return;
+    }
 
+    uint16_t next_head = telemetry_queue_advance(telemetry_queue_head);
     if (next_head == telemetry_queue_tail) {
-        telemetry_queue_tail = telemetry_queue_advance(telemetry_queue_tail);
+        telemetry_queue_pop();
+        link_tx_count_drops(LINK_STREAM_TELEMETRY, 1);
     }
 
     telemetry_queue_entry_t *entry = &telemetry_queue[telemetry_queue_head];
     entry->motor_id = motor_id;
     entry->type = type;
     entry->value = value;
+    entry->timed = timed;
+    if (timed) {
+        telemetry_queue_time_us[telemetry_queue_head] =
+            (uint32_t)to_us_since_boot(get_absolute_time());
+    }
+    if (slot != NULL) {
+        *slot = (uint16_t)(telemetry_queue_head + 1);
+    }
     telemetry_queue_head = next_head;
     restore_interrupts(irq_state);
 }
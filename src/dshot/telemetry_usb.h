@@ -1,3 +1,18 @@
+/*
+ * Telemetry values queued from the DShot controllers and sent in batches.
+ *
+ * Batch packet (variable length, little-endian):
+ *   [0xA6] [count] count x ([motor_id] [type] [value:4]) [xor_checksum]
+ *
+ * Once the host clock is known (src/clock_sync.h), batches carry the host
+ * time each value was received from its ESC:
+ *   [0xA8] [count] [host_time_us:4]
+ *   count x ([motor_id] [type] [value:4] [after_us:2]) [xor_checksum]
+ * host_time_us is that of the batch's earliest value; after_us is how long
+ * after it each value came, saturating at 65535. Values queued before the
+ * first flush after sync are stamped with the flush time.
+ */
+
 #ifndef DSHOT_TELEMETRY_USB_H
 #define DSHOT_TELEMETRY_USB_H
 
@@ -8,6 +23,11 @@
 #define TELEMETRY_PACKET_SIZE 8
 #define TELEMETRY_BATCH_START_BYTE 0xA6
 #define TELEMETRY_BATCH_ENTRY_SIZE 6
+#define TELEMETRY_TIMED_BATCH_START_BYTE 0xA8
+#define TELEMETRY_TIMED_BATCH_HEADER_SIZE 6
+#define TELEMETRY_TIMED_BATCH_ENTRY_SIZE 8
+/* Values held while the link is busy */
+#define TELEMETRY_QUEUE_CAPACITY 256
 #define TELEMETRY_TYPE_ERPM 0
 #define TELEMETRY_TYPE_VOLTAGE 1
 #define TELEMETRY_TYPE_TEMPERATURE 2
@@ -0,0 +1,19 @@
+/*
+ * Firmware entry points.
+ *
+ * main() runs firmware_init() once and then firmware_poll() forever. The
+ * split lets a host build (FIRMWARE_HOST_BUILD, see tools/firmware_host.c)
+ * drive the unmodified firmware one loop iteration at a time against the
+ * mock SDK and a simulated ESC bank.
+ */
+
+#ifndef FIRMWARE_H
+#define FIRMWARE_H
+
+/* Bring up stdio and logging, and wait in neutral for a runtime config */
+void firmware_init(void);
+
+/* One main-loop iteration: read USB input, then run the active protocol */
+void firmware_poll(void);
+
+#endif
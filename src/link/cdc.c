@@ -0,0 +1,54 @@
+#include "transport.h"
+#include <hardware/sync.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <tusb.h>
+
+/*
+ * pico_stdio_usb still owns the device: stdio_init_all() brings up TinyUSB and
+ * its low-priority IRQ runs tud_task(). This transport only moves bytes through
+ * the CDC FIFOs, skipping the stdio driver list, mutex and CR/LF handling.
+ *
+ * The SDK calls TinyUSB from thread code only under its stdio mutex, which
+ * makes that IRQ skip tud_task(). The mutex is private to pico_stdio_usb and
+ * the IRQ number is claimed at run time, so each call here masks interrupts
+ * instead; tud_task() then cannot run halfway through a FIFO or endpoint
+ * update. The calls copy at most one transport write and never wait.
+ */
+
+static size_t cdc_link_read(uint8_t *buf, size_t len) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    size_t count = tud_cdc_available() ? tud_cdc_read(buf, (uint32_t)len) : 0;
+    restore_interrupts(irq_state);
+    return count;
+}
+
+/* Takes what fits in the TX FIFO and never waits for the host to read */
+static size_t cdc_link_write(const uint8_t *data, size_t len) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    size_t count = tud_cdc_connected() ? tud_cdc_write(data, (uint32_t)len) : 0;
+    restore_interrupts(irq_state);
+    return count;
+}
+
+static size_t cdc_link_writable(void) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    size_t room = tud_cdc_connected() ? tud_cdc_write_available() : 0;
+    restore_interrupts(irq_state);
+    return room;
+}
+
+static void cdc_link_flush(void) {
+    uint32_t irq_state = save_and_disable_interrupts();
+    tud_cdc_write_flush();
+    restore_interrupts(irq_state);
+}
+
+const link_transport_t link_transport_cdc = {
+    .name = "cdc",
+    .init = NULL,
+    .read = cdc_link_read,
+    .write = cdc_link_write,
+    .writable = cdc_link_writable,
+    .flush = cdc_link_flush,
+};
@@ -0,0 +1,49 @@
+/*
+ * Link protocol v2 framing.
+ *
+ * Protocol v1 sends bare packets: a start byte, the payload and an XOR
+ * checksum. A v2 frame carries the same packet, start byte and payload,
+ * without the XOR byte:
+ *   COBS([seq u8] [packet ...] [crc16 u16 LE]) 0x00
+ * The CRC is CRC-16/CCITT-FALSE over seq and packet. COBS leaves no zero byte
+ * inside a frame, so every frame ends at the next 0x00 and a receiver that
+ * lost bytes resyncs there. seq counts frames in each direction, so a gap
+ * shows frames lost on the way.
+ *
+ * The link starts in v1. The host asks for v2 with a 0xC6 packet
+ * (src/usb_comm.h); see usb_set_link_protocol().
+ */
+
+#ifndef LINK_FRAME_H
+#define LINK_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LINK_FRAME_DELIMITER 0x00
+#define LINK_FRAME_CRC_SIZE 2
+/* Frame bytes, delimiter included, for a packet of len bytes without its XOR byte */
+#define LINK_FRAME_MAX_SIZE(len) ((len) + 5 + (((len) + 3) / 254))
+
+typedef enum {
+    LINK_PROTOCOL_V1 = 1,
+    LINK_PROTOCOL_V2 = 2,
+} link_protocol_t;
+
+uint16_t link_crc16(const uint8_t *data, size_t len, uint16_t crc);
+/* Encode len bytes; out needs len + 1 + len / 254 bytes. Returns the encoded length */
+size_t link_cobs_encode(const uint8_t *data, size_t len, uint8_t *out);
+/* Decode len bytes without the delimiter; returns false if they are not valid COBS */
+bool link_cobs_decode(const uint8_t *data, size_t len, uint8_t *out, size_t *out_len);
+
+/* Frame a packet given without its XOR byte; returns the frame length, delimiter included */
+size_t link_frame_encode(uint8_t seq, const uint8_t *packet, size_t len, uint8_t *out);
+/*
+ * Decode a frame given without its delimiter into packet, which needs len
+ * bytes. Returns false for bad COBS, a short frame or a CRC mismatch.
+ */
+bool link_frame_decode(const uint8_t *frame, size_t len, uint8_t *seq, uint8_t *packet,
+                       size_t *packet_len);
+
+#endif
@@ -0,0 +1,56 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pipe.h"
+#include "transport.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define LINK_PIPE_ATOMIC_WRITE 512 /* POSIX minimum PIPE_BUF */
+
+static int pipe_read_fd = -1;
+static int pipe_write_fd = -1;
+
+void link_pipe_open(int read_fd, int write_fd) {
+    pipe_read_fd = read_fd;
+    pipe_write_fd = write_fd;
+    fcntl(read_fd, F_SETFL, fcntl(read_fd, F_GETFL) | O_NONBLOCK);
+    fcntl(write_fd, F_SETFL, fcntl(write_fd, F_GETFL) | O_NONBLOCK);
+}
+
+static size_t pipe_link_read(uint8_t *buf, size_t len) {
+    ssize_t count = read(pipe_read_fd, buf, len);
+    return count > 0 ? (size_t)count : 0;
+}
+
+static size_t pipe_link_write(const uint8_t *data, size_t len) {
+    size_t written = 0;
+    while (written < len) {
+        ssize_t count = write(pipe_write_fd, data + written, len - written);
+        if (count <= 0) {
+            break;
+        }
+        written += (size_t)count;
+    }
+    return written;
+}
+
+/* poll() only tells whether a write would block; a pty may take less than PIPE_BUF, and
+ * link_tx_flush() resends what a short write left */
+static size_t pipe_link_writable(void) {
+    struct pollfd fd = {.fd = pipe_write_fd, .events = POLLOUT};
+    return poll(&fd, 1, 0) == 1 && (fd.revents & POLLOUT) ? LINK_PIPE_ATOMIC_WRITE : 0;
+}
+
+static void pipe_link_flush(void) {}
+
+const link_transport_t link_transport_pipe = {
+    .name = "pipe",
+    .init = NULL,
+    .read = pipe_link_read,
+    .write = pipe_link_write,
+    .writable = pipe_link_writable,
+    .flush = pipe_link_flush,
+};
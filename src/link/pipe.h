@@ -0,0 +1,13 @@
+/*
+ * Host-build transport over file descriptors (pipes, ptys, sockets). Both
+ * descriptors are made non-blocking: reads return what is buffered and
+ * writes take what the descriptor accepts.
+ */
+
+#ifndef LINK_PIPE_H
+#define LINK_PIPE_H
+
+/* Read input from read_fd and write output to write_fd */
+void link_pipe_open(int read_fd, int write_fd);
+
+#endif
@@ -0,0 +1,33 @@
+#include "transport.h"
+#include <pico/stdio.h>
+#include <pico/time.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static size_t stdio_link_read(uint8_t *buf, size_t len) {
+    int count = stdio_get_until((char *)buf, (int)len, get_absolute_time());
+    return count > 0 ? (size_t)count : 0;
+}
+
+static size_t stdio_link_write(const uint8_t *data, size_t len) {
+    return fwrite(data, 1, len, stdout);
+}
+
+/* stdio cannot report free space; its writes wait until the driver takes the bytes */
+static size_t stdio_link_writable(void) {
+    return SIZE_MAX;
+}
+
+static void stdio_link_flush(void) {
+    fflush(stdout);
+}
+
+const link_transport_t link_transport_stdio = {
+    .name = "stdio",
+    .init = NULL,
+    .read = stdio_link_read,
+    .write = stdio_link_write,
+    .writable = stdio_link_writable,
+    .flush = stdio_link_flush,
+};
@@ -0,0 +1,54 @@
+#include "transport.h"
+#include <pico/time.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static const link_transport_t *active_transport = &link_transport_stdio;
+static link_tx_stats_t tx_stats;
+
+void link_transport_select(const link_transport_t *transport) {
+    active_transport = transport;
+    if (transport->init != NULL) {
+        transport->init();
+    }
+}
+
+const link_transport_t *link_transport(void) {
+    return active_transport;
+}
+
+size_t link_read(uint8_t *buf, size_t len) {
+    return active_transport->read(buf, len);
+}
+
+size_t link_write(const uint8_t *data, size_t len) {
+    absolute_time_t start = get_absolute_time();
+    size_t written = active_transport->write(data, len);
+    tx_stats.bytes_written += (uint32_t)written;
+    tx_stats.write_time_us += (uint32_t)absolute_time_diff_us(start, get_absolute_time());
+    return written;
+}
+
+size_t link_writable(void) {
+    return active_transport->writable();
+}
+
+void link_flush(void) {
+    absolute_time_t start = get_absolute_time();
+    active_transport->flush();
+    tx_stats.flushes++;
+    tx_stats.write_time_us += (uint32_t)absolute_time_diff_us(start, get_absolute_time());
+}
+
+void link_drop(size_t len) {
+    tx_stats.bytes_dropped += (uint32_t)len;
+}
+
+const link_tx_stats_t *link_tx_stats(void) {
+    return &tx_stats;
+}
+
+void link_tx_stats_reset(void) {
+    memset(&tx_stats, 0, sizeof(tx_stats));
+}
@@ -0,0 +1,61 @@
+/*
+ * Byte transport under the host link protocol (usb_comm, log, runtime config
+ * and telemetry packets).
+ *
+ * The protocol code reads and writes through the selected transport instead
+ * of stdio, so the same packet stack runs over the Pico SDK's stdio, TinyUSB
+ * CDC directly, a hardware UART, or file descriptors on the host. The build
+ * picks one with HOST_LINK_TRANSPORT.
+ *
+ * Packet writers only call link_write(); the main loop calls link_flush()
+ * once per iteration, so a loop's packets leave in as few transfers as the
+ * transport allows.
+ */
+
+#ifndef LINK_TRANSPORT_H
+#define LINK_TRANSPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    const char *name;
+    void (*init)(void);
+    /* Copy up to len received bytes to buf without waiting; returns the count */
+    size_t (*read)(uint8_t *buf, size_t len);
+    /* Queue len bytes for sending; returns the count accepted */
+    size_t (*write)(const uint8_t *data, size_t len);
+    /* Bytes write() can take now without waiting; SIZE_MAX if unknown */
+    size_t (*writable)(void);
+    /* Start sending anything the transport still buffers */
+    void (*flush)(void);
+} link_transport_t;
+
+/* Output counters since boot, across transports */
+typedef struct {
+    uint32_t bytes_written; /* Bytes the transport accepted */
+    uint32_t flushes;
+    uint32_t write_time_us; /* Time spent in link_write() and link_flush() */
+    uint32_t bytes_dropped; /* Bytes given up after the transport took part of a write */
+} link_tx_stats_t;
+
+extern const link_transport_t link_transport_stdio; /* pico_stdio: blocking writes */
+extern const link_transport_t link_transport_cdc;   /* TinyUSB CDC FIFOs, under pico_stdio_usb */
+extern const link_transport_t link_transport_uart;  /* Hardware UART, interrupt-driven RX */
+extern const link_transport_t link_transport_pipe;  /* Host builds only: file descriptors */
+
+/* Make transport the active one and initialize it. Until then, stdio is active. */
+void link_transport_select(const link_transport_t *transport);
+const link_transport_t *link_transport(void);
+
+size_t link_read(uint8_t *buf, size_t len);
+size_t link_write(const uint8_t *data, size_t len);
+size_t link_writable(void);
+void link_flush(void);
+/* Count bytes a writer gave up on instead of resending */
+void link_drop(size_t len);
+
+const link_tx_stats_t *link_tx_stats(void);
+void link_tx_stats_reset(void);
+
+#endif
@@ -0,0 +1,281 @@
+#include "tx.h"
+#include "frame.h"
+#include "transport.h"
+#include <pico/time.h>
+#include <pico/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef LINK_TX_POLICY
+#define LINK_TX_POLICY LINK_TX_POLICY_DROP_OLDEST
+#endif
+
+/* Packet bytes back to back, with their lengths kept apart so runs of packets copy at once */
+typedef struct {
+    uint8_t data[LINK_TX_QUEUE_SIZE];
+    uint8_t lengths[LINK_TX_QUEUE_PACKETS];
+    uint16_t head;
+    uint16_t tail;
+    uint16_t used;
+    uint8_t first_packet;
+    uint8_t packets;
+} tx_queue_t;
+
+static link_tx_policy_t tx_policy = LINK_TX_POLICY;
+static uint32_t tx_dropped[LINK_STREAM_COUNT];
+static tx_queue_t tx_queues[LINK_STREAM_COUNT];
+/* Stream order until link_tx_init() applies the build's priorities */
+static uint8_t tx_priority[LINK_STREAM_COUNT] = {0, 1, 2, 3};
+static link_stream_t tx_order[LINK_STREAM_COUNT] = {LINK_STREAM_CONTROL, LINK_STREAM_LOG,
+                                                    LINK_STREAM_TELEMETRY, LINK_STREAM_CAPTURE};
+static uint8_t tx_frame[LINK_TX_FRAME_SIZE];
+static size_t tx_frame_len = 0;
+static size_t tx_frame_sent = 0; /* Less than tx_frame_len while the transport owes a tail */
+static link_protocol_t tx_protocol = LINK_PROTOCOL_V1;
+static uint8_t tx_sequence = 0;
+static bool tx_delimiter_pending = false;
+
+/* Unlimited until link_tx_init() applies the build's budget */
+static uint32_t tx_budget_bytes = 0;
+static uint32_t tx_budget_interval_us = LINK_TX_BUDGET_INTERVAL_US;
+static uint32_t tx_budget_spent = 0;
+static absolute_time_t tx_budget_start;
+
+void link_tx_set_policy(link_tx_policy_t policy) {
+    tx_policy = policy;
+}
+
+link_tx_policy_t link_tx_policy(void) {
+    return tx_policy;
+}
+
+void link_tx_set_protocol(link_protocol_t protocol) {
+    if (protocol == LINK_PROTOCOL_V2 && tx_protocol != LINK_PROTOCOL_V2) {
+        tx_sequence = 0;
+        tx_delimiter_pending = true;
+    }
+    tx_protocol = protocol;
+}
+
+link_protocol_t link_tx_protocol(void) {
+    return tx_protocol;
+}
+
+/* Keeps tx_order sorted by priority, ties in stream order */
+void link_tx_set_priority(link_stream_t stream, uint8_t priority) {
+    tx_priority[stream] = priority;
+    for (int i = 0; i < LINK_STREAM_COUNT; ++i) {
+        tx_order[i] = (link_stream_t)i;
+    }
+    for (int i = 1; i < LINK_STREAM_COUNT; ++i) {
+        link_stream_t current = tx_order[i];
+        int j = i;
+        while (j > 0 && tx_priority[tx_order[j - 1]] > tx_priority[current]) {
+            tx_order[j] = tx_order[j - 1];
+            --j;
+        }
+        tx_order[j] = current;
+    }
+}
+
+/* The largest packet as a v2 frame, after the delimiter that starts v2 */
+#define LINK_TX_WIRE_MAX_SIZE (LINK_FRAME_MAX_SIZE(LINK_TX_PACKET_MAX_SIZE - 1) + 1)
+
+void link_tx_set_budget(uint32_t bytes, uint32_t interval_us) {
+    if (bytes != 0 && bytes < LINK_TX_WIRE_MAX_SIZE) {
+        bytes = LINK_TX_WIRE_MAX_SIZE;
+    }
+    tx_budget_bytes = bytes;
+    tx_budget_interval_us = interval_us;
+    tx_budget_spent = 0;
+    tx_budget_start = get_absolute_time();
+}
+
+static size_t budget_left(void) {
+    if (tx_budget_bytes == 0) {
+        return SIZE_MAX;
+    }
+    absolute_time_t now = get_absolute_time();
+    if (absolute_time_diff_us(tx_budget_start, now) >= tx_budget_interval_us) {
+        tx_budget_start = now;
+        tx_budget_spent = 0;
+    }
+    return tx_budget_spent < tx_budget_bytes ? tx_budget_bytes - tx_budget_spent : 0;
+}
+
+static bool stream_is_bulk(link_stream_t stream) {
+    return stream == LINK_STREAM_TELEMETRY || stream == LINK_STREAM_CAPTURE;
+}
+
+static void queue_put(tx_queue_t *queue, const uint8_t *data, size_t len) {
+    size_t first = LINK_TX_QUEUE_SIZE - queue->head;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&queue->data[queue->head], data, first);
+    memcpy(queue->data, data + first, len - first);
+    queue->head = (uint16_t)((queue->head + len) % LINK_TX_QUEUE_SIZE);
+    queue->used = (uint16_t)(queue->used + len);
+}
+
+static void queue_take(tx_queue_t *queue, uint8_t *data, size_t len) {
+    size_t first = LINK_TX_QUEUE_SIZE - queue->tail;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(data, &queue->data[queue->tail], first);
+    memcpy(data + first, queue->data, len - first);
+    queue->tail = (uint16_t)((queue->tail + len) % LINK_TX_QUEUE_SIZE);
+    queue->used = (uint16_t)(queue->used - len);
+}
+
+size_t link_tx_room(link_stream_t stream) {
+    const tx_queue_t *queue = &tx_queues[stream];
+    if (queue->packets == LINK_TX_QUEUE_PACKETS) {
+        return 0;
+    }
+    size_t space = LINK_TX_QUEUE_SIZE - queue->used;
+    return space < LINK_TX_PACKET_MAX_SIZE ? space : LINK_TX_PACKET_MAX_SIZE;
+}
+
+bool link_tx_send(link_stream_t stream, const uint8_t *packet, size_t len) {
+    if (len == 0 || link_tx_room(stream) < len) {
+        tx_dropped[stream]++;
+        return false;
+    }
+    tx_queue_t *queue = &tx_queues[stream];
+    queue->lengths[(queue->first_packet + queue->packets) % LINK_TX_QUEUE_PACKETS] = (uint8_t)len;
+    queue->packets++;
+    queue_put(queue, packet, len);
+    return true;
+}
+
+void link_tx_count_drops(link_stream_t stream, uint32_t count) {
+    tx_dropped[stream] += count;
+}
+
+/* As build_frame(), framing each packet in v2 as it leaves its queue */
+static size_t build_v2_frame(size_t room, size_t bulk_room) {
+    size_t len = 0;
+    if (tx_delimiter_pending && room > 0) {
+        /* Ends whatever v1 bytes the host saw last, so the first frame decodes */
+        tx_frame[len++] = LINK_FRAME_DELIMITER;
+        tx_delimiter_pending = false;
+    }
+
+    for (int i = 0; i < LINK_STREAM_COUNT; ++i) {
+        link_stream_t stream = tx_order[i];
+        tx_queue_t *queue = &tx_queues[stream];
+        size_t limit = stream_is_bulk(stream) ? bulk_room : room;
+        while (queue->packets > 0) {
+            uint8_t packet_len = queue->lengths[queue->first_packet];
+            if (len + LINK_FRAME_MAX_SIZE(packet_len - 1u) > limit) {
+                break;
+            }
+            uint8_t packet[LINK_TX_PACKET_MAX_SIZE];
+            queue_take(queue, packet, packet_len);
+            queue->first_packet = (uint8_t)((queue->first_packet + 1) % LINK_TX_QUEUE_PACKETS);
+            queue->packets--;
+            /* The frame's CRC replaces the packet's XOR byte */
+            len += link_frame_encode(tx_sequence++, packet, packet_len - 1u, &tx_frame[len]);
+        }
+    }
+    return len;
+}
+
+/*
+ * Packs whole packets into tx_frame, highest priority first, copying each
+ * stream's run of packets at once. A stream whose next packet does not fit
+ * leaves the rest of the frame to lower ones.
+ */
+static size_t build_frame(size_t room, size_t writable) {
+    size_t bulk_room = room;
+    if (tx_policy == LINK_TX_POLICY_PRIORITIZE && writable != SIZE_MAX) {
+        size_t unreserved =
+            writable > LINK_TX_PRIORITY_RESERVE ? writable - LINK_TX_PRIORITY_RESERVE : 0;
+        bulk_room = unreserved < room ? unreserved : room;
+    }
+
+    if (tx_protocol == LINK_PROTOCOL_V2) {
+        return build_v2_frame(room, bulk_room);
+    }
+
+    size_t len = 0;
+    for (int i = 0; i < LINK_STREAM_COUNT; ++i) {
+        link_stream_t stream = tx_order[i];
+        tx_queue_t *queue = &tx_queues[stream];
+        size_t limit = stream_is_bulk(stream) ? bulk_room : room;
+        size_t run = 0;
+        uint8_t count = 0;
+        while (count < queue->packets) {
+            uint8_t packet_len =
+                queue->lengths[(queue->first_packet + count) % LINK_TX_QUEUE_PACKETS];
+            if (len + run + packet_len > limit) {
+                break;
+            }
+            run += packet_len;
+            count++;
+        }
+        queue_take(queue, &tx_frame[len], run);
+        queue->first_packet = (uint8_t)((queue->first_packet + count) % LINK_TX_QUEUE_PACKETS);
+        queue->packets = (uint8_t)(queue->packets - count);
+        len += run;
+    }
+    return len;
+}
+
+/* Write what is left of tx_frame; true once the transport has taken all of it */
+static bool write_frame(void) {
+    tx_frame_sent += link_write(&tx_frame[tx_frame_sent], tx_frame_len - tx_frame_sent);
+    return tx_frame_sent == tx_frame_len;
+}
+
+void link_tx_flush(void) {
+    /* A frame the transport took only part of finishes first, so no packet is cut short */
+    bool written = tx_frame_sent == tx_frame_len || write_frame();
+    while (written) {
+        size_t writable = link_writable();
+        size_t room = budget_left();
+        if (writable < room) {
+            room = writable;
+        }
+        if (room > LINK_TX_FRAME_SIZE) {
+            room = LINK_TX_FRAME_SIZE;
+        }
+
+        size_t len = build_frame(room, writable);
+        if (len == 0) {
+            break;
+        }
+        tx_budget_spent += (uint32_t)len;
+        tx_frame_len = len;
+        tx_frame_sent = 0;
+        written = write_frame();
+    }
+    link_flush();
+}
+
+uint32_t link_tx_dropped(link_stream_t stream) {
+    return tx_dropped[stream];
+}
+
+void link_tx_init(void) {
+    link_tx_set_priority(LINK_STREAM_CONTROL, LINK_TX_PRIORITY_CONTROL);
+    link_tx_set_priority(LINK_STREAM_LOG, LINK_TX_PRIORITY_LOG);
+    link_tx_set_priority(LINK_STREAM_TELEMETRY, LINK_TX_PRIORITY_TELEMETRY);
+    link_tx_set_priority(LINK_STREAM_CAPTURE, LINK_TX_PRIORITY_CAPTURE);
+    link_tx_set_budget(LINK_TX_BUDGET_BYTES, LINK_TX_BUDGET_INTERVAL_US);
+    link_tx_reset();
+}
+
+void link_tx_reset(void) {
+    link_drop(tx_frame_len - tx_frame_sent);
+    tx_frame_len = 0;
+    tx_frame_sent = 0;
+    memset(tx_dropped, 0, sizeof(tx_dropped));
+    memset(tx_queues, 0, sizeof(tx_queues));
+    tx_budget_spent = 0;
+    tx_budget_start = get_absolute_time();
+}
@@ -0,0 +1,132 @@
+/*
+ * Prioritized packet output over the active link transport.
+ *
+ * Every packet writer goes through link_tx_send(), which appends the whole
+ * packet to its stream's queue, or drops it and counts the drop against its
+ * stream if the queue is full. Queued sources (telemetry, captures) check
+ * link_tx_room() first and keep their backlog instead. Nothing reaches the
+ * transport until link_tx_flush(), which runs once per main-loop iteration:
+ * it packs whole packets from the queues, highest priority first, into one
+ * transport write and flushes it as a single USB transfer. The control loop
+ * therefore never waits on the host reading its output.
+ *
+ * A flush writes no more than the transport can take without blocking and,
+ * with a budget set, no more than LINK_TX_BUDGET_BYTES per
+ * LINK_TX_BUDGET_INTERVAL_US. What does not fit stays queued. If the
+ * transport takes only part of a write anyway, the rest goes out first on the
+ * next flush.
+ *
+ * The policy decides what gives way when the host falls behind:
+ *   DROP_OLDEST: telemetry stays queued; a full queue drops its oldest value
+ *   COALESCE:    a newer telemetry value replaces the queued one for the same
+ *                motor and type, so the queue holds only the latest values
+ *   PRIORITIZE:  telemetry and captures leave LINK_TX_PRIORITY_RESERVE bytes
+ *                of transport space free for logs and control replies
+ *
+ * Packets are queued as v1 packets. In protocol v2 (link/frame.h) each one is
+ * framed as it leaves its queue, so frame sequence numbers follow the order on
+ * the wire.
+ *
+ * Only the stdio transport cannot report its free space; with it, writes
+ * still block.
+ *
+ * The queues are filled and flushed from the main loop only.
+ */
+
+#ifndef LINK_TX_H
+#define LINK_TX_H
+
+#include "frame.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LINK_TX_PRIORITY_RESERVE
+#define LINK_TX_PRIORITY_RESERVE 64
+#endif
+
+/* Per-stream queue, in bytes and in packets */
+#ifndef LINK_TX_QUEUE_SIZE
+#define LINK_TX_QUEUE_SIZE 512
+#endif
+
+#ifndef LINK_TX_QUEUE_PACKETS
+#define LINK_TX_QUEUE_PACKETS 64
+#endif
+
+/* Largest transport write a flush builds */
+#ifndef LINK_TX_FRAME_SIZE
+#define LINK_TX_FRAME_SIZE 512
+#endif
+
+/* Stream priorities applied by link_tx_init(); lower values go first */
+#ifndef LINK_TX_PRIORITY_CONTROL
+#define LINK_TX_PRIORITY_CONTROL 0
+#endif
+
+#ifndef LINK_TX_PRIORITY_LOG
+#define LINK_TX_PRIORITY_LOG 1
+#endif
+
+#ifndef LINK_TX_PRIORITY_TELEMETRY
+#define LINK_TX_PRIORITY_TELEMETRY 2
+#endif
+
+#ifndef LINK_TX_PRIORITY_CAPTURE
+#define LINK_TX_PRIORITY_CAPTURE 3
+#endif
+
+/* 0 bytes disables the budget */
+#ifndef LINK_TX_BUDGET_BYTES
+#define LINK_TX_BUDGET_BYTES 0
+#endif
+
+#ifndef LINK_TX_BUDGET_INTERVAL_US
+#define LINK_TX_BUDGET_INTERVAL_US 1000
+#endif
+
+#define LINK_TX_PACKET_MAX_SIZE 255
+
+typedef enum {
+    LINK_STREAM_CONTROL = 0, /* Version replies and link stats */
+    LINK_STREAM_LOG,
+    LINK_STREAM_TELEMETRY, /* Counted in values, not batches */
+    LINK_STREAM_CAPTURE,
+    LINK_STREAM_COUNT,
+} link_stream_t;
+
+typedef enum {
+    LINK_TX_POLICY_DROP_OLDEST = 0,
+    LINK_TX_POLICY_COALESCE,
+    LINK_TX_POLICY_PRIORITIZE,
+} link_tx_policy_t;
+
+void link_tx_set_policy(link_tx_policy_t policy);
+link_tx_policy_t link_tx_policy(void);
+
+/* Frame output from the next flush on; switching to v2 sends a delimiter first */
+void link_tx_set_protocol(link_protocol_t protocol);
+link_protocol_t link_tx_protocol(void);
+
+/* Lower values go first; streams start in link_stream_t order */
+void link_tx_set_priority(link_stream_t stream, uint8_t priority);
+/* At most bytes per interval_us; 0 disables, other values are raised to fit the largest packet */
+void link_tx_set_budget(uint32_t bytes, uint32_t interval_us);
+
+/* Largest packet the stream can queue now */
+size_t link_tx_room(link_stream_t stream);
+/* Queue the whole packet if it fits; otherwise drop and count it */
+bool link_tx_send(link_stream_t stream, const uint8_t *packet, size_t len);
+void link_tx_count_drops(link_stream_t stream, uint32_t count);
+/* Write what the transport and budget allow, highest priority first, then flush */
+void link_tx_flush(void);
+
+/* Apply the build's priorities and budget (raised to fit any packet) and empty the queues */
+void link_tx_init(void);
+/* Drops per stream since boot or the last reset */
+uint32_t link_tx_dropped(link_stream_t stream);
+/* Empty the queues, clear the drop counts and start a new budget interval. The unwritten
+ * rest of a short write is given up and counted in link_tx_stats()->bytes_dropped. */
+void link_tx_reset(void);
+
+#endif
@@ -0,0 +1,114 @@
+#include "transport.h"
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <hardware/uart.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LINK_UART_INDEX
+#define LINK_UART_INDEX 0
+#endif
+#ifndef LINK_UART_TX_PIN
+#define LINK_UART_TX_PIN 0
+#endif
+#ifndef LINK_UART_RX_PIN
+#define LINK_UART_RX_PIN 1
+#endif
+#ifndef LINK_UART_BAUD
+#define LINK_UART_BAUD 921600
+#endif
+
+#define LINK_UART UART_INSTANCE(LINK_UART_INDEX)
+#define LINK_UART_IRQ (LINK_UART_INDEX ? UART1_IRQ : UART0_IRQ)
+#define LINK_UART_RX_RING_SIZE 512  /* Power of two */
+#define LINK_UART_TX_RING_SIZE 1024 /* Power of two */
+
+/*
+ * Both directions run through rings serviced by the UART IRQ. The 32-byte RX
+ * FIFO fills in ~0.35 ms at 921600 baud, and writes must not wait on the
+ * line, so neither depends on how often the main loop runs.
+ */
+static uint8_t rx_ring[LINK_UART_RX_RING_SIZE];
+static volatile uint32_t rx_head;
+static volatile uint32_t rx_tail;
+static uint8_t tx_ring[LINK_UART_TX_RING_SIZE];
+static volatile uint32_t tx_head;
+static volatile uint32_t tx_tail;
+
+/* Move queued bytes into the TX FIFO; call with the UART IRQ masked */
+static void uart_link_pump_tx(void) {
+    while (tx_tail != tx_head && uart_is_writable(LINK_UART)) {
+        uart_putc_raw(LINK_UART, (char)tx_ring[tx_tail % LINK_UART_TX_RING_SIZE]);
+        tx_tail++;
+    }
+    if (tx_tail == tx_head) {
+        /* Nothing left to refill with, so clear the FIFO-level interrupt by hand */
+        uart_get_hw(LINK_UART)->icr = UART_UARTICR_TXIC_BITS;
+    }
+}
+
+static void uart_link_irq(void) {
+    while (uart_is_readable(LINK_UART)) {
+        uint8_t byte = (uint8_t)uart_getc(LINK_UART);
+        if (rx_head - rx_tail < LINK_UART_RX_RING_SIZE) {
+            rx_ring[rx_head % LINK_UART_RX_RING_SIZE] = byte;
+            rx_head++;
+        }
+    }
+    uart_link_pump_tx();
+}
+
+static void uart_link_init(void) {
+    rx_head = 0;
+    rx_tail = 0;
+    tx_head = 0;
+    tx_tail = 0;
+    uart_init(LINK_UART, LINK_UART_BAUD);
+    gpio_set_function(LINK_UART_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(LINK_UART_RX_PIN, GPIO_FUNC_UART);
+    irq_set_exclusive_handler(LINK_UART_IRQ, uart_link_irq);
+    irq_set_enabled(LINK_UART_IRQ, true);
+    uart_set_irq_enables(LINK_UART, true, true);
+}
+
+static size_t uart_link_read(uint8_t *buf, size_t len) {
+    size_t count = 0;
+    while (count < len && rx_tail != rx_head) {
+        buf[count++] = rx_ring[rx_tail % LINK_UART_RX_RING_SIZE];
+        rx_tail++;
+    }
+    return count;
+}
+
+static size_t uart_link_writable(void) {
+    return LINK_UART_TX_RING_SIZE - (tx_head - tx_tail);
+}
+
+static size_t uart_link_write(const uint8_t *data, size_t len) {
+    size_t count = uart_link_writable();
+    if (count > len) {
+        count = len;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        tx_ring[(tx_head + i) % LINK_UART_TX_RING_SIZE] = data[i];
+    }
+    tx_head += (uint32_t)count;
+
+    /* The TX interrupt fires only as the FIFO drains, so start it from here */
+    irq_set_enabled(LINK_UART_IRQ, false);
+    uart_link_pump_tx();
+    irq_set_enabled(LINK_UART_IRQ, true);
+    return count;
+}
+
+static void uart_link_flush(void) {}
+
+const link_transport_t link_transport_uart = {
+    .name = "uart",
+    .init = uart_link_init,
+    .read = uart_link_read,
+    .write = uart_link_write,
+    .writable = uart_link_writable,
+    .flush = uart_link_flush,
+};
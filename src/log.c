@@ -1,4 +1,6 @@
 #include "log.h"
+#include "clock_sync.h"
+#include "link/tx.h"
 #include <pico/time.h>
 #include <pico/types.h>
 #include <stdarg.h>
@@ -38,23 +40,27 @@ static void send_log(enum log_level level, const char *message) {
         msg_len = LOG_MAX_MESSAGE_SIZE;
     }
 
-    uint8_t header[3];
-    header[0] = LOG_START_BYTE;
-    header[1] = (uint8_t)level;
-    header[2] = (uint8_t)msg_len;
+    uint8_t packet[7 + LOG_MAX_MESSAGE_SIZE + 1];
+    size_t header_len = 3;
+    uint32_t host_time_us;
+    packet[0] = LOG_START_BYTE;
+    if (clock_sync_host_time_us((uint32_t)to_us_since_boot(get_absolute_time()), &host_time_us)) {
+        packet[0] = LOG_TIMED_START_BYTE;
+        memcpy(&packet[3], &host_time_us, sizeof(host_time_us));
+        header_len = 7;
+    }
+    packet[1] = (uint8_t)level;
+    packet[2] = (uint8_t)msg_len;
+    memcpy(&packet[header_len], message, msg_len);
 
     uint8_t checksum = 0;
-    for (size_t i = 0; i < 3; ++i) {
-        checksum ^= header[i];
-    }
-    for (size_t i = 0; i < msg_len; ++i) {
-        checksum ^= (uint8_t)message[i];
+    for (size_t i = 0; i < header_len + msg_len; ++i) {
+        checksum ^= packet[i];
     }
+    packet[header_len + msg_len] = checksum;
 
-    fwrite(header, 1, 3, stdout);
-    fwrite(message, 1, msg_len, stdout);
-    fwrite(&checksum, 1, 1, stdout);
-    fflush(stdout);
+    /* Whole packet or nothing, so a full link cannot leave a torn log packet */
+    link_tx_send(LINK_STREAM_LOG, packet, header_len + msg_len + 1);
 }
 
 static void send_logf(enum log_level level, const char *format, va_list args) {
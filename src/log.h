@@ -6,6 +6,10 @@
  * Packet format (variable length):
  *   [0xB5] [level] [length] [message...] [xor_checksum]
  *
+ * Once the host clock is synced (src/clock_sync.h), packets carry the host
+ * time they were logged at instead:
+ *   [0xB6] [level] [length] [host_time_us:4] [message...] [xor_checksum]
+ *
  * Rate-limited to LOG_MAX_PER_SECOND to avoid saturating USB bandwidth.
  */
 
@@ -16,6 +20,7 @@
 #include <stdint.h>
 
 #define LOG_START_BYTE 0xB5
+#define LOG_TIMED_START_BYTE 0xB6
 #define LOG_MAX_MESSAGE_SIZE 200
 #define LOG_MAX_PER_SECOND 10
 
@@ -1,11 +1,17 @@
+#include "clock_sync.h"
+#include "dshot/capture_usb.h"
 #include "dshot/control.h"
 #include "dshot/dshot.h"
 #include "dshot/telemetry_usb.h"
+#include "firmware.h"
+#include "link/transport.h"
+#include "link/tx.h"
 #include "log.h"
 #include "motors.h"
 #include "pwm/control.h"
 #include "pwm/pwm.h"
 #include "runtime_config.h"
+#include "trajectory.h"
 #include "usb_comm.h"
 #include <hardware/pio.h>
 #include <pico/stdio.h>
@@ -18,15 +24,29 @@
 #define DSHOT_SM_0 0
 #define DSHOT_SM_1 1
 
+#ifndef DSHOT_RX_CAPTURE_MODE
+#define DSHOT_RX_CAPTURE_MODE DSHOT_RX_CAPTURE_OVERSAMPLE
+#endif
+
+#ifndef DSHOT_CAPTURE_USB_MODE
+#define DSHOT_CAPTURE_USB_MODE CAPTURE_USB_MODE_OFF
+#endif
+
+#ifndef HOST_LINK_TRANSPORT
+#define HOST_LINK_TRANSPORT link_transport_cdc
+#endif
+
 #define INPUT_PACKET_SIZE USB_INPUT_PACKET_SIZE(NUM_MOTORS)
 #define QUALITY_WARN_THRESHOLD 5000
 #define QUALITY_REPORT_INTERVAL_MS 100
+#define LINK_STATS_INTERVAL_MS 1000
 
 static uint16_t command_values[NUM_MOTORS] = {CMD_THROTTLE_NEUTRAL};
 static absolute_time_t last_comm_time;
 static bool comm_timed_out = true;
 
 static absolute_time_t next_quality_report_time;
+static absolute_time_t next_link_stats_time;
 static bool edt_enable_scheduled[NUM_MOTORS] = {false};
 static absolute_time_t edt_enable_time[NUM_MOTORS];
 static bool quality_warned[NUM_MOTORS] = {false};
@@ -42,6 +62,10 @@ static bool runtime_config_received = false;
 
 static mcu_runtime_config_t current_config = {0};
 
+/* Also receives trajectory packets */
+static uint8_t command_buf[USB_INPUT_PACKET_MAX];
+static uint8_t config_buf[USB_CONFIG_PACKET_SIZE];
+
 static void send_quality_reports(void) {
     for (int i = 0; i < NUM_MOTORS; i++) {
         struct dshot_controller *ctrl;
@@ -69,9 +93,11 @@ static void set_all_commands_neutral(void) {
 static void deinit_protocol(thruster_protocol_t protocol) {
     if (protocol == THRUSTER_PROTOCOL_DSHOT && dshot_initialized) {
         dshot_telemetry_usb_flush();
+        dshot_capture_usb_flush();
         dshot_controller_deinit(&dshot_controller0);
         dshot_controller_deinit(&dshot_controller1);
         dshot_telemetry_usb_reset();
+        dshot_capture_usb_init();
         dshot_initialized = false;
     } else if (protocol == THRUSTER_PROTOCOL_PWM && pwm_initialized) {
         pwm_controller_deinit(&pwm_controller);
@@ -88,17 +114,19 @@ static void init_pwm_protocol(void) {
 }
 
 static void init_dshot_protocol(uint16_t dshot_speed) {
-    dshot_controller_reset_calibration();
     dshot_telemetry_usb_init();
+    dshot_capture_usb_init();
     dshot_controller_init(&dshot_controller0, dshot_speed, DSHOT_PIO, DSHOT_SM_0, MOTOR0_PIN_BASE,
-                          NUM_MOTORS_0);
+                          NUM_MOTORS_0, DSHOT_RX_CAPTURE_MODE);
     dshot_controller0.edt_always_decode = true;
     dshot_register_telemetry_cb(&dshot_controller0, dshot_telemetry_callback, &dshot_context0);
+    dshot_register_capture_cb(&dshot_controller0, dshot_capture_callback, &dshot_context0);
 
     dshot_controller_init(&dshot_controller1, dshot_speed, DSHOT_PIO, DSHOT_SM_1, MOTOR1_PIN_BASE,
-                          NUM_MOTORS_1);
+                          NUM_MOTORS_1, DSHOT_RX_CAPTURE_MODE);
     dshot_controller1.edt_always_decode = true;
     dshot_register_telemetry_cb(&dshot_controller1, dshot_telemetry_callback, &dshot_context1);
+    dshot_register_capture_cb(&dshot_controller1, dshot_capture_callback, &dshot_context1);
 
     for (int i = 0; i < NUM_MOTORS; ++i) {
         edt_enable_scheduled[i] = false;
@@ -147,6 +175,7 @@ static void apply_runtime_config(mcu_runtime_config_t config) {
     }
 
     current_config = config;
+    usb_set_command_format((usb_command_format_t)current_config.command_format);
 
     if (current_config.protocol == THRUSTER_PROTOCOL_DSHOT) {
         init_dshot_protocol(current_config.dshot_speed);
@@ -159,16 +188,7 @@ static void apply_runtime_config(mcu_runtime_config_t config) {
     mcu_runtime_config_send_version(&current_config);
 }
 
-static void handle_command_packet(uint8_t *command_buf) {
-    if (!runtime_config_received) {
-        return;
-    }
-
-    if (!usb_parse_packet(command_buf, INPUT_PACKET_SIZE, command_values, NUM_MOTORS,
-                          &last_comm_time)) {
-        return;
-    }
-
+static void mark_host_active(void) {
     if (current_config.protocol == THRUSTER_PROTOCOL_DSHOT) {
         dshot_mark_activity(&dshot_controller0);
         dshot_mark_activity(&dshot_controller1);
@@ -184,14 +204,45 @@ static void handle_command_packet(uint8_t *command_buf) {
     }
 }
 
-static void handle_config_packet(uint8_t *config_buf) {
+static void handle_command_packet(const uint8_t *packet) {
+    if (!runtime_config_received) {
+        return;
+    }
+
+    if (!usb_apply_command(packet, command_values, NUM_MOTORS, &last_comm_time)) {
+        return;
+    }
+
+    /* A direct command takes over from any queued setpoints */
+    trajectory_clear();
+    mark_host_active();
+}
+
+static void handle_trajectory_packet(const uint8_t *packet) {
+    if (!runtime_config_received) {
+        return;
+    }
+
+    absolute_time_t now = get_absolute_time();
+    if (!trajectory_parse_packet(packet, now)) {
+        return;
+    }
+
+    last_comm_time = now;
+    mark_host_active();
+}
+
+static void handle_config_packet(const uint8_t *packet) {
     mcu_runtime_config_t new_config;
-    if (!mcu_runtime_config_parse_packet(config_buf, USB_CONFIG_PACKET_SIZE, &new_config)) {
+    if (!mcu_runtime_config_parse_packet(packet, USB_CONFIG_PACKET_SIZE, &new_config)) {
         return;
     }
 
     if (runtime_config_received && new_config.protocol == current_config.protocol &&
         new_config.dshot_speed == current_config.dshot_speed) {
+        /* The command format changes without touching the motors */
+        current_config.command_format = new_config.command_format;
+        usb_set_command_format((usb_command_format_t)current_config.command_format);
         mcu_runtime_config_send_version(&current_config);
         return;
     }
@@ -216,54 +267,132 @@ static void handle_config_packet(uint8_t *config_buf) {
               current_config.dshot_speed);
 }
 
-int main(void) {
+/* Opt-in features on now, as reported in the capability packet */
+static uint32_t active_features(void) {
+    uint32_t features = 0;
+    if (link_tx_policy() == LINK_TX_POLICY_COALESCE) {
+        features |= MCU_FEATURE_TELEMETRY_COALESCE;
+    }
+    if (dshot_capture_usb_get_mode() == CAPTURE_USB_MODE_FAILED) {
+        features |= MCU_FEATURE_CAPTURE_FAILED;
+    } else if (dshot_capture_usb_get_mode() == CAPTURE_USB_MODE_FAILED_AND_SAMPLED) {
+        features |= MCU_FEATURE_CAPTURE_FAILED | MCU_FEATURE_CAPTURE_SAMPLED;
+    }
+    return features;
+}
+
+static void apply_features(uint32_t features) {
+    if ((features & MCU_FEATURE_TELEMETRY_COALESCE) != 0) {
+        link_tx_set_policy(LINK_TX_POLICY_COALESCE);
+    } else if (link_tx_policy() == LINK_TX_POLICY_COALESCE) {
+        link_tx_set_policy(LINK_TX_POLICY_DROP_OLDEST);
+    }
+
+    if ((features & MCU_FEATURE_CAPTURE_SAMPLED) != 0) {
+        dshot_capture_usb_set_mode(CAPTURE_USB_MODE_FAILED_AND_SAMPLED);
+    } else if ((features & MCU_FEATURE_CAPTURE_FAILED) != 0) {
+        dshot_capture_usb_set_mode(CAPTURE_USB_MODE_FAILED);
+    } else {
+        dshot_capture_usb_set_mode(CAPTURE_USB_MODE_OFF);
+    }
+}
+
+static void handle_capability_query(const uint8_t *packet) {
+    bool apply;
+    uint32_t features;
+    if (!mcu_runtime_config_parse_capability_query(packet, &apply, &features)) {
+        return;
+    }
+
+    if (apply) {
+        apply_features(features);
+    }
+    mcu_runtime_config_send_capabilities(active_features());
+}
+
+void firmware_init(void) {
     stdio_init_all();
+    link_transport_select(&HOST_LINK_TRANSPORT);
+    link_tx_init();
     log_init();
+    dshot_capture_usb_set_mode(DSHOT_CAPTURE_USB_MODE);
 
     set_all_commands_neutral();
     last_comm_time = get_absolute_time();
     log_info("Waiting for runtime config from main firmware");
+}
 
-    static uint8_t command_buf[INPUT_PACKET_SIZE];
-    static uint8_t config_buf[USB_CONFIG_PACKET_SIZE];
-    static size_t command_idx = 0;
-    static size_t config_idx = 0;
-
-    while (true) {
-        usb_packet_kind_t packet_kind =
-            usb_poll_multi(command_buf, INPUT_PACKET_SIZE, &command_idx, config_buf,
-                           USB_CONFIG_PACKET_SIZE, &config_idx);
-
+static void poll_link_and_motors(void) {
+    /* Drain the input so the motors get the newest command, not one a loop behind per packet */
+    usb_packet_kind_t packet_kind;
+    while ((packet_kind = usb_poll_latest(command_buf, INPUT_PACKET_SIZE, config_buf,
+                                          USB_CONFIG_PACKET_SIZE)) != USB_PACKET_NONE) {
         if (packet_kind == USB_PACKET_COMMAND) {
             handle_command_packet(command_buf);
-            command_idx = 0;
         } else if (packet_kind == USB_PACKET_CONFIG) {
             handle_config_packet(config_buf);
-            config_idx = 0;
+        } else if (packet_kind == USB_PACKET_LINK_PROTOCOL) {
+            /* The reply goes out in the new protocol, or in the old one if refused */
+            usb_set_link_protocol(config_buf[1]);
+            mcu_runtime_config_send_version(&current_config);
+        } else if (packet_kind == USB_PACKET_TRAJECTORY) {
+            handle_trajectory_packet(command_buf);
+        } else if (packet_kind == USB_PACKET_CLOCK_SYNC) {
+            /* Answered before config too, so the host can sync first */
+            clock_sync_handle_ping(command_buf, get_absolute_time());
+        } else if (packet_kind == USB_PACKET_CAPABILITY_QUERY) {
+            handle_capability_query(command_buf);
         }
+    }
 
-        usb_check_timeout(last_comm_time, command_values, NUM_MOTORS, CMD_THROTTLE_NEUTRAL,
-                          &command_idx, &comm_timed_out);
+    usb_check_timeout(last_comm_time, command_values, NUM_MOTORS, CMD_THROTTLE_NEUTRAL,
+                      &comm_timed_out);
+    if (comm_timed_out) {
+        trajectory_clear();
+    }
 
-        if (!runtime_config_received) {
-            continue;
-        }
+    if (!runtime_config_received) {
+        return;
+    }
 
-        if (current_config.protocol == THRUSTER_PROTOCOL_DSHOT) {
-            dshot_send_commands(command_values, &dshot_controller0, &dshot_controller1);
-            dshot_enable_edt_if_idle(command_values, edt_enable_scheduled, edt_enable_time,
-                                     &dshot_controller0, &dshot_controller1);
-            if (dshot_quality_report_due(&next_quality_report_time, QUALITY_REPORT_INTERVAL_MS,
-                                         get_absolute_time())) {
-                send_quality_reports();
-            }
-            dshot_loop(&dshot_controller0);
-            dshot_loop(&dshot_controller1);
-            dshot_telemetry_usb_flush();
-        } else {
-            for (int i = 0; i < NUM_MOTORS; ++i) {
-                pwm_set_throttle(&pwm_controller, i, pwm_translate_throttle(command_values[i]));
-            }
+    if (absolute_time_diff_us(next_link_stats_time, get_absolute_time()) >= 0) {
+        usb_link_stats_send();
+        next_link_stats_time = delayed_by_ms(get_absolute_time(), LINK_STATS_INTERVAL_MS);
+    }
+
+    /* Setpoints due by now go out in this iteration's frame */
+    trajectory_apply(get_absolute_time(), command_values);
+
+    if (current_config.protocol == THRUSTER_PROTOCOL_DSHOT) {
+        dshot_send_commands(command_values, &dshot_controller0, &dshot_controller1);
+        dshot_enable_edt_if_idle(command_values, edt_enable_scheduled, edt_enable_time,
+                                 &dshot_controller0, &dshot_controller1);
+        if (dshot_quality_report_due(&next_quality_report_time, QUALITY_REPORT_INTERVAL_MS,
+                                     get_absolute_time())) {
+            send_quality_reports();
         }
+        dshot_loop(&dshot_controller0);
+        dshot_loop(&dshot_controller1);
+        dshot_telemetry_usb_flush();
+        dshot_capture_usb_flush();
+    } else {
+        for (int i = 0; i < NUM_MOTORS; ++i) {
+            pwm_set_throttle(&pwm_controller, i, pwm_translate_throttle(command_values[i]));
+        }
+    }
+}
+
+/* Packets queued during the iteration leave together, in priority order */
+void firmware_poll(void) {
+    poll_link_and_motors();
+    link_tx_flush();
+}
+
+#ifndef FIRMWARE_HOST_BUILD
+int main(void) {
+    firmware_init();
+    while (true) {
+        firmware_poll();
     }
 }
+#endif
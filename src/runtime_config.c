@@ -1,9 +1,13 @@
 #include "runtime_config.h"
+#include "dshot/telemetry_usb.h"
+#include "link/tx.h"
+#include "motors.h"
+#include "trajectory.h"
 #include "usb_comm.h"
 #include "version.h"
 #include <stdbool.h>
 #include <stdint.h>
-#include <stdio.h>
+#include <string.h>
 
 static bool mcu_supports_dshot_1200(void) {
 #if defined(PICO_RP2350)
@@ -31,6 +35,9 @@ void mcu_runtime_config_validate(mcu_runtime_config_t *config) {
     if (config->protocol != THRUSTER_PROTOCOL_PWM && config->protocol != THRUSTER_PROTOCOL_DSHOT) {
         config->protocol = THRUSTER_PROTOCOL_DSHOT;
     }
+    if (config->command_format >= USB_COMMAND_FORMAT_COUNT) {
+        config->command_format = USB_COMMAND_FORMAT_FULL;
+    }
 }
 
 bool mcu_runtime_config_parse_packet(const uint8_t *packet, size_t packet_size,
@@ -45,7 +52,8 @@ bool mcu_runtime_config_parse_packet(const uint8_t *packet, size_t packet_size,
         return false;
     }
 
-    out_config->protocol = (thruster_protocol_t)packet[1];
+    out_config->protocol = (thruster_protocol_t)(packet[1] & 0x0F);
+    out_config->command_format = (uint8_t)(packet[1] >> 4);
     out_config->dshot_speed = (uint16_t)packet[2] | ((uint16_t)packet[3] << 8);
     mcu_runtime_config_validate(out_config);
     return true;
@@ -56,15 +64,72 @@ const char *mcu_runtime_config_protocol_name(thruster_protocol_t protocol) {
 }
 
 void mcu_runtime_config_send_version(const mcu_runtime_config_t *config) {
-    uint8_t packet[USB_VERSION_PACKET_SIZE];
+    uint8_t packet[USB_VERSION_V2_PACKET_SIZE];
+    size_t size = USB_VERSION_PACKET_SIZE;
     packet[0] = USB_VERSION_START_BYTE;
     packet[1] = MCU_FIRMWARE_VERSION_MAJOR;
     packet[2] = MCU_FIRMWARE_VERSION_MINOR;
     packet[3] = MCU_FIRMWARE_VERSION_PATCH;
-    packet[4] = (uint8_t)config->protocol;
+    packet[4] = (uint8_t)(config->protocol | (config->command_format << 4));
     packet[5] = (uint8_t)(config->dshot_speed & 0xFF);
     packet[6] = (uint8_t)(config->dshot_speed >> 8);
-    packet[7] = usb_calculate_checksum(packet, USB_VERSION_PACKET_SIZE - 1);
-    fwrite(packet, 1, USB_VERSION_PACKET_SIZE, stdout);
-    fflush(stdout);
+    if (usb_link_protocol() == LINK_PROTOCOL_V2) {
+        packet[7] = (uint8_t)LINK_PROTOCOL_V2;
+        size = USB_VERSION_V2_PACKET_SIZE;
+    }
+    packet[size - 1] = usb_calculate_checksum(packet, size - 1);
+    link_tx_send(LINK_STREAM_CONTROL, packet, size);
+}
+
+bool mcu_runtime_config_parse_capability_query(const uint8_t *packet, bool *apply,
+                                               uint32_t *features) {
+    if (packet[0] != USB_CAPABILITY_QUERY_START_BYTE ||
+        usb_calculate_checksum(packet, USB_CAPABILITY_QUERY_PACKET_SIZE - 1) !=
+            packet[USB_CAPABILITY_QUERY_PACKET_SIZE - 1]) {
+        return false;
+    }
+
+    *apply = packet[1] != 0;
+    memcpy(features, &packet[2], sizeof(*features));
+    *features &= MCU_FEATURES_SUPPORTED;
+    return true;
+}
+
+static uint8_t supported_dshot_speeds(void) {
+    static const uint16_t speeds[] = MCU_DSHOT_SPEEDS;
+    uint8_t mask = 0;
+    for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); ++i) {
+        if (mcu_runtime_config_normalize_dshot_speed(speeds[i]) == speeds[i]) {
+            mask |= (uint8_t)(1u << i);
+        }
+    }
+    return mask;
+}
+
+static void write_u16(uint8_t *data, uint16_t value) {
+    data[0] = (uint8_t)(value & 0xFF);
+    data[1] = (uint8_t)(value >> 8);
+}
+
+void mcu_runtime_config_send_capabilities(uint32_t features) {
+    const uint32_t capabilities = MCU_CAPABILITY_PWM | MCU_CAPABILITY_DSHOT |
+                                  MCU_CAPABILITY_DSHOT_TELEMETRY | MCU_CAPABILITY_TRAJECTORY |
+                                  MCU_CAPABILITY_CLOCK_SYNC | MCU_CAPABILITY_LINK_STATS |
+                                  MCU_CAPABILITY_CAPTURE;
+    uint8_t packet[USB_CAPABILITY_PACKET_SIZE];
+    packet[0] = USB_CAPABILITY_START_BYTE;
+    memcpy(&packet[1], &capabilities, sizeof(capabilities));
+    memcpy(&packet[5], &features, sizeof(features));
+    packet[9] = NUM_MOTORS;
+    packet[10] = supported_dshot_speeds();
+    packet[11] = (uint8_t)((1u << USB_COMMAND_FORMAT_COUNT) - 1);
+    packet[12] = MCU_TELEMETRY_FORMAT_BATCH | MCU_TELEMETRY_FORMAT_TIMED_BATCH;
+    packet[13] = (uint8_t)((1u << (LINK_PROTOCOL_V1 - 1)) | (1u << (LINK_PROTOCOL_V2 - 1)));
+    write_u16(&packet[14], USB_INPUT_PACKET_MAX);
+    write_u16(&packet[16], LINK_TX_QUEUE_SIZE);
+    write_u16(&packet[18], TELEMETRY_QUEUE_CAPACITY);
+    packet[20] = TRAJECTORY_QUEUE_POINTS;
+    packet[USB_CAPABILITY_PACKET_SIZE - 1] =
+        usb_calculate_checksum(packet, USB_CAPABILITY_PACKET_SIZE - 1);
+    link_tx_send(LINK_STREAM_CONTROL, packet, sizeof(packet));
 }
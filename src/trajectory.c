@@ -0,0 +1,149 @@
+#include "trajectory.h"
+#include "motors.h"
+#include "usb_comm.h"
+#include <pico/time.h>
+#include <pico/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t at_us;
+    uint16_t value;
+} trajectory_point_t;
+
+/* Points in time order, oldest at first */
+typedef struct {
+    trajectory_point_t points[TRAJECTORY_QUEUE_POINTS];
+    uint8_t first;
+    uint8_t count;
+} trajectory_queue_t;
+
+static trajectory_queue_t queues[NUM_MOTORS];
+static uint32_t queued_points;
+static trajectory_stats_t stats;
+
+/* Signed, so times compare correctly across the 32-bit wrap */
+static int32_t time_after_us(uint32_t at_us, uint32_t now_us) {
+    return (int32_t)(at_us - now_us);
+}
+
+static trajectory_point_t *queue_at(trajectory_queue_t *queue, uint8_t index) {
+    return &queue->points[(queue->first + index) % TRAJECTORY_QUEUE_POINTS];
+}
+
+/* Drop the queued points due at or after at_us */
+static void queue_truncate(trajectory_queue_t *queue, uint32_t at_us) {
+    while (queue->count > 0 &&
+           time_after_us(queue_at(queue, (uint8_t)(queue->count - 1))->at_us, at_us) >= 0) {
+        queue->count--;
+        queued_points--;
+    }
+}
+
+static int mask_motors(uint8_t mask) {
+    int motors = 0;
+    for (int i = 0; i < NUM_MOTORS; ++i) {
+        motors += (mask >> i) & 1;
+    }
+    return motors;
+}
+
+static uint16_t read_u16(const uint8_t *data) {
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+bool trajectory_parse_packet(const uint8_t *packet, absolute_time_t now) {
+    uint8_t mask = packet[1];
+    uint8_t count = packet[2];
+    int motors = mask_motors(mask);
+    size_t packet_size = TRAJECTORY_PACKET_SIZE(motors, count);
+    if (packet[0] != TRAJECTORY_START_BYTE || (mask >> NUM_MOTORS) != 0 ||
+        packet_size > USB_INPUT_PACKET_MAX ||
+        usb_calculate_checksum(packet, packet_size - 1) != packet[packet_size - 1]) {
+        return false;
+    }
+
+    uint32_t start_us;
+    memcpy(&start_us, &packet[3], sizeof(start_us));
+    uint32_t now_us = (uint32_t)to_us_since_boot(now);
+    const uint8_t *point = &packet[TRAJECTORY_HEADER_SIZE];
+    size_t point_size = 2 + ((size_t)motors * 2);
+    for (uint8_t i = 0; i < count; ++i) {
+        uint16_t offset_us = read_u16(&point[i * point_size]);
+        if (i > 0 && offset_us <= read_u16(&point[(i - 1) * point_size])) {
+            return false;
+        }
+        if (time_after_us(start_us + offset_us, now_us) > USB_COMM_TIMEOUT_MS * 1000) {
+            return false;
+        }
+    }
+
+    int slot = 0;
+    for (int motor = 0; motor < NUM_MOTORS; ++motor) {
+        if (((mask >> motor) & 1) == 0) {
+            continue;
+        }
+        trajectory_queue_t *queue = &queues[motor];
+        queue_truncate(queue, start_us);
+        for (uint8_t i = 0; i < count; ++i) {
+            const uint8_t *entry = &point[i * point_size];
+            uint32_t at_us = start_us + read_u16(entry);
+            if (queue->count == TRAJECTORY_QUEUE_POINTS) {
+                stats.points_dropped += (uint32_t)(count - i);
+                break;
+            }
+            trajectory_point_t *queued = queue_at(queue, queue->count);
+            queued->at_us = at_us;
+            queued->value = read_u16(&entry[2 + (slot * 2)]);
+            queue->count++;
+            queued_points++;
+            stats.points_queued++;
+            stats.points_late += time_after_us(at_us, now_us) < 0;
+        }
+        slot++;
+    }
+    return true;
+}
+
+void trajectory_apply(absolute_time_t now, uint16_t *values) {
+    if (queued_points == 0) {
+        return;
+    }
+
+    uint32_t now_us = (uint32_t)to_us_since_boot(now);
+    for (int motor = 0; motor < NUM_MOTORS; ++motor) {
+        trajectory_queue_t *queue = &queues[motor];
+        while (queue->count > 0 && time_after_us(queue_at(queue, 0)->at_us, now_us) <= 0) {
+            values[motor] = queue_at(queue, 0)->value;
+            queue->first = (uint8_t)((queue->first + 1) % TRAJECTORY_QUEUE_POINTS);
+            queue->count--;
+            queued_points--;
+        }
+    }
+}
+
+void trajectory_clear(void) {
+    if (queued_points == 0) {
+        return;
+    }
+    for (int motor = 0; motor < NUM_MOTORS; ++motor) {
+        queues[motor].count = 0;
+    }
+    queued_points = 0;
+}
+
+bool trajectory_pending(void) {
+    return queued_points > 0;
+}
+
+const trajectory_stats_t *trajectory_stats(void) {
+    return &stats;
+}
+
+void trajectory_reset(void) {
+    memset(queues, 0, sizeof(queues));
+    queued_points = 0;
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,59 @@
+/*
+ * Timed setpoints from the host, applied on the MCU clock.
+ *
+ * A trajectory packet carries a short run of future setpoints for some of the
+ * motors. Each motor queues its points, and the main loop applies the newest
+ * due point just before it sends the next frame, so actuation follows the MCU
+ * clock rather than the host's scheduling and the host can send several
+ * setpoints in one transfer.
+ *
+ * Packet format (variable length, little-endian):
+ *   [0x5E] [motor_mask] [point_count] [start_us:4]
+ *   point_count x ([offset_us:2] [value:2 per motor in the mask]) [xor_checksum]
+ *
+ * start_us is MCU time, the low 32 bits of get_absolute_time() in µs, as
+ * sent in the link stats packet (src/usb_comm.h). Point i is due at
+ * start_us + offset_us; offsets must rise. A packet replaces the queued points
+ * of its motors from start_us on, so one without points cancels them. Points
+ * more than USB_COMM_TIMEOUT_MS ahead are refused, since the link would time
+ * out before they are due.
+ *
+ * A command packet or a link timeout clears every queue.
+ */
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <pico/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRAJECTORY_START_BYTE 0x5E
+#define TRAJECTORY_HEADER_SIZE 7
+#define TRAJECTORY_PACKET_SIZE(motors, points)                                                     \
+    (TRAJECTORY_HEADER_SIZE + ((points) * (2 + ((motors) * 2))) + 1)
+
+/* Per motor */
+#ifndef TRAJECTORY_QUEUE_POINTS
+#define TRAJECTORY_QUEUE_POINTS 32
+#endif
+
+typedef struct {
+    uint32_t points_queued;
+    uint32_t points_late;    /* Already due when they arrived */
+    uint32_t points_dropped; /* Did not fit in their motor's queue */
+} trajectory_stats_t;
+
+/* Queue the points of a trajectory packet; false if it is malformed or reaches too far ahead */
+bool trajectory_parse_packet(const uint8_t *packet, absolute_time_t now);
+/* Set each motor with a due point to the newest one, dropping the points it passes */
+void trajectory_apply(absolute_time_t now, uint16_t *values);
+void trajectory_clear(void);
+bool trajectory_pending(void);
+
+const trajectory_stats_t *trajectory_stats(void);
+/* Clear the queues and the stats */
+void trajectory_reset(void);
+
+#endif
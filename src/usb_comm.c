@@ -1,12 +1,28 @@
 #include "usb_comm.h"
+#include "clock_sync.h"
+#include "link/frame.h"
+#include "link/transport.h"
+#include "link/tx.h"
 #include "log.h"
-#include <pico/error.h>
-#include <pico/stdio.h>
+#include "runtime_config.h"
+#include "trajectory.h"
 #include <pico/time.h>
 #include <pico/types.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+
+static usb_link_stats_t link_stats;
+static uint8_t rx_ring[USB_RX_RING_SIZE];
+static uint32_t rx_head;
+static uint32_t rx_tail;
+static usb_packet_kind_t rx_held_kind = USB_PACKET_NONE;
+static uint8_t rx_held_command[USB_INPUT_PACKET_MAX];
+static usb_command_format_t rx_command_format = USB_COMMAND_FORMAT_FULL;
+static link_protocol_t rx_protocol = LINK_PROTOCOL_V1;
+static bool rx_sequence_valid;
+static uint8_t rx_next_sequence;
 
 uint8_t usb_calculate_checksum(const uint8_t *data, size_t len) {
     uint8_t checksum = 0;
@@ -16,46 +32,413 @@ uint8_t usb_calculate_checksum(const uint8_t *data, size_t len) {
     return checksum;
 }
 
-usb_packet_kind_t usb_poll_multi(uint8_t *command_buf, size_t command_packet_size,
-                                 size_t *command_idx, uint8_t *config_buf,
-                                 size_t config_packet_size, size_t *config_idx) {
-    int c = getchar_timeout_us(0);
-    while (c != PICO_ERROR_TIMEOUT) {
-        uint8_t byte = (uint8_t)c;
-
-        if (*command_idx > 0) {
-            if (*command_idx < command_packet_size) {
-                command_buf[(*command_idx)++] = byte;
-            } else {
-                *command_idx = 0;
-            }
+/* Bytes buffered in the receive ring, as free-running counters indexed modulo its size */
+static uint32_t rx_available(void) {
+    return rx_head - rx_tail;
+}
 
-            if (*command_idx >= command_packet_size) {
-                return USB_PACKET_COMMAND;
-            }
-        } else if (*config_idx > 0) {
-            if (*config_idx < config_packet_size) {
-                config_buf[(*config_idx)++] = byte;
-            } else {
-                *config_idx = 0;
+/* Move everything the transport has buffered into the ring, one contiguous span per read */
+static void rx_fill(void) {
+    while (rx_available() < USB_RX_RING_SIZE) {
+        uint32_t offset = rx_head % USB_RX_RING_SIZE;
+        uint32_t space = USB_RX_RING_SIZE - rx_available();
+        if (space > USB_RX_RING_SIZE - offset) {
+            space = USB_RX_RING_SIZE - offset;
+        }
+
+        size_t count = link_read(&rx_ring[offset], space);
+        if (count == 0) {
+            return;
+        }
+        rx_head += (uint32_t)count;
+    }
+}
+
+static const uint8_t command_start_bytes[USB_COMMAND_FORMAT_COUNT] = {
+    [USB_COMMAND_FORMAT_FULL] = USB_INPUT_START_BYTE,
+    [USB_COMMAND_FORMAT_PACKED] = USB_INPUT_PACKED_START_BYTE,
+    [USB_COMMAND_FORMAT_CHANGED] = USB_INPUT_CHANGED_START_BYTE,
+    [USB_COMMAND_FORMAT_DELTA] = USB_INPUT_DELTA_START_BYTE,
+};
+
+/* Start byte of the chosen command format, kept apart for the byte scan */
+static uint8_t rx_command_start_byte = USB_INPUT_START_BYTE;
+
+static usb_packet_kind_t packet_kind(uint8_t start_byte) {
+    if (start_byte == USB_INPUT_START_BYTE || start_byte == rx_command_start_byte) {
+        return USB_PACKET_COMMAND;
+    }
+    if (start_byte == USB_CONFIG_START_BYTE) {
+        return USB_PACKET_CONFIG;
+    }
+    if (start_byte == TRAJECTORY_START_BYTE) {
+        return USB_PACKET_TRAJECTORY;
+    }
+    if (start_byte == CLOCK_SYNC_PING_START_BYTE) {
+        return USB_PACKET_CLOCK_SYNC;
+    }
+    if (start_byte == USB_CAPABILITY_QUERY_START_BYTE) {
+        return USB_PACKET_CAPABILITY_QUERY;
+    }
+    return start_byte == USB_LINK_PROTOCOL_START_BYTE ? USB_PACKET_LINK_PROTOCOL
+                                                      : USB_PACKET_NONE;
+}
+
+/* Drop bytes up to the next start byte; returns false if the ring runs out first */
+static bool rx_skip_to_start_byte(void) {
+    while (rx_available() > 0) {
+        uint32_t offset = rx_tail % USB_RX_RING_SIZE;
+        uint32_t span = USB_RX_RING_SIZE - offset;
+        if (span > rx_available()) {
+            span = rx_available();
+        }
+
+        uint32_t skipped = 0;
+        while (skipped < span && rx_ring[offset + skipped] != USB_INPUT_START_BYTE &&
+               rx_ring[offset + skipped] != USB_CONFIG_START_BYTE &&
+               rx_ring[offset + skipped] != USB_LINK_PROTOCOL_START_BYTE &&
+               rx_ring[offset + skipped] != TRAJECTORY_START_BYTE &&
+               rx_ring[offset + skipped] != CLOCK_SYNC_PING_START_BYTE &&
+               rx_ring[offset + skipped] != USB_CAPABILITY_QUERY_START_BYTE &&
+               rx_ring[offset + skipped] != rx_command_start_byte) {
+            skipped++;
+        }
+        rx_tail += skipped;
+        link_stats.bytes_discarded += skipped;
+        if (skipped < span) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Motors set in a CHANGED packet's mask; bits past the last motor are ignored */
+static size_t changed_motors(const uint8_t *mask, int num_motors) {
+    size_t count = 0;
+    for (int i = 0; i < num_motors; ++i) {
+        count += (mask[i / 8] >> (i % 8)) & 1u;
+    }
+    return count;
+}
+
+/*
+ * Size of the command packet that starts with head_len bytes at head, or 0
+ * if it is none. A CHANGED packet needs its mask: SIZE_MAX until head has it.
+ */
+static size_t command_size(const uint8_t *head, size_t head_len, int num_motors) {
+    switch (head[0]) {
+    case USB_INPUT_START_BYTE:
+        return USB_INPUT_PACKET_SIZE(num_motors);
+    case USB_INPUT_PACKED_START_BYTE:
+        return USB_INPUT_PACKED_PACKET_SIZE(num_motors);
+    case USB_INPUT_CHANGED_START_BYTE:
+        if (head_len < (size_t)(1 + USB_INPUT_MASK_SIZE(num_motors))) {
+            return SIZE_MAX;
+        }
+        return USB_INPUT_CHANGED_PACKET_SIZE(num_motors, changed_motors(&head[1], num_motors));
+    case USB_INPUT_DELTA_START_BYTE:
+        return USB_INPUT_DELTA_PACKET_SIZE(num_motors);
+    default:
+        return 0;
+    }
+}
+
+/* The motor count follows from the size of a full command packet */
+static int command_motors(size_t command_packet_size) {
+    return (int)((command_packet_size - 2) / 2);
+}
+
+static uint8_t rx_at(uint32_t index) {
+    return rx_ring[(rx_tail + index) % USB_RX_RING_SIZE];
+}
+
+static void rx_copy_at(uint32_t index, uint8_t *dest, size_t len) {
+    uint32_t offset = (rx_tail + index) % USB_RX_RING_SIZE;
+    size_t first = USB_RX_RING_SIZE - offset;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(dest, &rx_ring[offset], first);
+    memcpy(dest + first, rx_ring, len - first);
+}
+
+/* As command_size(), for a trajectory packet; 0 if it is longer than any input packet */
+static size_t trajectory_size(const uint8_t *head, size_t head_len) {
+    if (head_len < 3) {
+        return SIZE_MAX;
+    }
+    int motors = 0;
+    for (uint8_t mask = head[1]; mask != 0; mask >>= 1) {
+        motors += mask & 1;
+    }
+    size_t size = TRAJECTORY_PACKET_SIZE(motors, (size_t)head[2]);
+    return size <= USB_INPUT_PACKET_MAX ? size : 0;
+}
+
+/* As command_size(), for any packet usb_poll_multi() accepts */
+static size_t packet_size(const uint8_t *head, size_t head_len, size_t command_packet_size,
+                          size_t config_packet_size) {
+    switch (packet_kind(head[0])) {
+    case USB_PACKET_COMMAND:
+        return command_size(head, head_len, command_motors(command_packet_size));
+    case USB_PACKET_TRAJECTORY:
+        return trajectory_size(head, head_len);
+    case USB_PACKET_CONFIG:
+        return config_packet_size;
+    case USB_PACKET_LINK_PROTOCOL:
+        return USB_LINK_PROTOCOL_PACKET_SIZE;
+    case USB_PACKET_CLOCK_SYNC:
+        return CLOCK_SYNC_PING_PACKET_SIZE;
+    case USB_PACKET_CAPABILITY_QUERY:
+        return USB_CAPABILITY_QUERY_PACKET_SIZE;
+    default:
+        return 0;
+    }
+}
+
+/* Config and link protocol packets go to config_buf, the others to command_buf */
+static bool in_command_buf(usb_packet_kind_t kind) {
+    return kind != USB_PACKET_CONFIG && kind != USB_PACKET_LINK_PROTOCOL;
+}
+
+static uint8_t *packet_buffer(usb_packet_kind_t kind, uint8_t *command_buf, uint8_t *config_buf) {
+    return in_command_buf(kind) ? command_buf : config_buf;
+}
+
+static usb_packet_kind_t count_packet(usb_packet_kind_t kind) {
+    if (kind == USB_PACKET_COMMAND || kind == USB_PACKET_TRAJECTORY) {
+        link_stats.command_packets++;
+    } else {
+        link_stats.config_packets++;
+    }
+    return kind;
+}
+
+static usb_packet_kind_t poll_v1(uint8_t *command_buf, size_t command_packet_size,
+                                 uint8_t *config_buf, size_t config_packet_size) {
+    while (rx_skip_to_start_byte()) {
+        uint8_t start_byte = rx_at(0);
+        usb_packet_kind_t kind = packet_kind(start_byte);
+        uint8_t *packet = packet_buffer(kind, command_buf, config_buf);
+        size_t size;
+        if (start_byte == USB_INPUT_CHANGED_START_BYTE || kind == USB_PACKET_TRAJECTORY) {
+            /* Its size depends on the bytes after the start byte */
+            uint8_t head[1 + USB_INPUT_MASK_SIZE(USB_RX_FRAME_MAX)];
+            size_t head_len = rx_available() < sizeof(head) ? rx_available() : sizeof(head);
+            rx_copy_at(0, head, head_len);
+            size = packet_size(head, head_len, command_packet_size, config_packet_size);
+        } else {
+            size = packet_size(&start_byte, 1, command_packet_size, config_packet_size);
+        }
+        if (size == SIZE_MAX || rx_available() < size) {
+            return USB_PACKET_NONE;
+        }
+        if (size == 0) {
+            link_stats.bytes_discarded++;
+            rx_tail++;
+            continue;
+        }
+
+        rx_copy_at(0, packet, size);
+        if (usb_calculate_checksum(packet, size - 1) == packet[size - 1]) {
+            rx_tail += (uint32_t)size;
+            return count_packet(kind);
+        }
+
+        /* A start byte inside a damaged packet may begin the next good one */
+        link_stats.checksum_errors++;
+        rx_tail++;
+    }
+    return USB_PACKET_NONE;
+}
+
+/*
+ * A v1 host that finds the link in v2 starts with a config or link protocol
+ * packet. The first `len` bytes of input that does not decode as a frame are
+ * searched for one; if found, the link returns to v1 with the packet next in
+ * the ring.
+ */
+static bool rx_find_v1_control_packet(uint32_t len, size_t config_packet_size) {
+    uint8_t packet[USB_RX_FRAME_MAX];
+
+    for (uint32_t i = 0; i < len; ++i) {
+        uint8_t start_byte = rx_at(i);
+        usb_packet_kind_t kind = packet_kind(start_byte);
+        if (kind != USB_PACKET_CONFIG && kind != USB_PACKET_LINK_PROTOCOL) {
+            continue;
+        }
+        size_t size = packet_size(&start_byte, 1, 0, config_packet_size);
+        if (size > sizeof(packet) || i + size > rx_available()) {
+            continue;
+        }
+        rx_copy_at(i, packet, size);
+        if (usb_calculate_checksum(packet, size - 1) == packet[size - 1]) {
+            link_stats.bytes_discarded += i;
+            rx_tail += i;
+            usb_set_link_protocol(LINK_PROTOCOL_V1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void track_sequence(uint8_t sequence) {
+    if (rx_sequence_valid && sequence != rx_next_sequence) {
+        link_stats.sequence_gaps += (uint8_t)(sequence - rx_next_sequence);
+    }
+    rx_next_sequence = (uint8_t)(sequence + 1);
+    rx_sequence_valid = true;
+}
+
+static usb_packet_kind_t poll_v2(uint8_t *command_buf, size_t command_packet_size,
+                                 uint8_t *config_buf, size_t config_packet_size) {
+    while (rx_available() > 0) {
+        /* A frame's first COBS code is at most USB_RX_FRAME_MAX + 1, below both start bytes */
+        if (rx_find_v1_control_packet(1, config_packet_size)) {
+            return USB_PACKET_NONE;
+        }
+
+        uint32_t len = 0;
+        while (len < rx_available() && len <= USB_RX_FRAME_MAX &&
+               rx_at(len) != LINK_FRAME_DELIMITER) {
+            len++;
+        }
+        if (len > USB_RX_FRAME_MAX) {
+            if (rx_find_v1_control_packet(len, config_packet_size)) {
+                return USB_PACKET_NONE;
             }
+            link_stats.bytes_discarded += len;
+            rx_tail += len;
+            continue;
+        }
+        if (len == rx_available()) {
+            return USB_PACKET_NONE;
+        }
 
-            if (*config_idx >= config_packet_size) {
-                return USB_PACKET_CONFIG;
+        uint8_t frame[USB_RX_FRAME_MAX];
+        uint8_t packet[USB_RX_FRAME_MAX];
+        size_t packet_len = 0;
+        uint8_t sequence = 0;
+        rx_copy_at(0, frame, len);
+        bool decoded = len > 0 && link_frame_decode(frame, len, &sequence, packet, &packet_len);
+        usb_packet_kind_t kind =
+            decoded && packet_len > 0 ? packet_kind(packet[0]) : USB_PACKET_NONE;
+        size_t size = kind != USB_PACKET_NONE ? packet_size(packet, packet_len, command_packet_size,
+                                                            config_packet_size)
+                                              : 0;
+        if (kind == USB_PACKET_NONE || packet_len + 1 != size) {
+            if (len > 0 && rx_find_v1_control_packet(len, config_packet_size)) {
+                return USB_PACKET_NONE;
             }
-        } else if (byte == USB_INPUT_START_BYTE) {
-            command_buf[0] = byte;
-            *command_idx = 1;
-        } else if (byte == USB_CONFIG_START_BYTE) {
-            config_buf[0] = byte;
-            *config_idx = 1;
+            link_stats.checksum_errors += len > 0;
+            rx_tail += len + 1;
+            continue;
         }
 
-        c = getchar_timeout_us(0);
+        rx_tail += len + 1;
+        track_sequence(sequence);
+        uint8_t *dest = packet_buffer(kind, command_buf, config_buf);
+        memcpy(dest, packet, packet_len);
+        dest[packet_len] = usb_calculate_checksum(packet, packet_len);
+        return count_packet(kind);
     }
     return USB_PACKET_NONE;
 }
 
+usb_packet_kind_t usb_poll_multi(uint8_t *command_buf, size_t command_packet_size,
+                                 uint8_t *config_buf, size_t config_packet_size) {
+    rx_fill();
+
+    if (rx_protocol == LINK_PROTOCOL_V2) {
+        usb_packet_kind_t kind =
+            poll_v2(command_buf, command_packet_size, config_buf, config_packet_size);
+        if (kind != USB_PACKET_NONE || rx_protocol == LINK_PROTOCOL_V2) {
+            return kind;
+        }
+    }
+    return poll_v1(command_buf, command_packet_size, config_buf, config_packet_size);
+}
+
+/* FULL and PACKED packets set every motor, so an older command can be skipped for them */
+static bool command_sets_all_motors(const uint8_t *packet) {
+    return packet[0] == USB_INPUT_START_BYTE || packet[0] == USB_INPUT_PACKED_START_BYTE;
+}
+
+usb_packet_kind_t usb_poll_latest(uint8_t *command_buf, size_t command_packet_size,
+                                  uint8_t *config_buf, size_t config_packet_size) {
+    usb_packet_kind_t kind = rx_held_kind;
+    rx_held_kind = USB_PACKET_NONE;
+    if (kind != USB_PACKET_NONE && in_command_buf(kind)) {
+        size_t size = packet_size(rx_held_command, sizeof(rx_held_command), command_packet_size,
+                                  config_packet_size);
+        memcpy(command_buf, rx_held_command, size);
+    } else if (kind == USB_PACKET_NONE) {
+        kind = usb_poll_multi(command_buf, command_packet_size, config_buf, config_packet_size);
+    }
+    if (kind != USB_PACKET_COMMAND) {
+        return kind;
+    }
+
+    /* Newer commands that set every motor replace command_buf; other packets wait */
+    while (true) {
+        usb_packet_kind_t next =
+            usb_poll_multi(rx_held_command, command_packet_size, config_buf, config_packet_size);
+        if (next == USB_PACKET_COMMAND && command_sets_all_motors(rx_held_command)) {
+            size_t size = command_size(rx_held_command, sizeof(rx_held_command),
+                                       command_motors(command_packet_size));
+            memcpy(command_buf, rx_held_command, size);
+            link_stats.stale_commands++;
+            continue;
+        }
+        rx_held_kind = next;
+        return USB_PACKET_COMMAND;
+    }
+}
+
+bool usb_set_link_protocol(uint8_t version) {
+    if (version != LINK_PROTOCOL_V1 && version != LINK_PROTOCOL_V2) {
+        return false;
+    }
+    rx_protocol = (link_protocol_t)version;
+    rx_sequence_valid = false;
+    link_tx_set_protocol(rx_protocol);
+    return true;
+}
+
+link_protocol_t usb_link_protocol(void) {
+    return rx_protocol;
+}
+
+static void parse_packed(const uint8_t *values, uint16_t *raw_values, int num_motors) {
+    for (int i = 0; i < num_motors; ++i) {
+        const uint8_t *pair = &values[(i / 2) * 3];
+        raw_values[i] = (i % 2 == 0) ? (uint16_t)(pair[0] | ((pair[1] & 0x0F) << 8))
+                                     : (uint16_t)((pair[1] >> 4) | (pair[2] << 4));
+    }
+}
+
+static void parse_changed(const uint8_t *mask, uint16_t *raw_values, int num_motors) {
+    const uint8_t *value = &mask[USB_INPUT_MASK_SIZE(num_motors)];
+    for (int i = 0; i < num_motors; ++i) {
+        if ((mask[i / 8] >> (i % 8)) & 1u) {
+            raw_values[i] = (uint16_t)(value[0] | (value[1] << 8));
+            value += 2;
+        }
+    }
+}
+
+static void parse_delta(const uint8_t *deltas, uint16_t *raw_values, int num_motors) {
+    for (int i = 0; i < num_motors; ++i) {
+        int32_t value = (int32_t)raw_values[i] + (int8_t)deltas[i];
+        if (value < 0) {
+            value = 0;
+        } else if (value > USB_COMMAND_VALUE_MAX) {
+            value = USB_COMMAND_VALUE_MAX;
+        }
+        raw_values[i] = (uint16_t)value;
+    }
+}
+
 bool usb_parse_packet(const uint8_t *usb_buf, size_t packet_size, uint16_t *raw_values,
                       int num_motors, absolute_time_t *last_comm_time) {
     if (usb_buf[0] != USB_INPUT_START_BYTE) {
@@ -75,16 +458,88 @@ bool usb_parse_packet(const uint8_t *usb_buf, size_t packet_size, uint16_t *raw_
     return true;
 }
 
+bool usb_apply_command(const uint8_t *usb_buf, uint16_t *raw_values, int num_motors,
+                       absolute_time_t *last_comm_time) {
+    if (usb_buf[0] == USB_INPUT_START_BYTE) {
+        return usb_parse_packet(usb_buf, USB_INPUT_PACKET_SIZE(num_motors), raw_values,
+                                num_motors, last_comm_time);
+    }
+
+    size_t packet_size = command_size(usb_buf, SIZE_MAX, num_motors);
+    if (packet_size == 0 ||
+        usb_calculate_checksum(usb_buf, packet_size - 1) != usb_buf[packet_size - 1]) {
+        return false;
+    }
+
+    if (usb_buf[0] == USB_INPUT_PACKED_START_BYTE) {
+        parse_packed(&usb_buf[1], raw_values, num_motors);
+    } else if (usb_buf[0] == USB_INPUT_CHANGED_START_BYTE) {
+        parse_changed(&usb_buf[1], raw_values, num_motors);
+    } else {
+        parse_delta(&usb_buf[1], raw_values, num_motors);
+    }
+    *last_comm_time = get_absolute_time();
+    return true;
+}
+
+void usb_set_command_format(usb_command_format_t format) {
+    rx_command_format = format < USB_COMMAND_FORMAT_COUNT ? format : USB_COMMAND_FORMAT_FULL;
+    rx_command_start_byte = command_start_bytes[rx_command_format];
+}
+
+usb_command_format_t usb_command_format(void) {
+    return rx_command_format;
+}
+
 void usb_check_timeout(absolute_time_t last_comm_time, uint16_t *thruster_values, int num_motors,
-                       uint16_t neutral_value, size_t *usb_idx, bool *comm_timed_out) {
+                       uint16_t neutral_value, bool *comm_timed_out) {
     if (absolute_time_diff_us(last_comm_time, get_absolute_time()) > USB_COMM_TIMEOUT_MS * 1000) {
         for (int i = 0; i < num_motors; ++i) {
             thruster_values[i] = neutral_value;
         }
-        *usb_idx = 0;
         if (!*comm_timed_out) {
             *comm_timed_out = true;
             log_warn("USB comm lost, motors neutral");
         }
     }
 }
+
+const usb_link_stats_t *usb_link_stats(void) {
+    return &link_stats;
+}
+
+void usb_comm_reset(void) {
+    rx_head = 0;
+    rx_tail = 0;
+    rx_held_kind = USB_PACKET_NONE;
+    usb_set_command_format(USB_COMMAND_FORMAT_FULL);
+    memset(&link_stats, 0, sizeof(link_stats));
+    usb_set_link_protocol(LINK_PROTOCOL_V1);
+}
+
+void usb_link_stats_send(void) {
+    uint8_t packet[USB_LINK_STATS_PACKET_SIZE];
+    packet[0] = USB_LINK_STATS_START_BYTE;
+    memcpy(&packet[1], &link_stats.command_packets, sizeof(uint32_t));
+    memcpy(&packet[5], &link_stats.config_packets, sizeof(uint32_t));
+    memcpy(&packet[9], &link_stats.checksum_errors, sizeof(uint32_t));
+    memcpy(&packet[13], &link_stats.bytes_discarded, sizeof(uint32_t));
+    memcpy(&packet[17], &link_tx_stats()->bytes_written, sizeof(uint32_t));
+    memcpy(&packet[21], &link_tx_stats()->write_time_us, sizeof(uint32_t));
+    for (int stream = 0; stream < LINK_STREAM_COUNT; ++stream) {
+        uint32_t dropped = link_tx_dropped((link_stream_t)stream);
+        memcpy(&packet[25 + (stream * 4)], &dropped, sizeof(uint32_t));
+    }
+    memcpy(&packet[41], &link_stats.sequence_gaps, sizeof(uint32_t));
+    memcpy(&packet[45], &link_stats.stale_commands, sizeof(uint32_t));
+    uint32_t time_us = (uint32_t)to_us_since_boot(get_absolute_time());
+    memcpy(&packet[49], &time_us, sizeof(uint32_t));
+    memcpy(&packet[53], &trajectory_stats()->points_late, sizeof(uint32_t));
+    memcpy(&packet[57], &trajectory_stats()->points_dropped, sizeof(uint32_t));
+    memcpy(&packet[61], &clock_sync_stats()->rtt_min_us, sizeof(uint32_t));
+    memcpy(&packet[65], &clock_sync_stats()->rtt_mean_us, sizeof(uint32_t));
+    memcpy(&packet[69], &clock_sync_stats()->rtt_max_us, sizeof(uint32_t));
+    packet[USB_LINK_STATS_PACKET_SIZE - 1] =
+        usb_calculate_checksum(packet, USB_LINK_STATS_PACKET_SIZE - 1);
+    link_tx_send(LINK_STREAM_CONTROL, packet, USB_LINK_STATS_PACKET_SIZE);
+}
@@ -4,6 +4,7 @@
 #include <hardware/pio.h>
 
 static const struct pio_program pio_dshot_program = {.length = 0};
+static const struct pio_program pio_dshot_edge_program = {.length = 0};
 
 static inline pio_sm_config pio_dshot_program_get_default_config(uint offset) {
     (void)offset;
@@ -11,4 +12,10 @@ static inline pio_sm_config pio_dshot_program_get_default_config(uint offset) {
     return c;
 }
 
+static inline pio_sm_config pio_dshot_edge_program_get_default_config(uint offset) {
+    (void)offset;
+    pio_sm_config c = {0};
+    return c;
+}
+
 #endif
@@ -3,7 +3,8 @@
 
 #include "../mock_sdk.h"
 
-#define GPIO_FUNC_SIO 0
+#define GPIO_FUNC_PWM 4
+#define GPIO_FUNC_SIO 5
 #define GPIO_OUT 1
 
 typedef uint mock_gpio_uint_t;
@@ -6,11 +6,8 @@
 typedef PIO mock_pio_handle_t;
 typedef pio_sm_config mock_pio_sm_config_t;
 
-static mock_pio_instance mock_pio0_instance;
-static mock_pio_instance mock_pio1_instance;
-
-#define pio0 (&mock_pio0_instance)
-#define pio1 (&mock_pio1_instance)
+#define pio0 (&mock_pio_instances[0])
+#define pio1 (&mock_pio_instances[1])
 
 static inline uint pio_add_program(PIO pio, const struct pio_program *program) {
     (void)pio;
@@ -19,9 +16,8 @@ static inline uint pio_add_program(PIO pio, const struct pio_program *program) {
 }
 
 static inline void sm_config_set_out_pins(pio_sm_config *c, uint pin, uint count) {
-    (void)c;
-    (void)pin;
     (void)count;
+    c->out_base = pin;
 }
 
 static inline void sm_config_set_set_pins(pio_sm_config *c, uint pin, uint count) {
@@ -66,51 +62,18 @@ static inline void sm_config_set_clkdiv(pio_sm_config *c, float div) {
     (void)div;
 }
 
-static inline void pio_sm_init(PIO pio, uint sm, uint offset, const pio_sm_config *config) {
-    (void)pio;
-    (void)sm;
-    (void)offset;
-    (void)config;
-}
-
-static inline void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
-    (void)pio;
-    (void)sm;
-    (void)enabled;
-}
-
-static inline void pio_sm_clear_fifos(PIO pio, uint sm) {
-    (void)pio;
-    (void)sm;
-}
+/* Stateful: implemented in mock_sdk.c */
+void pio_sm_init(PIO pio, uint sm, uint offset, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+uint32_t pio_sm_get(PIO pio, uint sm);
 
 static inline void pio_sm_restart(PIO pio, uint sm) {
     (void)pio;
     (void)sm;
 }
 
-static inline bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm) {
-    (void)pio;
-    (void)sm;
-    return true;
-}
-
-static inline void pio_sm_put(PIO pio, uint sm, uint32_t data) {
-    (void)pio;
-    (void)sm;
-    (void)data;
-}
-
-static inline bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
-    (void)pio;
-    (void)sm;
-    return true;
-}
-
-static inline uint32_t pio_sm_get(PIO pio, uint sm) {
-    (void)pio;
-    (void)sm;
-    return 0;
-}
-
 #endif
@@ -0,0 +1,6 @@
+#ifndef MOCK_HARDWARE_PLATFORM_DEFS_H
+#define MOCK_HARDWARE_PLATFORM_DEFS_H
+
+#define NUM_PWM_SLICES 8
+
+#endif
@@ -5,4 +5,26 @@
 
 typedef uint mock_pwm_uint_t;
 
+static inline uint pwm_gpio_to_slice_num(uint gpio) {
+    return (gpio >> 1u) & 7u;
+}
+
+static inline void pwm_set_clkdiv(uint slice_num, float divider) {
+    (void)slice_num;
+    (void)divider;
+}
+
+static inline void pwm_set_wrap(uint slice_num, uint16_t wrap) {
+    (void)slice_num;
+    (void)wrap;
+}
+
+static inline void pwm_set_enabled(uint slice_num, bool enabled) {
+    (void)slice_num;
+    (void)enabled;
+}
+
+/* Records the level for mock_pwm_gpio_level(): implemented in mock_sdk.c */
+void pwm_set_gpio_level(uint gpio, uint16_t level);
+
 #endif
@@ -0,0 +1,233 @@
+#include "mock_sdk.h"
+#include "hardware/pio.h"
+#include "hardware/pwm.h"
+#include "pico/stdio.h"
+#include "pico/time.h"
+#include <string.h>
+
+struct mock_fifo {
+    uint32_t words[MOCK_PIO_RX_FIFO_CAPACITY];
+    size_t head;
+    size_t count;
+};
+
+struct mock_pio_sm {
+    struct mock_fifo tx;
+    struct mock_fifo rx;
+    bool enabled;
+    uint pin;
+};
+
+mock_pio_instance mock_pio_instances[MOCK_PIO_COUNT] = {{.index = 0}, {.index = 1}};
+
+static uint64_t mock_now_us;
+static struct mock_pio_sm mock_sms[MOCK_PIO_COUNT][MOCK_PIO_SM_COUNT];
+static mock_pio_tx_hook_t mock_tx_hook;
+static void *mock_tx_hook_context;
+static mock_pio_rx_hook_t mock_rx_hook;
+static void *mock_rx_hook_context;
+static uint8_t mock_stdin[MOCK_STDIN_CAPACITY];
+static size_t mock_stdin_head;
+static size_t mock_stdin_count;
+static uint16_t mock_pwm_levels[MOCK_GPIO_COUNT];
+
+static bool mock_fifo_push(struct mock_fifo *fifo, size_t capacity, uint32_t word) {
+    if (fifo->count >= capacity) {
+        return false;
+    }
+    fifo->words[(fifo->head + fifo->count) % MOCK_PIO_RX_FIFO_CAPACITY] = word;
+    fifo->count++;
+    return true;
+}
+
+static bool mock_fifo_pop(struct mock_fifo *fifo, uint32_t *word) {
+    if (fifo->count == 0) {
+        return false;
+    }
+    *word = fifo->words[fifo->head];
+    fifo->head = (fifo->head + 1) % MOCK_PIO_RX_FIFO_CAPACITY;
+    fifo->count--;
+    return true;
+}
+
+static struct mock_pio_sm *mock_sm(PIO pio, uint sm) {
+    return &mock_sms[pio->index][sm];
+}
+
+void mock_sdk_reset(void) {
+    mock_now_us = 0;
+    memset(mock_sms, 0, sizeof(mock_sms));
+    mock_tx_hook = NULL;
+    mock_tx_hook_context = NULL;
+    mock_rx_hook = NULL;
+    mock_rx_hook_context = NULL;
+    mock_stdin_head = 0;
+    mock_stdin_count = 0;
+    memset(mock_pwm_levels, 0, sizeof(mock_pwm_levels));
+}
+
+/* ---- pico/time.h ---- */
+
+uint64_t mock_time_get_us(void) {
+    return mock_now_us;
+}
+
+void mock_time_set_us(uint64_t us) {
+    mock_now_us = us;
+}
+
+void mock_time_advance_us(uint64_t us) {
+    mock_now_us += us;
+}
+
+absolute_time_t get_absolute_time(void) {
+    return mock_now_us;
+}
+
+absolute_time_t make_timeout_time_us(uint64_t us) {
+    return mock_now_us + us;
+}
+
+void sleep_us(uint64_t us) {
+    mock_now_us += us;
+}
+
+void sleep_ms(uint32_t ms) {
+    mock_now_us += (uint64_t)ms * 1000u;
+}
+
+/* ---- pico/stdio.h ---- */
+
+size_t mock_stdin_push(const uint8_t *data, size_t len) {
+    size_t accepted = 0;
+    while (accepted < len && mock_stdin_count < MOCK_STDIN_CAPACITY) {
+        mock_stdin[(mock_stdin_head + mock_stdin_count) % MOCK_STDIN_CAPACITY] = data[accepted++];
+        mock_stdin_count++;
+    }
+    return accepted;
+}
+
+size_t mock_stdin_level(void) {
+    return mock_stdin_count;
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    if (mock_stdin_count == 0) {
+        mock_now_us += timeout_us;
+        return PICO_ERROR_TIMEOUT;
+    }
+    int c = mock_stdin[mock_stdin_head];
+    mock_stdin_head = (mock_stdin_head + 1) % MOCK_STDIN_CAPACITY;
+    mock_stdin_count--;
+    return c;
+}
+
+int stdio_get_until(char *buf, int len, absolute_time_t until) {
+    if (mock_stdin_count == 0) {
+        if (until > mock_now_us) {
+            mock_now_us = until;
+        }
+        return PICO_ERROR_TIMEOUT;
+    }
+
+    int count = 0;
+    while (count < len && mock_stdin_count > 0) {
+        buf[count++] = (char)mock_stdin[mock_stdin_head];
+        mock_stdin_head = (mock_stdin_head + 1) % MOCK_STDIN_CAPACITY;
+        mock_stdin_count--;
+    }
+    return count;
+}
+
+/* ---- hardware/pwm.h ---- */
+
+void pwm_set_gpio_level(uint gpio, uint16_t level) {
+    if (gpio < MOCK_GPIO_COUNT) {
+        mock_pwm_levels[gpio] = level;
+    }
+}
+
+uint16_t mock_pwm_gpio_level(uint gpio) {
+    return gpio < MOCK_GPIO_COUNT ? mock_pwm_levels[gpio] : 0;
+}
+
+/* ---- hardware/pio.h ---- */
+
+bool mock_pio_rx_push(uint pio_index, uint sm, uint32_t word) {
+    return mock_fifo_push(&mock_sms[pio_index][sm].rx, MOCK_PIO_RX_FIFO_CAPACITY, word);
+}
+
+size_t mock_pio_rx_level(uint pio_index, uint sm) {
+    return mock_sms[pio_index][sm].rx.count;
+}
+
+bool mock_pio_tx_pop(uint pio_index, uint sm, uint32_t *word) {
+    return mock_fifo_pop(&mock_sms[pio_index][sm].tx, word);
+}
+
+size_t mock_pio_tx_level(uint pio_index, uint sm) {
+    return mock_sms[pio_index][sm].tx.count;
+}
+
+bool mock_pio_sm_is_enabled(uint pio_index, uint sm) {
+    return mock_sms[pio_index][sm].enabled;
+}
+
+uint mock_pio_sm_pin(uint pio_index, uint sm) {
+    return mock_sms[pio_index][sm].pin;
+}
+
+void mock_pio_set_tx_hook(mock_pio_tx_hook_t hook, void *context) {
+    mock_tx_hook = hook;
+    mock_tx_hook_context = context;
+}
+
+void mock_pio_set_rx_hook(mock_pio_rx_hook_t hook, void *context) {
+    mock_rx_hook = hook;
+    mock_rx_hook_context = context;
+}
+
+void pio_sm_init(PIO pio, uint sm, uint offset, const pio_sm_config *config) {
+    (void)offset;
+    pio_sm_clear_fifos(pio, sm);
+    mock_sm(pio, sm)->enabled = false;
+    mock_sm(pio, sm)->pin = config->out_base;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+    mock_sm(pio, sm)->enabled = enabled;
+}
+
+void pio_sm_clear_fifos(PIO pio, uint sm) {
+    memset(&mock_sm(pio, sm)->tx, 0, sizeof(struct mock_fifo));
+    memset(&mock_sm(pio, sm)->rx, 0, sizeof(struct mock_fifo));
+}
+
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm) {
+    return mock_sm(pio, sm)->tx.count == 0;
+}
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data) {
+    if (mock_tx_hook != NULL) {
+        mock_tx_hook(mock_tx_hook_context, pio->index, sm, data);
+        return;
+    }
+    (void)mock_fifo_push(&mock_sm(pio, sm)->tx, MOCK_PIO_TX_FIFO_DEPTH, data);
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+    if (mock_rx_hook != NULL) {
+        mock_rx_hook(mock_rx_hook_context, pio->index, sm);
+    }
+    if (mock_sm(pio, sm)->rx.count == 0) {
+        mock_now_us += MOCK_FIFO_POLL_US;
+        return true;
+    }
+    return false;
+}
+
+uint32_t pio_sm_get(PIO pio, uint sm) {
+    uint32_t word = 0;
+    (void)mock_fifo_pop(&mock_sm(pio, sm)->rx, &word);
+    return word;
+}
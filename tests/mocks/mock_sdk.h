@@ -2,21 +2,70 @@
 #define TESTS_MOCK_SDK_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef unsigned int uint;
 typedef struct mock_pio_instance {
-    uint32_t dummy;
+    uint index;
 } mock_pio_instance;
 
 typedef struct mock_pio_instance *PIO;
 
 typedef struct {
-    uint32_t dummy;
+    uint out_base;
 } pio_sm_config;
 
 struct pio_program {
     uint16_t length;
 };
 
+/*
+ * Host SDK state (tests/mocks/mock_sdk.c).
+ *
+ * The virtual clock starts at 0 and only moves when code sleeps, polls an
+ * empty RX FIFO (MOCK_FIFO_POLL_US per poll), waits on stdin, or a test
+ * advances it. TX FIFOs hold MOCK_PIO_TX_FIFO_DEPTH words like the hardware;
+ * RX FIFOs are deeper so a test can queue a whole capture up front. A TX hook
+ * stands in for the state machine: when set, it consumes each word as it is
+ * put and may push a response onto the RX FIFO. An RX hook runs on every RX
+ * FIFO poll so a simulated device can deliver a response once it is due.
+ */
+#define MOCK_PIO_COUNT 2
+#define MOCK_PIO_SM_COUNT 4
+#define MOCK_PIO_TX_FIFO_DEPTH 4
+#define MOCK_PIO_RX_FIFO_CAPACITY 32
+#define MOCK_FIFO_POLL_US 1
+#define MOCK_STDIN_CAPACITY 1024
+#define MOCK_GPIO_COUNT 30
+
+typedef void (*mock_pio_tx_hook_t)(void *context, uint pio_index, uint sm, uint32_t word);
+typedef void (*mock_pio_rx_hook_t)(void *context, uint pio_index, uint sm);
+
+extern mock_pio_instance mock_pio_instances[MOCK_PIO_COUNT];
+
+/* Clear the clock, FIFOs, hooks and stdin; call from setUp() */
+void mock_sdk_reset(void);
+
+uint64_t mock_time_get_us(void);
+void mock_time_set_us(uint64_t us);
+void mock_time_advance_us(uint64_t us);
+
+bool mock_pio_rx_push(uint pio_index, uint sm, uint32_t word);
+size_t mock_pio_rx_level(uint pio_index, uint sm);
+bool mock_pio_tx_pop(uint pio_index, uint sm, uint32_t *word);
+size_t mock_pio_tx_level(uint pio_index, uint sm);
+bool mock_pio_sm_is_enabled(uint pio_index, uint sm);
+/* First output pin of the configuration the state machine was last initialized with */
+uint mock_pio_sm_pin(uint pio_index, uint sm);
+void mock_pio_set_tx_hook(mock_pio_tx_hook_t hook, void *context);
+void mock_pio_set_rx_hook(mock_pio_rx_hook_t hook, void *context);
+
+/* Queue bytes for getchar_timeout_us() and stdio_get_until(); returns the number accepted */
+size_t mock_stdin_push(const uint8_t *data, size_t len);
+size_t mock_stdin_level(void);
+
+/* Last level set with pwm_set_gpio_level() */
+uint16_t mock_pwm_gpio_level(uint gpio);
+
 #endif
@@ -1,13 +1,19 @@
 #ifndef MOCK_PICO_STDIO_H
 #define MOCK_PICO_STDIO_H
 
+#include "types.h"
+#include <stdbool.h>
 #include <stdint.h>
 
 #define PICO_ERROR_TIMEOUT (-1)
 
-static inline int getchar_timeout_us(uint32_t timeout_us) {
-    (void)timeout_us;
-    return PICO_ERROR_TIMEOUT;
+static inline bool stdio_init_all(void) {
+    return true;
 }
 
+/* Read bytes queued with mock_stdin_push(): implemented in mock_sdk.c */
+int getchar_timeout_us(uint32_t timeout_us);
+/* Up to len queued bytes; with none, moves the clock to `until` and times out */
+int stdio_get_until(char *buf, int len, absolute_time_t until);
+
 #endif
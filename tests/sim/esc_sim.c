@@ -0,0 +1,485 @@
+#include "esc_sim.h"
+#include "mocks/mock_sdk.h"
+#include <math.h>
+#include <pico/time.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Timing of pio_dshot / pio_dshot_edge; must match dshot.pio and dshot.c */
+#define PIO_CYCLES_PER_TX_BIT 125
+#define PIO_CYCLES_PER_RX_BIT 100
+#define PIO_CYCLES_PER_SAMPLE 18
+#define PIO_CYCLES_PER_EDGE_COUNT 2
+#define OVERSAMPLE_WORDS 4
+#define OVERSAMPLE_SAMPLES (OVERSAMPLE_WORDS * 32)
+#define OVERSAMPLE_RX_POLL_CYCLES 9
+#define OVERSAMPLE_RX_TIMEOUT_CYCLES (32 * OVERSAMPLE_RX_POLL_CYCLES)
+#define EDGE_CAPTURE_RUN_OVERHEAD 1
+#define EDGE_CAPTURE_END_MARKER 0xFF
+#define DSHOT_FRAME_BITS 16
+#define GCR_FRAME_BITS 21
+#define MAX_EDGES (GCR_FRAME_BITS + 2)
+
+#define ERPM_STOPPED_VALUE 0x0FFF
+#define ERPM_MAX_PERIOD_US (0x1FF << 7)
+#define EDT_TYPE_TEMPERATURE 0x2
+#define EDT_TYPE_VOLTAGE 0x4
+#define EDT_TYPE_CURRENT 0x6
+#define EDT_TYPE_STATE_EVENTS 0xE
+#define EDT_VOLTAGE_MV_PER_LSB 250
+
+static const uint8_t gcr_encode_table[16] = {
+    0x19, 0x1B, 0x12, 0x13, 0x1D, 0x15, 0x16, 0x17, 0x1A, 0x09, 0x0A, 0x0B, 0x1E, 0x0D, 0x0E, 0x0F,
+};
+
+static const uint8_t edt_cycle[] = {EDT_TYPE_TEMPERATURE, EDT_TYPE_VOLTAGE, EDT_TYPE_CURRENT};
+
+static uint32_t sim_rand(struct esc_sim_bank *bank) {
+    bank->rng_state ^= bank->rng_state << 13;
+    bank->rng_state ^= bank->rng_state >> 17;
+    bank->rng_state ^= bank->rng_state << 5;
+    return bank->rng_state;
+}
+
+/* Uniform in [0, 1) */
+static double sim_rand_unit(struct esc_sim_bank *bank) {
+    return (double)sim_rand(bank) / 4294967296.0;
+}
+
+static bool sim_chance(struct esc_sim_bank *bank, double percent) {
+    return percent > 0.0 && sim_rand_unit(bank) * 100.0 < percent;
+}
+
+static double pio_cycle_us(const struct esc_sim_bank *bank) {
+    return 1000.0 / ((double)bank->dshot_speed * PIO_CYCLES_PER_TX_BIT);
+}
+
+/* ---- ESC state ---- */
+
+static double target_erpm(const struct esc_sim_bank *bank, const struct esc_sim_esc *esc) {
+    double max_erpm = bank->config.max_erpm;
+    double erpm = 0.0;
+
+    if (esc->throttle >= DSHOT_MAX_COMMAND) {
+        if (!esc->mode_3d) {
+            erpm = max_erpm * (esc->throttle - (DSHOT_MAX_COMMAND - 1)) / 2000.0;
+        } else if (esc->throttle <= 1047) {
+            erpm = -max_erpm * (esc->throttle - (DSHOT_MAX_COMMAND - 1)) / 1000.0;
+        } else {
+            erpm = max_erpm * (esc->throttle - 1047) / 1000.0;
+        }
+    }
+    return esc->reversed ? -erpm : erpm;
+}
+
+static void update_motor(const struct esc_sim_bank *bank, struct esc_sim_esc *esc, uint64_t now) {
+    double dt_ms = (double)(now - esc->last_update_us) / 1000.0;
+    double tau_ms = bank->config.rpm_time_constant_ms > 0 ? bank->config.rpm_time_constant_ms : 1;
+
+    esc->erpm += (target_erpm(bank, esc) - esc->erpm) * (1.0 - exp(-dt_ms / tau_ms));
+    esc->last_update_us = now;
+}
+
+static void apply_command(struct esc_sim_esc *esc, uint16_t command) {
+    switch (command) {
+    case DSHOT_CMD_SPIN_DIRECTION_1:
+    case DSHOT_CMD_SPIN_DIRECTION_NORMAL:
+        esc->reversed = false;
+        break;
+    case DSHOT_CMD_SPIN_DIRECTION_2:
+    case DSHOT_CMD_SPIN_DIRECTION_REVERSED:
+        esc->reversed = true;
+        break;
+    case DSHOT_CMD_3D_MODE_OFF:
+        esc->mode_3d_pending = false;
+        break;
+    case DSHOT_CMD_3D_MODE_ON:
+        esc->mode_3d_pending = true;
+        break;
+    case DSHOT_CMD_SAVE_SETTINGS:
+        esc->mode_3d = esc->mode_3d_pending;
+        esc->stats.settings_saved++;
+        break;
+    case DSHOT_EXTENDED_TELEMETRY_ENABLE:
+        esc->edt_enabled = true;
+        esc->edt_version_due = true;
+        break;
+    case DSHOT_EXTENDED_TELEMETRY_DISABLE:
+        esc->edt_enabled = false;
+        break;
+    default:
+        return;
+    }
+    esc->stats.commands_applied++;
+}
+
+static void receive_value(struct esc_sim_esc *esc, uint16_t value) {
+    if (value == DSHOT_CMD_MOTOR_STOP || value >= DSHOT_MAX_COMMAND) {
+        if (value != esc->throttle) {
+            esc->throttle_changed_us = mock_time_get_us();
+        }
+        esc->throttle = value;
+        esc->last_command = DSHOT_CMD_MOTOR_STOP;
+        esc->command_repeats = 0;
+        return;
+    }
+
+    esc->throttle = DSHOT_CMD_MOTOR_STOP;
+    if (value != esc->last_command) {
+        esc->last_command = value;
+        esc->command_repeats = 0;
+    }
+    if (++esc->command_repeats == ESC_SIM_COMMAND_REPEATS) {
+        apply_command(esc, value);
+    }
+}
+
+/* ---- Telemetry encoding ---- */
+
+static uint16_t encode_erpm(double erpm) {
+    double magnitude = fabs(erpm);
+    if (magnitude < 1.0 || 60000000.0 / magnitude > ERPM_MAX_PERIOD_US) {
+        return ERPM_STOPPED_VALUE;
+    }
+
+    uint32_t period_us = (uint32_t)(60000000.0 / magnitude + 0.5);
+    uint16_t exponent = 0;
+    while ((period_us >> exponent) > 0x1FF) {
+        exponent++;
+    }
+    return (uint16_t)((exponent << 9) | (period_us >> exponent));
+}
+
+static uint16_t next_telemetry_value(const struct esc_sim_bank *bank, struct esc_sim_esc *esc) {
+    const struct esc_sim_config *config = &bank->config;
+
+    if (esc->edt_enabled && esc->edt_version_due) {
+        esc->edt_version_due = false;
+        return (EDT_TYPE_STATE_EVENTS << 8) | ESC_SIM_EDT_VERSION;
+    }
+
+    if (esc->edt_enabled && config->edt_interval > 0 &&
+        ++esc->edt_counter % config->edt_interval == 0) {
+        uint8_t type = edt_cycle[esc->edt_type_index];
+        esc->edt_type_index = (esc->edt_type_index + 1) % sizeof(edt_cycle);
+        switch (type) {
+        case EDT_TYPE_TEMPERATURE:
+            return (EDT_TYPE_TEMPERATURE << 8) | config->temperature_c;
+        case EDT_TYPE_VOLTAGE:
+            return (EDT_TYPE_VOLTAGE << 8) | ((config->voltage_mv / EDT_VOLTAGE_MV_PER_LSB) & 0xFF);
+        default:
+            return (EDT_TYPE_CURRENT << 8) | ((config->current_ma / 1000) & 0xFF);
+        }
+    }
+
+    return encode_erpm(esc->erpm);
+}
+
+static uint32_t encode_gcr20(uint16_t value12) {
+    uint16_t crc = (uint16_t)(~(value12 ^ (value12 >> 4) ^ (value12 >> 8)) & 0x0F);
+    uint16_t word = (uint16_t)((value12 << 4) | crc);
+
+    return ((uint32_t)gcr_encode_table[(word >> 12) & 0x0F] << 15) |
+           ((uint32_t)gcr_encode_table[(word >> 8) & 0x0F] << 10) |
+           ((uint32_t)gcr_encode_table[(word >> 4) & 0x0F] << 5) | gcr_encode_table[word & 0x0F];
+}
+
+/* ---- Line model: edge times in PIO cycles from the first falling edge ---- */
+
+static int build_edges(struct esc_sim_bank *bank, uint32_t gcr20, double *edges,
+                       double *frame_end) {
+    const struct esc_sim_config *config = &bank->config;
+    double bit_cycles = PIO_CYCLES_PER_RX_BIT * (1.0 + (config->clock_skew_pct / 100.0));
+    double jitter_cycles = PIO_CYCLES_PER_RX_BIT * config->edge_jitter_pct / 100.0;
+    uint32_t stream21 = (1u << 20) | gcr20;
+    int edge_count = 0;
+
+    /* NRZI: a 1 bit toggles the line; the first edge starts sampling and defines time zero */
+    for (int bit = 0; bit < GCR_FRAME_BITS; ++bit) {
+        if ((stream21 >> (20 - bit)) & 0x1u) {
+            double jitter = bit == 0 ? 0.0 : ((sim_rand_unit(bank) * 2.0) - 1.0) * jitter_cycles;
+            edges[edge_count++] = (bit * bit_cycles) + jitter;
+        }
+    }
+    *frame_end = GCR_FRAME_BITS * bit_cycles;
+
+    if (sim_chance(bank, config->glitch_pct)) {
+        double start = bit_cycles + (sim_rand_unit(bank) * (*frame_end - (2 * bit_cycles)));
+        edges[edge_count++] = start;
+        edges[edge_count++] = start + PIO_CYCLES_PER_SAMPLE;
+    }
+
+    for (int i = 1; i < edge_count; ++i) {
+        double edge = edges[i];
+        int j = i;
+        for (; j > 0 && edges[j - 1] > edge; --j) {
+            edges[j] = edges[j - 1];
+        }
+        edges[j] = edge;
+    }
+    return edge_count;
+}
+
+/*
+ * Time the PIO starts sampling: the first falling edge at or after the RX
+ * window opens, or the window start itself if the line is already low.
+ * Returns false if the line stays high until the response is over.
+ */
+static bool first_low_time(const double *edges, int edge_count, double window_start,
+                           double *start) {
+    int toggles = 0;
+    while (toggles < edge_count && edges[toggles] <= window_start) {
+        toggles++;
+    }
+    if (toggles & 1) {
+        *start = window_start;
+        return true;
+    }
+    if (toggles < edge_count) {
+        *start = edges[toggles];
+        return true;
+    }
+    return false;
+}
+
+/* pio_dshot: poll for the falling edge for 32 x 9 cycles, then 128 samples 18 cycles apart */
+static int capture_oversampled(struct esc_sim_bank *bank, const double *edges, int edge_count,
+                               double frame_end, double window_start, uint32_t *words) {
+    double start;
+
+    if (!first_low_time(edges, edge_count, window_start, &start) ||
+        start - window_start > OVERSAMPLE_RX_TIMEOUT_CYCLES) {
+        return 0;
+    }
+
+    double poll_phase = sim_rand_unit(bank) * OVERSAMPLE_RX_POLL_CYCLES;
+    memset(words, 0, (OVERSAMPLE_WORDS + 1) * sizeof(*words));
+    for (int sample = 0; sample < OVERSAMPLE_SAMPLES; ++sample) {
+        double t = start + poll_phase + ((double)sample * PIO_CYCLES_PER_SAMPLE);
+        int toggles = 0;
+        for (int edge = 0; edge < edge_count; ++edge) {
+            toggles += edges[edge] <= t;
+        }
+        uint32_t level = (t >= frame_end || (toggles & 1) == 0) ? 1 : 0;
+        words[sample / 32] |= level << (31 - (sample % 32));
+    }
+
+    /* Completion word pushed after the samples */
+    return OVERSAMPLE_WORDS + 1;
+}
+
+/* pio_dshot_edge: count each level from the window start until one exceeds the run limit */
+static int capture_edges(const double *edges, int edge_count, double frame_end,
+                         double window_start, uint32_t run_limit, uint32_t *words) {
+    uint8_t bytes[MAX_EDGES + 2];
+    int byte_count = 0;
+    int next = 0;
+
+    while (next < edge_count && edges[next] <= window_start) {
+        next++;
+    }
+    bool low = next & 1;
+    double run_start = window_start;
+
+    /* Idle run: zero if the window opened mid-response with the line low */
+    if (!low) {
+        double idle = next < edge_count ? edges[next] - window_start : run_limit + 1.0;
+        uint32_t counts = (uint32_t)(idle / PIO_CYCLES_PER_EDGE_COUNT);
+        if (counts >= run_limit) {
+            words[0] = EDGE_CAPTURE_END_MARKER;
+            return 1;
+        }
+        bytes[byte_count++] = (uint8_t)(run_limit - counts);
+        run_start = edges[next++];
+    } else {
+        bytes[byte_count++] = (uint8_t)run_limit;
+    }
+
+    for (; next <= edge_count && run_start < frame_end; ++next) {
+        double end = next < edge_count ? edges[next] : frame_end;
+        int counts = (int)(((end - run_start) / PIO_CYCLES_PER_EDGE_COUNT) + 0.5);
+        counts = counts < 1 ? 1 : counts;
+        counts = counts > (int)run_limit ? (int)run_limit : counts;
+        bytes[byte_count++] = (uint8_t)(run_limit - counts + EDGE_CAPTURE_RUN_OVERHEAD);
+        run_start = end;
+    }
+    bytes[byte_count++] = EDGE_CAPTURE_END_MARKER;
+
+    /* Packed oldest first; the final word is padded so the marker is its low byte */
+    int word_count = (byte_count + 3) / 4;
+    int padding = (word_count * 4) - byte_count;
+    memset(words, 0, (size_t)word_count * sizeof(*words));
+    for (int i = 0; i < byte_count; ++i) {
+        int slot = i < (word_count - 1) * 4 ? i : i + padding;
+        words[slot / 4] |= (uint32_t)bytes[i] << (24 - ((slot % 4) * 8));
+    }
+    return word_count;
+}
+
+/* ---- Mock PIO hooks ---- */
+
+/*
+ * Queue the ESC's answer to a frame. Edge times are relative to the response's
+ * first falling edge, which comes latency_us after the frame ends; the PIO
+ * opens its RX window after the wait loaded as the second TX word.
+ */
+static void respond(struct esc_sim_bank *bank, uint pio_index, uint sm, uint pin, uint64_t now) {
+    struct esc_sim_esc *esc = esc_sim_get(bank, pin);
+    struct esc_sim_pending *pending = &bank->pending[pio_index][sm];
+    const uint32_t *tx_words = bank->tx_words[pio_index][sm];
+    double cycle_us = pio_cycle_us(bank);
+    double latency_cycles = bank->config.latency_us / cycle_us;
+    double window_start = (double)tx_words[1] - latency_cycles;
+    double edges[MAX_EDGES];
+    double frame_end;
+    int edge_count = 0;
+
+    if (sim_chance(bank, bank->config.drop_pct)) {
+        esc->stats.dropped++;
+        frame_end = 0.0;
+    } else {
+        edge_count = build_edges(bank, encode_gcr20(next_telemetry_value(bank, esc)), edges,
+                                 &frame_end);
+        esc->stats.responses++;
+    }
+
+    /* An unanswered frame looks like a response that never leaves idle */
+    double capture_end;
+    if (bank->capture == DSHOT_RX_CAPTURE_EDGE) {
+        pending->word_count =
+            capture_edges(edges, edge_count, frame_end, window_start, tx_words[2], pending->words);
+        capture_end = (frame_end > window_start ? frame_end : window_start) +
+                      ((double)tx_words[2] * PIO_CYCLES_PER_EDGE_COUNT);
+    } else {
+        pending->word_count = capture_oversampled(bank, edges, edge_count, frame_end,
+                                                  window_start, pending->words);
+        capture_end = window_start + OVERSAMPLE_RX_TIMEOUT_CYCLES +
+                      ((double)OVERSAMPLE_SAMPLES * PIO_CYCLES_PER_SAMPLE);
+    }
+    bool timed_out = pending->word_count == 0 ||
+                     (pending->word_count == 1 && pending->words[0] == EDGE_CAPTURE_END_MARKER);
+    if (edge_count > 0 && timed_out) {
+        esc->stats.missed++;
+    }
+    if (pending->word_count == 0) {
+        return;
+    }
+
+    pending->pin = pin;
+    double tx_cycles = DSHOT_FRAME_BITS * PIO_CYCLES_PER_TX_BIT;
+    pending->ready_us = now + (uint64_t)((tx_cycles + latency_cycles + capture_end) * cycle_us);
+    pending->active = true;
+}
+
+/* Frames are complete once their last TX word (wait cycles, or run limit in edge mode) arrives */
+static void sim_tx_hook(void *context, uint pio_index, uint sm, uint32_t word) {
+    struct esc_sim_bank *bank = context;
+    uint8_t words_per_frame = bank->capture == DSHOT_RX_CAPTURE_EDGE ? 3 : 2;
+    uint8_t *index = &bank->tx_word_index[pio_index][sm];
+    uint32_t *tx_words = bank->tx_words[pio_index][sm];
+
+    tx_words[(*index)++] = word;
+    if (*index < words_per_frame) {
+        return;
+    }
+    *index = 0;
+
+    uint pin = mock_pio_sm_pin(pio_index, sm);
+    struct esc_sim_esc *esc = esc_sim_get(bank, pin);
+    if (esc == NULL) {
+        return;
+    }
+
+    uint16_t frame = (uint16_t)(~tx_words[0] >> 16);
+    uint16_t value = frame >> 4;
+    uint16_t crc = (uint16_t)(~(value ^ (value >> 4) ^ (value >> 8)) & 0x0F);
+    uint64_t now = mock_time_get_us();
+
+    esc->stats.frames++;
+    if (crc != (frame & 0x0F)) {
+        esc->stats.bad_crc++;
+        return;
+    }
+
+    update_motor(bank, esc, now);
+    receive_value(esc, value >> 1);
+    if (bank->pending[pio_index][sm].active) {
+        esc_sim_get(bank, bank->pending[pio_index][sm].pin)->stats.late++;
+        bank->pending[pio_index][sm].active = false;
+    }
+    /* Bidirectional ESCs answer every frame; the telemetry bit only marks commands */
+    respond(bank, pio_index, sm, pin, now);
+}
+
+static void sim_rx_hook(void *context, uint pio_index, uint sm) {
+    struct esc_sim_bank *bank = context;
+    struct esc_sim_pending *pending = &bank->pending[pio_index][sm];
+
+    if (!pending->active || mock_time_get_us() < pending->ready_us) {
+        return;
+    }
+
+    pending->active = false;
+    if (mock_pio_sm_pin(pio_index, sm) != pending->pin) {
+        esc_sim_get(bank, pending->pin)->stats.late++;
+        return;
+    }
+    for (int i = 0; i < pending->word_count; ++i) {
+        mock_pio_rx_push(pio_index, sm, pending->words[i]);
+    }
+}
+
+/* ---- Public API ---- */
+
+void esc_sim_default_config(struct esc_sim_config *config) {
+    memset(config, 0, sizeof(*config));
+    config->latency_us = 26;
+    config->max_erpm = 100000;
+    config->rpm_time_constant_ms = 50;
+    config->edt_interval = 8;
+    config->temperature_c = 35;
+    config->voltage_mv = 16000;
+    config->current_ma = 2000;
+}
+
+void esc_sim_init(struct esc_sim_bank *bank, const struct esc_sim_config *config,
+                  uint16_t dshot_speed, enum dshot_rx_capture capture) {
+    memset(bank, 0, sizeof(*bank));
+    bank->config = *config;
+    bank->dshot_speed = dshot_speed;
+    bank->capture = capture;
+    bank->rng_state = 0x2545F491u;
+    mock_pio_set_tx_hook(sim_tx_hook, bank);
+    mock_pio_set_rx_hook(sim_rx_hook, bank);
+}
+
+void esc_sim_add_escs(struct esc_sim_bank *bank, uint pin_base, int count) {
+    for (int i = 0; i < count && pin_base + i < ESC_SIM_MAX_PINS; ++i) {
+        struct esc_sim_esc *esc = &bank->escs[pin_base + i];
+        memset(esc, 0, sizeof(*esc));
+        esc->present = true;
+        esc->last_update_us = mock_time_get_us();
+    }
+}
+
+struct esc_sim_esc *esc_sim_get(struct esc_sim_bank *bank, uint pin) {
+    if (pin >= ESC_SIM_MAX_PINS || !bank->escs[pin].present) {
+        return NULL;
+    }
+    return &bank->escs[pin];
+}
+
+uint32_t esc_sim_erpm(struct esc_sim_bank *bank, uint pin) {
+    struct esc_sim_esc *esc = esc_sim_get(bank, pin);
+    if (esc == NULL) {
+        return 0;
+    }
+
+    update_motor(bank, esc, mock_time_get_us());
+    uint16_t value = encode_erpm(esc->erpm);
+    if (value == ERPM_STOPPED_VALUE) {
+        return 0;
+    }
+    uint32_t period = (uint32_t)(value & 0x1FF) << (value >> 9);
+    return (600000 + period / 2) / period;
+}
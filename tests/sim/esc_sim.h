@@ -0,0 +1,107 @@
+/*
+ * Behavioral model of a bank of bidirectional DShot ESCs for host tests.
+ *
+ * The bank sits behind the mock PIO FIFOs (tests/mocks/mock_sdk.h). It reads
+ * each frame pushed by dshot_loop_async_start() and picks the ESC on the
+ * state machine's current output pin. The ESC:
+ *   - applies the command or throttle
+ *   - models a first-order motor RPM response
+ *   - after a turnaround latency, answers with a GCR-encoded eRPM or EDT
+ *     frame, captured the way pio_dshot or pio_dshot_edge would
+ *
+ * The capture honours the RX window the firmware programs: sampling starts
+ * after the wait cycles pushed with the frame. A response that starts too
+ * late is a timeout, and one that starts before the window is truncated.
+ *
+ * Settings commands (spin direction, 3D mode, save, EDT enable/disable) take
+ * effect after ESC_SIM_COMMAND_REPEATS identical consecutive frames, like
+ * BLHeli_32/Bluejay. 3D mode is only applied by SAVE_SETTINGS.
+ */
+
+#ifndef TESTS_SIM_ESC_SIM_H
+#define TESTS_SIM_ESC_SIM_H
+
+#include "dshot/dshot.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ESC_SIM_MAX_PINS 30
+#define ESC_SIM_COMMAND_REPEATS 6
+#define ESC_SIM_EDT_VERSION 2
+
+struct esc_sim_config {
+    double clock_skew_pct;      /* ESC telemetry bit period error */
+    double edge_jitter_pct;     /* Maximum per-edge displacement, percent of a bit */
+    double glitch_pct;          /* Chance a response carries a one-sample glitch pulse */
+    double drop_pct;            /* Chance the ESC does not answer a frame */
+    uint32_t latency_us;        /* Frame end to the response's first falling edge */
+    uint32_t max_erpm;          /* eRPM at full throttle */
+    uint32_t rpm_time_constant_ms;
+    uint8_t edt_interval;       /* Every Nth response is EDT when enabled (0 = eRPM only) */
+    uint8_t temperature_c;
+    uint16_t voltage_mv;
+    uint16_t current_ma;
+};
+
+struct esc_sim_stats {
+    uint32_t frames;
+    uint32_t bad_crc;
+    uint32_t responses;
+    uint32_t dropped;
+    uint32_t late;             /* Responses discarded because the line moved on */
+    uint32_t missed;           /* Responses outside the PIO's RX window */
+    uint32_t commands_applied;
+    uint32_t settings_saved;
+};
+
+struct esc_sim_esc {
+    bool present;
+    uint16_t throttle;           /* Last throttle value (48-2047, 0 = stop) */
+    uint64_t throttle_changed_us; /* Frame time the throttle last changed */
+    uint16_t last_command;
+    uint8_t command_repeats;
+    bool mode_3d;
+    bool mode_3d_pending;
+    bool reversed;
+    bool edt_enabled;
+    bool edt_version_due;
+    uint8_t edt_counter;
+    uint8_t edt_type_index;
+    double erpm;                 /* Signed: negative while spinning in reverse */
+    uint64_t last_update_us;
+    struct esc_sim_stats stats;
+};
+
+struct esc_sim_pending {
+    bool active;
+    uint pin;
+    uint64_t ready_us;
+    uint32_t words[DSHOT_CAPTURE_MAX_WORDS];
+    int word_count;
+};
+
+struct esc_sim_bank {
+    struct esc_sim_config config;
+    uint16_t dshot_speed;
+    enum dshot_rx_capture capture;
+    uint32_t rng_state;
+    struct esc_sim_esc escs[ESC_SIM_MAX_PINS];
+    uint8_t tx_word_index[MOCK_PIO_COUNT][MOCK_PIO_SM_COUNT];
+    uint32_t tx_words[MOCK_PIO_COUNT][MOCK_PIO_SM_COUNT][3]; /* Frame, wait cycles, run limit */
+    struct esc_sim_pending pending[MOCK_PIO_COUNT][MOCK_PIO_SM_COUNT];
+};
+
+/* Fills in a nominal ESC: no skew or noise, 26 us turnaround, EDT every 8th frame */
+void esc_sim_default_config(struct esc_sim_config *config);
+
+/* Attach ESCs to `count` consecutive pins and install the mock PIO hooks */
+void esc_sim_init(struct esc_sim_bank *bank, const struct esc_sim_config *config,
+                  uint16_t dshot_speed, enum dshot_rx_capture capture);
+void esc_sim_add_escs(struct esc_sim_bank *bank, uint pin_base, int count);
+
+struct esc_sim_esc *esc_sim_get(struct esc_sim_bank *bank, uint pin);
+
+/* eRPM/100 as the firmware reports it, after advancing the motor model to now */
+uint32_t esc_sim_erpm(struct esc_sim_bank *bank, uint pin);
+
+#endif
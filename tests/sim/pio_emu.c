@@ -0,0 +1,809 @@
+#include "pio_emu.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ASM_LINE_MAX 256
+#define ASM_MAX_LABELS 32
+#define ASM_MAX_TOKENS 8
+#define ASM_MAX_DELAY 31
+
+/* Instruction encoding (RP2040 datasheet, section 3.4) */
+#define OP_JMP 0x0000
+#define OP_IN 0x4000
+#define OP_OUT 0x6000
+#define OP_PUSH_PULL 0x8000
+#define OP_MOV 0xA000
+#define OP_SET 0xE000
+#define OP_MASK 0xE000
+#define DELAY_SHIFT 8
+#define PULL_BIT 0x0080
+#define IF_BIT 0x0040
+#define BLOCK_BIT 0x0020
+#define NOP_INSTRUCTION (OP_MOV | (2 << 5) | 2) /* mov y, y */
+
+enum jmp_condition {
+    JMP_ALWAYS,
+    JMP_NOT_X,
+    JMP_X_DEC,
+    JMP_NOT_Y,
+    JMP_Y_DEC,
+    JMP_X_NE_Y,
+    JMP_PIN,
+    JMP_NOT_OSRE,
+};
+
+/* Operand encodings shared by in/out/mov/set where the names overlap */
+enum operand {
+    OPERAND_PINS = 0,
+    OPERAND_X = 1,
+    OPERAND_Y = 2,
+    OPERAND_NULL = 3,
+    OPERAND_PINDIRS = 4,
+    OPERAND_PC = 5,
+    OPERAND_STATUS = 5,
+    OPERAND_ISR = 6,
+    OPERAND_OSR = 7,
+};
+
+struct asm_line {
+    char text[ASM_LINE_MAX];
+    int line_number;
+};
+
+struct asm_label {
+    char name[PIO_EMU_NAME_MAX];
+    uint8_t address;
+};
+
+struct asm_state {
+    struct asm_line lines[PIO_EMU_MAX_INSTRUCTIONS];
+    int line_count;
+    struct asm_label labels[ASM_MAX_LABELS];
+    int label_count;
+};
+
+/* ---- Assembler ---- */
+
+static char *trim(char *text) {
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    char *end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) {
+        *--end = '\0';
+    }
+    return text;
+}
+
+static void strip_comment(char *text) {
+    char *comment = strchr(text, ';');
+    if (comment != NULL) {
+        *comment = '\0';
+    }
+    comment = strstr(text, "//");
+    if (comment != NULL) {
+        *comment = '\0';
+    }
+}
+
+static bool parse_number(const char *text, uint32_t *value) {
+    char *end;
+    int base = 10;
+    if (strncmp(text, "0b", 2) == 0) {
+        text += 2;
+        base = 2;
+    }
+    unsigned long parsed = strtoul(text, &end, base == 2 ? 2 : 0);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    *value = (uint32_t)parsed;
+    return true;
+}
+
+/* Split on whitespace and commas */
+static int tokenize(char *text, char **tokens) {
+    int count = 0;
+    for (char *token = strtok(text, " \t,"); token != NULL && count < ASM_MAX_TOKENS;
+         token = strtok(NULL, " \t,")) {
+        tokens[count++] = token;
+    }
+    return count;
+}
+
+static bool lookup_operand(const char *name, const char *const *names, int count, int *value) {
+    for (int i = 0; i < count; ++i) {
+        if (names[i] != NULL && strcmp(name, names[i]) == 0) {
+            *value = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_bit_count(const char *text, uint16_t *encoded) {
+    uint32_t count;
+    if (!parse_number(text, &count) || count == 0 || count > 32) {
+        return false;
+    }
+    *encoded = (uint16_t)(count & 0x1F);
+    return true;
+}
+
+static bool resolve_address(const struct asm_state *state, const char *text, uint16_t *address) {
+    for (int i = 0; i < state->label_count; ++i) {
+        if (strcmp(state->labels[i].name, text) == 0) {
+            *address = state->labels[i].address;
+            return true;
+        }
+    }
+    uint32_t value;
+    if (parse_number(text, &value) && value < PIO_EMU_MAX_INSTRUCTIONS) {
+        *address = (uint16_t)value;
+        return true;
+    }
+    return false;
+}
+
+static bool encode_jmp(const struct asm_state *state, char **tokens, int count,
+                       uint16_t *instruction) {
+    static const char *const conditions[] = {NULL,  "!x",  "x--", "!y",
+                                             "y--", "x!=y", "pin", "!osre"};
+    int condition = JMP_ALWAYS;
+    uint16_t address;
+
+    if (count == 3 && !lookup_operand(tokens[1], conditions, 8, &condition)) {
+        return false;
+    }
+    if ((count != 2 && count != 3) || !resolve_address(state, tokens[count - 1], &address)) {
+        return false;
+    }
+    *instruction = (uint16_t)(OP_JMP | (condition << 5) | address);
+    return true;
+}
+
+static bool encode_in_out(char **tokens, int count, bool out, uint16_t *instruction) {
+    static const char *const in_sources[] = {"pins", "x", "y", "null", NULL, NULL, "isr", "osr"};
+    static const char *const out_destinations[] = {"pins", "x",  "y",   "null",
+                                                   "pindirs", "pc", "isr", "exec"};
+    int operand;
+    uint16_t bit_count;
+
+    const char *const *names = out ? out_destinations : in_sources;
+    if (count != 3 || !lookup_operand(tokens[1], names, 8, &operand) ||
+        !parse_bit_count(tokens[2], &bit_count)) {
+        return false;
+    }
+    *instruction = (uint16_t)((out ? OP_OUT : OP_IN) | (operand << 5) | bit_count);
+    return true;
+}
+
+static bool encode_push_pull(char **tokens, int count, bool pull, uint16_t *instruction) {
+    uint16_t encoded = OP_PUSH_PULL | (pull ? PULL_BIT : 0) | BLOCK_BIT;
+
+    for (int i = 1; i < count; ++i) {
+        if (strcmp(tokens[i], pull ? "ifempty" : "iffull") == 0) {
+            encoded |= IF_BIT;
+        } else if (strcmp(tokens[i], "noblock") == 0) {
+            encoded &= (uint16_t)~BLOCK_BIT;
+        } else if (strcmp(tokens[i], "block") != 0) {
+            return false;
+        }
+    }
+    *instruction = encoded;
+    return true;
+}
+
+static bool encode_mov(char **tokens, int count, uint16_t *instruction) {
+    static const char *const destinations[] = {"pins", "x",  "y",   NULL,
+                                               "exec", "pc", "isr", "osr"};
+    static const char *const sources[] = {"pins", "x", "y", "null", NULL, "status", "isr", "osr"};
+    int destination;
+    int source;
+    int operation = 0;
+
+    if (count != 3 || !lookup_operand(tokens[1], destinations, 8, &destination)) {
+        return false;
+    }
+    const char *source_name = tokens[2];
+    if (source_name[0] == '!' || source_name[0] == '~') {
+        operation = 1;
+        source_name++;
+    } else if (strncmp(source_name, "::", 2) == 0) {
+        operation = 2;
+        source_name += 2;
+    }
+    if (!lookup_operand(source_name, sources, 8, &source)) {
+        return false;
+    }
+    *instruction = (uint16_t)(OP_MOV | (destination << 5) | (operation << 3) | source);
+    return true;
+}
+
+static bool encode_set(char **tokens, int count, uint16_t *instruction) {
+    static const char *const destinations[] = {"pins", "x", "y", NULL, "pindirs"};
+    int destination;
+    uint32_t value;
+
+    if (count != 3 || !lookup_operand(tokens[1], destinations, 5, &destination) ||
+        !parse_number(tokens[2], &value) || value > 31) {
+        return false;
+    }
+    *instruction = (uint16_t)(OP_SET | (destination << 5) | value);
+    return true;
+}
+
+static bool encode_line(const struct asm_state *state, const char *source_text,
+                        uint16_t *instruction) {
+    char text[ASM_LINE_MAX];
+    char *tokens[ASM_MAX_TOKENS];
+    uint32_t delay = 0;
+
+    snprintf(text, sizeof(text), "%s", source_text);
+    for (char *c = text; *c != '\0'; ++c) {
+        *c = (char)tolower((unsigned char)*c);
+    }
+
+    char *bracket = strchr(text, '[');
+    if (bracket != NULL) {
+        char *close = strchr(bracket, ']');
+        if (close == NULL) {
+            return false;
+        }
+        *close = '\0';
+        if (!parse_number(trim(bracket + 1), &delay) || delay > ASM_MAX_DELAY) {
+            return false;
+        }
+        *bracket = '\0';
+    }
+
+    int count = tokenize(text, tokens);
+    bool ok;
+    if (count == 0) {
+        return false;
+    } else if (strcmp(tokens[0], "jmp") == 0) {
+        ok = encode_jmp(state, tokens, count, instruction);
+    } else if (strcmp(tokens[0], "in") == 0 || strcmp(tokens[0], "out") == 0) {
+        ok = encode_in_out(tokens, count, tokens[0][0] == 'o', instruction);
+    } else if (strcmp(tokens[0], "push") == 0 || strcmp(tokens[0], "pull") == 0) {
+        ok = encode_push_pull(tokens, count, tokens[0][1] == 'u' && tokens[0][2] == 'l',
+                              instruction);
+    } else if (strcmp(tokens[0], "mov") == 0) {
+        ok = encode_mov(tokens, count, instruction);
+    } else if (strcmp(tokens[0], "set") == 0) {
+        ok = encode_set(tokens, count, instruction);
+    } else if (strcmp(tokens[0], "nop") == 0) {
+        ok = count == 1;
+        *instruction = NOP_INSTRUCTION;
+    } else {
+        ok = false;
+    }
+
+    *instruction |= (uint16_t)(delay << DELAY_SHIFT);
+    return ok;
+}
+
+/* Collect labels and instruction lines; returns 0 or the failing line number */
+static int collect_program(const char *source, const char *program_name, struct asm_state *state,
+                           struct pio_emu_program *program, bool *found) {
+    char line[ASM_LINE_MAX];
+    bool in_program = false;
+    int line_number = 0;
+    bool wrap_set = false;
+
+    *found = false;
+    for (const char *cursor = source; *cursor != '\0';) {
+        const char *end = strchr(cursor, '\n');
+        size_t length = end != NULL ? (size_t)(end - cursor) : strlen(cursor);
+        snprintf(line, sizeof(line), "%.*s", (int)length, cursor);
+        cursor += length + (end != NULL ? 1 : 0);
+        line_number++;
+
+        strip_comment(line);
+        char *text = trim(line);
+        if (*text == '\0') {
+            continue;
+        }
+
+        if (strncmp(text, ".program", 8) == 0) {
+            if (in_program) {
+                break;
+            }
+            in_program = strcmp(trim(text + 8), program_name) == 0;
+            *found |= in_program;
+            continue;
+        }
+        if (!in_program) {
+            continue;
+        }
+
+        if (strcmp(text, ".wrap_target") == 0) {
+            program->wrap_target = (uint8_t)state->line_count;
+            continue;
+        }
+        if (strcmp(text, ".wrap") == 0) {
+            if (state->line_count == 0) {
+                return line_number;
+            }
+            program->wrap = (uint8_t)(state->line_count - 1);
+            wrap_set = true;
+            continue;
+        }
+        if (text[0] == '.') {
+            return line_number; /* .side_set, .define etc. are not needed by this repo */
+        }
+
+        char *colon = strchr(text, ':');
+        if (colon != NULL) {
+            *colon = '\0';
+            if (state->label_count == ASM_MAX_LABELS) {
+                return line_number;
+            }
+            struct asm_label *label = &state->labels[state->label_count++];
+            snprintf(label->name, sizeof(label->name), "%s", trim(text));
+            label->address = (uint8_t)state->line_count;
+            text = trim(colon + 1);
+            if (*text == '\0') {
+                continue;
+            }
+        }
+
+        if (state->line_count == PIO_EMU_MAX_INSTRUCTIONS) {
+            return line_number;
+        }
+        struct asm_line *instruction = &state->lines[state->line_count++];
+        snprintf(instruction->text, sizeof(instruction->text), "%s", text);
+        instruction->line_number = line_number;
+    }
+
+    if (!wrap_set && state->line_count > 0) {
+        program->wrap = (uint8_t)(state->line_count - 1);
+    }
+    return 0;
+}
+
+int pio_emu_assemble(const char *source, const char *program_name,
+                     struct pio_emu_program *program) {
+    static struct asm_state state;
+    bool found;
+
+    memset(&state, 0, sizeof(state));
+    memset(program, 0, sizeof(*program));
+    snprintf(program->name, sizeof(program->name), "%s", program_name);
+
+    int error = collect_program(source, program_name, &state, program, &found);
+    if (error != 0) {
+        return error;
+    }
+    if (!found) {
+        return -1;
+    }
+
+    for (int i = 0; i < state.line_count; ++i) {
+        if (!encode_line(&state, state.lines[i].text, &program->instructions[i])) {
+            return state.lines[i].line_number;
+        }
+    }
+    program->length = (uint8_t)state.line_count;
+    return 0;
+}
+
+int pio_emu_assemble_file(const char *path, const char *program_name,
+                          struct pio_emu_program *program) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *source = malloc((size_t)size + 1);
+    if (source == NULL) {
+        fclose(file);
+        return -1;
+    }
+    size_t read = fread(source, 1, (size_t)size, file);
+    source[read] = '\0';
+    fclose(file);
+
+    int result = pio_emu_assemble(source, program_name, program);
+    free(source);
+    return result;
+}
+
+/* ---- FIFOs ---- */
+
+static bool fifo_push(struct pio_emu_fifo *fifo, uint32_t word) {
+    if (fifo->level == PIO_EMU_FIFO_DEPTH) {
+        return false;
+    }
+    fifo->words[(fifo->head + fifo->level) % PIO_EMU_FIFO_DEPTH] = word;
+    fifo->level++;
+    return true;
+}
+
+static bool fifo_pop(struct pio_emu_fifo *fifo, uint32_t *word) {
+    if (fifo->level == 0) {
+        return false;
+    }
+    *word = fifo->words[fifo->head];
+    fifo->head = (fifo->head + 1) % PIO_EMU_FIFO_DEPTH;
+    fifo->level--;
+    return true;
+}
+
+bool pio_emu_tx_push(struct pio_emu_sm *sm, uint32_t word) {
+    return fifo_push(&sm->tx_fifo, word);
+}
+
+bool pio_emu_rx_pop(struct pio_emu_sm *sm, uint32_t *word) {
+    return fifo_pop(&sm->rx_fifo, word);
+}
+
+/* ---- Execution ---- */
+
+static uint32_t bit_mask(uint8_t count) {
+    return count >= 32 ? UINT32_MAX : ((1u << count) - 1u);
+}
+
+static uint32_t input_levels(const struct pio_emu_sm *sm) {
+    uint32_t external = sm->input != NULL ? sm->input(sm->input_context, sm->cycle) : UINT32_MAX;
+    return (sm->pins & sm->pindirs) | (external & ~sm->pindirs);
+}
+
+bool pio_emu_pin_level(const struct pio_emu_sm *sm, uint8_t pin) {
+    return (input_levels(sm) >> pin) & 0x1u;
+}
+
+static uint32_t rotate_right(uint32_t value, uint8_t shift) {
+    shift &= 31;
+    return shift == 0 ? value : (value >> shift) | (value << (32 - shift));
+}
+
+static void write_pin_group(uint32_t *target, uint8_t base, uint8_t count, uint32_t data) {
+    for (uint8_t i = 0; i < count; ++i) {
+        uint8_t pin = (base + i) & 31;
+        *target = (*target & ~(1u << pin)) | (((data >> i) & 0x1u) << pin);
+    }
+}
+
+static uint32_t reverse_bits(uint32_t value) {
+    uint32_t reversed = 0;
+    for (int i = 0; i < 32; ++i) {
+        reversed = (reversed << 1) | ((value >> i) & 0x1u);
+    }
+    return reversed;
+}
+
+static bool do_push(struct pio_emu_sm *sm) {
+    if (!fifo_push(&sm->rx_fifo, sm->isr)) {
+        return false;
+    }
+    sm->isr = 0;
+    sm->isr_shift_count = 0;
+    return true;
+}
+
+static void shift_in(struct pio_emu_sm *sm, uint32_t data, uint8_t count) {
+    data &= bit_mask(count);
+    if (count == 32) {
+        sm->isr = data;
+    } else if (sm->in_shift_right) {
+        sm->isr = (sm->isr >> count) | (data << (32 - count));
+    } else {
+        sm->isr = (sm->isr << count) | data;
+    }
+    sm->isr_shift_count = (uint8_t)(sm->isr_shift_count + count > 32 ? 32
+                                                                     : sm->isr_shift_count + count);
+}
+
+static uint32_t shift_out(struct pio_emu_sm *sm, uint8_t count) {
+    uint32_t data;
+    if (count == 32) {
+        data = sm->osr;
+        sm->osr = 0;
+    } else if (sm->out_shift_right) {
+        data = sm->osr & bit_mask(count);
+        sm->osr >>= count;
+    } else {
+        data = sm->osr >> (32 - count);
+        sm->osr <<= count;
+    }
+    sm->osr_shift_count = (uint8_t)(sm->osr_shift_count + count > 32 ? 32
+                                                                     : sm->osr_shift_count + count);
+    return data;
+}
+
+static bool jmp_condition_met(struct pio_emu_sm *sm, int condition) {
+    switch (condition) {
+    case JMP_NOT_X:
+        return sm->x == 0;
+    case JMP_X_DEC:
+        return sm->x-- != 0;
+    case JMP_NOT_Y:
+        return sm->y == 0;
+    case JMP_Y_DEC:
+        return sm->y-- != 0;
+    case JMP_X_NE_Y:
+        return sm->x != sm->y;
+    case JMP_PIN:
+        return pio_emu_pin_level(sm, sm->jmp_pin);
+    case JMP_NOT_OSRE:
+        return sm->osr_shift_count < 32;
+    default:
+        return true;
+    }
+}
+
+static uint32_t mov_source(const struct pio_emu_sm *sm, int source) {
+    switch (source) {
+    case OPERAND_PINS:
+        return rotate_right(input_levels(sm), sm->in_base);
+    case OPERAND_X:
+        return sm->x;
+    case OPERAND_Y:
+        return sm->y;
+    case OPERAND_ISR:
+        return sm->isr;
+    case OPERAND_OSR:
+        return sm->osr;
+    default:
+        return 0; /* null; status is unused with the default STATUS_SEL */
+    }
+}
+
+/*
+ * Execute the instruction at pc. Returns false if it stalls, in which case it
+ * is retried on the next cycle and its delay does not start.
+ */
+static bool execute(struct pio_emu_sm *sm, uint16_t instruction, uint8_t *next_pc) {
+    int field = (instruction >> 5) & 0x7;
+    int low = instruction & 0x1F;
+    uint8_t bit_count = low == 0 ? 32 : (uint8_t)low;
+
+    switch (instruction & OP_MASK) {
+    case OP_JMP:
+        if (jmp_condition_met(sm, field)) {
+            *next_pc = (uint8_t)low;
+        }
+        return true;
+
+    case OP_IN: {
+        if (sm->autopush && sm->isr_shift_count + bit_count >= sm->push_threshold &&
+            sm->rx_fifo.level == PIO_EMU_FIFO_DEPTH) {
+            return false;
+        }
+        uint32_t data = mov_source(sm, field);
+        shift_in(sm, data, bit_count);
+        if (sm->autopush && sm->isr_shift_count >= sm->push_threshold) {
+            do_push(sm);
+        }
+        return true;
+    }
+
+    case OP_OUT: {
+        uint32_t data = shift_out(sm, bit_count);
+        switch (field) {
+        case OPERAND_PINS:
+            write_pin_group(&sm->pins, sm->out_base, sm->out_count, data);
+            break;
+        case OPERAND_X:
+            sm->x = data;
+            break;
+        case OPERAND_Y:
+            sm->y = data;
+            break;
+        case OPERAND_PINDIRS:
+            write_pin_group(&sm->pindirs, sm->out_base, sm->out_count, data);
+            break;
+        case OPERAND_PC:
+            *next_pc = (uint8_t)(data & 0x1F);
+            break;
+        case OPERAND_ISR:
+            sm->isr = data;
+            sm->isr_shift_count = bit_count;
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    case OP_PUSH_PULL: {
+        bool pull = instruction & PULL_BIT;
+        bool conditional = instruction & IF_BIT;
+        bool block = instruction & BLOCK_BIT;
+        if (pull) {
+            if (conditional && sm->osr_shift_count < 32) {
+                return true;
+            }
+            uint32_t word;
+            if (fifo_pop(&sm->tx_fifo, &word)) {
+                sm->osr = word;
+            } else if (block) {
+                return false;
+            } else {
+                sm->osr = sm->x;
+            }
+            sm->osr_shift_count = 0;
+            return true;
+        }
+        if (conditional && sm->isr_shift_count < sm->push_threshold) {
+            return true;
+        }
+        if (!do_push(sm)) {
+            if (block) {
+                return false;
+            }
+            sm->isr = 0;
+            sm->isr_shift_count = 0;
+        }
+        return true;
+    }
+
+    case OP_MOV: {
+        uint32_t data = mov_source(sm, instruction & 0x7);
+        int operation = (instruction >> 3) & 0x3;
+        data = operation == 1 ? ~data : operation == 2 ? reverse_bits(data) : data;
+        switch (field) {
+        case OPERAND_PINS:
+            write_pin_group(&sm->pins, sm->out_base, sm->out_count, data);
+            break;
+        case OPERAND_X:
+            sm->x = data;
+            break;
+        case OPERAND_Y:
+            sm->y = data;
+            break;
+        case OPERAND_PC:
+            *next_pc = (uint8_t)(data & 0x1F);
+            break;
+        case OPERAND_ISR:
+            sm->isr = data;
+            sm->isr_shift_count = 0;
+            break;
+        case OPERAND_OSR:
+            sm->osr = data;
+            sm->osr_shift_count = 0;
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    case OP_SET:
+        switch (field) {
+        case OPERAND_PINS:
+            write_pin_group(&sm->pins, sm->set_base, sm->set_count, (uint32_t)low);
+            break;
+        case OPERAND_X:
+            sm->x = (uint32_t)low;
+            break;
+        case OPERAND_Y:
+            sm->y = (uint32_t)low;
+            break;
+        case OPERAND_PINDIRS:
+            write_pin_group(&sm->pindirs, sm->set_base, sm->set_count, (uint32_t)low);
+            break;
+        default:
+            break;
+        }
+        return true;
+
+    default:
+        return true; /* wait and irq are not used by this repo */
+    }
+}
+
+static void log_pin_event(struct pio_emu_sm *sm) {
+    if (sm->event_count == PIO_EMU_MAX_PIN_EVENTS) {
+        sm->events_dropped++;
+        return;
+    }
+    struct pio_emu_pin_event *event = &sm->events[sm->event_count++];
+    event->cycle = sm->cycle;
+    event->pins = sm->pins;
+    event->pindirs = sm->pindirs;
+}
+
+void pio_emu_step(struct pio_emu_sm *sm) {
+    if (sm->delay > 0) {
+        sm->delay--;
+        sm->cycle++;
+        return;
+    }
+
+    uint16_t instruction = sm->program->instructions[sm->pc];
+    uint8_t next_pc = sm->pc == sm->program->wrap ? sm->program->wrap_target : sm->pc + 1;
+    uint32_t pins = sm->pins;
+    uint32_t pindirs = sm->pindirs;
+
+    sm->stalled = !execute(sm, instruction, &next_pc);
+    if (!sm->stalled) {
+        sm->pc = next_pc;
+        sm->delay = (instruction >> DELAY_SHIFT) & ASM_MAX_DELAY;
+    }
+    if (sm->pins != pins || sm->pindirs != pindirs) {
+        log_pin_event(sm);
+    }
+    sm->cycle++;
+}
+
+uint64_t pio_emu_run_until_stall(struct pio_emu_sm *sm, uint64_t max_cycles) {
+    uint64_t start = sm->cycle;
+    do {
+        pio_emu_step(sm);
+    } while (!sm->stalled && sm->cycle - start < max_cycles);
+    return sm->cycle - start;
+}
+
+int pio_emu_run_frame(struct pio_emu_sm *sm, const uint32_t *tx_words, int tx_count,
+                      uint32_t *rx_words, int max_rx_words, uint64_t max_cycles) {
+    int rx_count = 0;
+
+    for (int i = 0; i < tx_count; ++i) {
+        pio_emu_tx_push(sm, tx_words[i]);
+    }
+    for (uint64_t i = 0; i < max_cycles; ++i) {
+        pio_emu_step(sm);
+        while (rx_count < max_rx_words && pio_emu_rx_pop(sm, &rx_words[rx_count])) {
+            rx_count++;
+        }
+        if (sm->stalled && sm->tx_fifo.level == 0) {
+            break;
+        }
+    }
+    return rx_count;
+}
+
+void pio_emu_init(struct pio_emu_sm *sm, const struct pio_emu_program *program, uint8_t pin,
+                  uint32_t sys_clock_hz, float clkdiv) {
+    memset(sm, 0, sizeof(*sm));
+    sm->program = program;
+    sm->set_base = pin;
+    sm->set_count = 1;
+    sm->out_base = pin;
+    sm->out_count = 1;
+    sm->in_base = pin;
+    sm->jmp_pin = pin;
+    sm->autopush = true;
+    sm->push_threshold = 32;
+    sm->sys_clock_hz = sys_clock_hz;
+
+    /* sm_config_set_clkdiv(): 16-bit integer part, 8-bit fraction, truncated */
+    uint32_t div_int = (uint32_t)clkdiv;
+    uint32_t div_frac = (uint32_t)((clkdiv - (float)div_int) * (1u << PIO_EMU_CLKDIV_FRAC_BITS));
+    sm->clkdiv_q8 = (div_int << PIO_EMU_CLKDIV_FRAC_BITS) | div_frac;
+}
+
+void pio_emu_set_input(struct pio_emu_sm *sm, pio_emu_input_fn input, void *context) {
+    sm->input = input;
+    sm->input_context = context;
+}
+
+double pio_emu_cycle_time_ns(const struct pio_emu_sm *sm, uint64_t cycle) {
+    uint64_t sys_ticks = (cycle * sm->clkdiv_q8) >> PIO_EMU_CLKDIV_FRAC_BITS;
+    return (double)sys_ticks * 1e9 / (double)sm->sys_clock_hz;
+}
+
+uint32_t pio_emu_line_input(void *context, uint64_t cycle) {
+    const struct pio_emu_line *line = context;
+    int toggles = 0;
+    while (toggles < line->toggle_count && line->toggles[toggles] <= cycle) {
+        toggles++;
+    }
+    return (toggles & 1) ? ~(1u << line->pin) : UINT32_MAX;
+}
+
+void pio_emu_line_add_nrzi(struct pio_emu_line *line, uint64_t start, uint32_t bits, int bit_count,
+                           double bit_cycles) {
+    for (int bit = 0; bit < bit_count && line->toggle_count < PIO_EMU_MAX_LINE_TOGGLES; ++bit) {
+        if ((bits >> (bit_count - 1 - bit)) & 0x1u) {
+            line->toggles[line->toggle_count++] = start + (uint64_t)((bit * bit_cycles) + 0.5);
+        }
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * Cycle-level emulator of one RP2040 PIO state machine for host tests.
+ *
+ * pio_emu_assemble() assembles a named program from .pio source (the subset
+ * of pioasm used by this repo: jmp, in, out, push, pull, mov, set, nop,
+ * delays, labels and .wrap_target/.wrap) into real PIO instruction words.
+ * pio_emu_step() executes one PIO cycle, including delays, FIFO stalls,
+ * autopush and the `jmp pin` input, and logs every change of the pin
+ * outputs or directions so waveforms can be checked cycle by cycle.
+ *
+ * Pins configured as inputs read the level returned by the input callback,
+ * so a test can play a response from a simulated ESC into the program.
+ */
+
+#ifndef TESTS_SIM_PIO_EMU_H
+#define TESTS_SIM_PIO_EMU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PIO_EMU_MAX_INSTRUCTIONS 32
+#define PIO_EMU_FIFO_DEPTH 4
+#define PIO_EMU_MAX_PIN_EVENTS 512
+#define PIO_EMU_NAME_MAX 32
+#define PIO_EMU_CLKDIV_FRAC_BITS 8
+#define PIO_EMU_MAX_LINE_TOGGLES 32
+
+struct pio_emu_program {
+    char name[PIO_EMU_NAME_MAX];
+    uint16_t instructions[PIO_EMU_MAX_INSTRUCTIONS];
+    uint8_t length;
+    uint8_t wrap_target;
+    uint8_t wrap;
+};
+
+/* Line levels of all 32 pins at a given PIO cycle, for pins the SM does not drive */
+typedef uint32_t (*pio_emu_input_fn)(void *context, uint64_t cycle);
+
+struct pio_emu_pin_event {
+    uint64_t cycle;   /* First cycle with the new state */
+    uint32_t pins;    /* Output values */
+    uint32_t pindirs; /* 1 = driven by the SM */
+};
+
+struct pio_emu_fifo {
+    uint32_t words[PIO_EMU_FIFO_DEPTH];
+    uint8_t head;
+    uint8_t level;
+};
+
+struct pio_emu_sm {
+    const struct pio_emu_program *program;
+
+    /* Configuration, as set by the sm_config_* calls in dshot.c */
+    uint8_t set_base;
+    uint8_t set_count;
+    uint8_t out_base;
+    uint8_t out_count;
+    uint8_t in_base;
+    uint8_t jmp_pin;
+    bool out_shift_right;
+    bool in_shift_right;
+    bool autopush;
+    uint8_t push_threshold;
+    uint32_t clkdiv_q8;     /* Clock divider with 8 fractional bits */
+    uint32_t sys_clock_hz;
+
+    /* Execution state */
+    uint8_t pc;
+    uint32_t x;
+    uint32_t y;
+    uint32_t osr;
+    uint32_t isr;
+    uint8_t osr_shift_count;
+    uint8_t isr_shift_count;
+    uint8_t delay;
+    bool stalled;
+    uint64_t cycle;
+    uint32_t pins;
+    uint32_t pindirs;
+    struct pio_emu_fifo tx_fifo;
+    struct pio_emu_fifo rx_fifo;
+
+    pio_emu_input_fn input;
+    void *input_context;
+
+    struct pio_emu_pin_event events[PIO_EMU_MAX_PIN_EVENTS];
+    int event_count;
+    uint32_t events_dropped;
+};
+
+/*
+ * Assemble `program_name` from .pio source text. Returns 0 on success, or the
+ * 1-based source line of the first error (-1 if the program is not found).
+ */
+int pio_emu_assemble(const char *source, const char *program_name,
+                     struct pio_emu_program *program);
+int pio_emu_assemble_file(const char *path, const char *program_name,
+                          struct pio_emu_program *program);
+
+/* Start the SM at the program's first instruction with one pin for every role */
+void pio_emu_init(struct pio_emu_sm *sm, const struct pio_emu_program *program, uint8_t pin,
+                  uint32_t sys_clock_hz, float clkdiv);
+void pio_emu_set_input(struct pio_emu_sm *sm, pio_emu_input_fn input, void *context);
+
+/* Execute one PIO cycle */
+void pio_emu_step(struct pio_emu_sm *sm);
+/* Run until the SM stalls or max_cycles pass; returns the cycles run */
+uint64_t pio_emu_run_until_stall(struct pio_emu_sm *sm, uint64_t max_cycles);
+
+bool pio_emu_tx_push(struct pio_emu_sm *sm, uint32_t word);
+bool pio_emu_rx_pop(struct pio_emu_sm *sm, uint32_t *word);
+
+/* Level the SM drives or reads on `pin` */
+bool pio_emu_pin_level(const struct pio_emu_sm *sm, uint8_t pin);
+
+/*
+ * Queue TX words, then run until the SM stalls with the TX FIFO empty,
+ * draining the RX FIFO as the C side does. Returns the RX words read.
+ */
+int pio_emu_run_frame(struct pio_emu_sm *sm, const uint32_t *tx_words, int tx_count,
+                      uint32_t *rx_words, int max_rx_words, uint64_t max_cycles);
+
+/* Time of the start of PIO cycle `cycle`, with the fractional divider's clk_sys alignment */
+double pio_emu_cycle_time_ns(const struct pio_emu_sm *sm, uint64_t cycle);
+
+/* An externally driven line that idles high and toggles at the listed cycles */
+struct pio_emu_line {
+    uint8_t pin;
+    uint64_t toggles[PIO_EMU_MAX_LINE_TOGGLES];
+    int toggle_count;
+};
+
+/* pio_emu_input_fn for a struct pio_emu_line */
+uint32_t pio_emu_line_input(void *context, uint64_t cycle);
+/* Add an NRZI bit stream (1 = transition), MSB first, starting at cycle `start` */
+void pio_emu_line_add_nrzi(struct pio_emu_line *line, uint64_t start, uint32_t bits, int bit_count,
+                           double bit_cycles);
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Synthesizes DShot telemetry captures for host code that includes
+ * src/dshot/dshot.c directly. Include after dshot.c: the helpers use its
+ * capture layout constants.
+ */
+
+#ifndef TESTS_SUPPORT_DSHOT_CAPTURE_SYNTH_H
+#define TESTS_SUPPORT_DSHOT_CAPTURE_SYNTH_H
+
+#include <stdint.h>
+
+static const uint8_t reverse_gcr_table[16] = {
+    0x19, 0x1B, 0x12, 0x13, 0x1D, 0x15, 0x16, 0x17, 0x1A, 0x09, 0x0A, 0x0B, 0x1E, 0x0D, 0x0E, 0x0F,
+};
+
+static inline uint32_t encode_gcr20_from_final_word(uint16_t final_word) {
+    return ((uint32_t)reverse_gcr_table[(final_word >> 12) & 0x0F] << 15) |
+           ((uint32_t)reverse_gcr_table[(final_word >> 8) & 0x0F] << 10) |
+           ((uint32_t)reverse_gcr_table[(final_word >> 4) & 0x0F] << 5) |
+           reverse_gcr_table[final_word & 0x0F];
+}
+
+static inline uint16_t build_final_word(uint16_t value12) {
+    uint16_t crc = (uint16_t)(~(value12 ^ (value12 >> 4) ^ (value12 >> 8)) & 0x0F);
+    return (uint16_t)((value12 << 4) | crc);
+}
+
+static inline int gcr20_to_edge_diffs(uint32_t gcr20, uint8_t *edge_diffs) {
+    uint32_t stream21 = (1u << 20) | gcr20;
+    int edge_count = 0;
+    int run_length = 0;
+
+    for (int bit = 20; bit >= 0; --bit) {
+        run_length++;
+        if (bit == 0 || ((stream21 >> (bit - 1)) & 0x1u) != 0) {
+            edge_diffs[edge_count++] = (uint8_t)run_length;
+            run_length = 0;
+        }
+    }
+
+    return edge_count;
+}
+
+/* Sample a 21-bit GCR stream the way pio_dshot does: 18-cycle samples, 100-cycle bits */
+static inline void synthesize_oversampled_capture(uint32_t gcr20, uint32_t *buffer) {
+    uint32_t stream21 = (1u << 20) | gcr20;
+
+    for (int word = 0; word < OVERSAMPLE_WORDS; ++word) {
+        buffer[word] = 0;
+    }
+
+    for (int sample = 0; sample < 128; ++sample) {
+        int bit = (sample * PIO_CYCLES_PER_SAMPLE) / 100;
+        int level = 1;
+        if (bit <= 20) {
+            int ones = __builtin_popcount(stream21 >> (20 - bit));
+            level = (ones & 1) ? 0 : 1;
+        }
+        buffer[sample / 32] |= (uint32_t)level << (31 - (sample % 32));
+    }
+}
+
+/* Pack a 21-bit GCR stream the way pio_dshot_edge does: counts of 2 cycles, 100-cycle bits */
+static inline int synthesize_edge_capture(uint32_t gcr20, uint32_t *buffer) {
+    uint8_t edge_diffs[MAX_EDGES];
+    uint8_t bytes[MAX_EDGES + 2];
+    int byte_count = 0;
+    int edge_count = gcr20_to_edge_diffs(gcr20, edge_diffs);
+
+    bytes[byte_count++] = EDGE_CAPTURE_RUN_LIMIT - 40;
+    for (int i = 0; i < edge_count; ++i) {
+        bytes[byte_count++] = EDGE_CAPTURE_RUN_LIMIT - (edge_diffs[i] * 50 - 1);
+    }
+    bytes[byte_count++] = EDGE_CAPTURE_END_MARKER;
+
+    int word_count = (byte_count + 3) / 4;
+    int padding = (word_count * 4) - byte_count;
+    for (int word = 0; word < word_count; ++word) {
+        buffer[word] = 0;
+    }
+    for (int i = 0; i < byte_count; ++i) {
+        int slot = i < (word_count - 1) * 4 ? i : i + padding;
+        buffer[slot / 4] |= (uint32_t)bytes[i] << (24 - ((slot % 4) * 8));
+    }
+    return word_count;
+}
+
+#endif
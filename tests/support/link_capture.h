@@ -0,0 +1,69 @@
+/*
+ * In-memory link transport for tests: reads from a caller's buffer and
+ * collects writes, with an adjustable amount of free space to model a host
+ * that has stopped reading.
+ */
+
+#ifndef TESTS_SUPPORT_LINK_CAPTURE_H
+#define TESTS_SUPPORT_LINK_CAPTURE_H
+
+#include "link/transport.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LINK_CAPTURE_SIZE 512
+
+static const uint8_t *link_capture_input;
+static size_t link_capture_input_len;
+static uint8_t link_capture_output[LINK_CAPTURE_SIZE];
+static size_t link_capture_output_len;
+static size_t link_capture_limit; /* Total bytes the transport will take */
+static uint32_t link_capture_flushes;
+
+static inline size_t link_capture_read(uint8_t *buf, size_t len) {
+    size_t count = link_capture_input_len < len ? link_capture_input_len : len;
+    memcpy(buf, link_capture_input, count);
+    link_capture_input += count;
+    link_capture_input_len -= count;
+    return count;
+}
+
+static inline size_t link_capture_writable(void) {
+    return link_capture_limit - link_capture_output_len;
+}
+
+static inline size_t link_capture_write(const uint8_t *data, size_t len) {
+    size_t count = link_capture_writable();
+    if (count > len) {
+        count = len;
+    }
+    memcpy(&link_capture_output[link_capture_output_len], data, count);
+    link_capture_output_len += count;
+    return count;
+}
+
+static inline void link_capture_flush(void) {
+    link_capture_flushes++;
+}
+
+static const link_transport_t link_capture = {
+    .name = "capture",
+    .init = NULL,
+    .read = link_capture_read,
+    .write = link_capture_write,
+    .writable = link_capture_writable,
+    .flush = link_capture_flush,
+};
+
+/* Select the capture transport with the given input and room for limit bytes */
+static inline void link_capture_select(const uint8_t *input, size_t input_len, size_t limit) {
+    link_capture_input = input;
+    link_capture_input_len = input_len;
+    link_capture_output_len = 0;
+    link_capture_limit = limit < LINK_CAPTURE_SIZE ? limit : LINK_CAPTURE_SIZE;
+    link_capture_flushes = 0;
+    link_transport_select(&link_capture);
+}
+
+#endif
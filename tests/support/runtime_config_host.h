@@ -13,12 +13,60 @@ typedef enum {
 typedef struct {
     thruster_protocol_t protocol;
     uint16_t dshot_speed;
+    uint8_t command_format; /* usb_command_format_t (src/usb_comm.h) */
 } mcu_runtime_config_t;
 
+/*
+ * Config packet (5 bytes):
+ *   [0xC5] [protocol u4 | command_format u4 << 4] [dshot_speed u16 LE] [xor_checksum]
+ * The version reply carries the protocol byte the same way.
+ */
 #define USB_CONFIG_START_BYTE 0xC5
 #define USB_CONFIG_PACKET_SIZE 5
 #define USB_VERSION_START_BYTE 0xD5
 #define USB_VERSION_PACKET_SIZE 8
+/* In link protocol v2 the version reply also carries the link protocol, at [7] */
+#define USB_VERSION_V2_PACKET_SIZE 9
+
+/*
+ * Capability query (7 bytes, little-endian), accepted before the config:
+ *   [0xC8] [apply] [features u32] [xor_checksum]
+ * With apply nonzero, the features the MCU supports are set to those
+ * requested, and the others are left off; with apply 0 nothing changes.
+ * The reply is a capability packet (22 bytes, little-endian):
+ *   [0xD6] [capabilities u32] [features u32] [max_motors] [dshot_speeds]
+ *   [command_formats] [telemetry_formats] [link_protocols]
+ *   [input_packet_max u16] [tx_queue_size u16] [telemetry_queue u16]
+ *   [trajectory_points] [xor_checksum]
+ * features are those on after the query. dshot_speeds has a bit per speed in
+ * MCU_DSHOT_SPEEDS order; command_formats a bit per usb_command_format_t;
+ * telemetry_formats one per MCU_TELEMETRY_FORMAT_*; link_protocols bit n-1 for
+ * protocol n. tx_queue_size is per link stream, in bytes; telemetry_queue and
+ * trajectory_points are in values and points per motor.
+ */
+#define USB_CAPABILITY_QUERY_START_BYTE 0xC8
+#define USB_CAPABILITY_QUERY_PACKET_SIZE 7
+#define USB_CAPABILITY_START_BYTE 0xD6
+#define USB_CAPABILITY_PACKET_SIZE 22
+
+#define MCU_CAPABILITY_PWM (1u << 0)
+#define MCU_CAPABILITY_DSHOT (1u << 1)
+#define MCU_CAPABILITY_DSHOT_TELEMETRY (1u << 2) /* Bidirectional eRPM and EDT */
+#define MCU_CAPABILITY_TRAJECTORY (1u << 3)      /* src/trajectory.h */
+#define MCU_CAPABILITY_CLOCK_SYNC (1u << 4)      /* src/clock_sync.h */
+#define MCU_CAPABILITY_LINK_STATS (1u << 5)
+#define MCU_CAPABILITY_CAPTURE (1u << 6) /* src/dshot/capture_usb.h */
+
+/* Opt-in features, switched by a capability query with apply set */
+#define MCU_FEATURE_TELEMETRY_COALESCE (1u << 0) /* LINK_TX_POLICY_COALESCE */
+#define MCU_FEATURE_CAPTURE_FAILED (1u << 1)
+#define MCU_FEATURE_CAPTURE_SAMPLED (1u << 2) /* Failed frames and a sample of good ones */
+#define MCU_FEATURES_SUPPORTED                                                                     \
+    (MCU_FEATURE_TELEMETRY_COALESCE | MCU_FEATURE_CAPTURE_FAILED | MCU_FEATURE_CAPTURE_SAMPLED)
+
+#define MCU_DSHOT_SPEEDS {150, 300, 600, 1200}
+#define MCU_TELEMETRY_FORMAT_BATCH (1u << 0)       /* 0xA6 */
+#define MCU_TELEMETRY_FORMAT_TIMED_BATCH (1u << 1) /* 0xA8, once synced */
 
 bool mcu_runtime_config_parse_packet(const uint8_t *packet, size_t packet_size,
                                      mcu_runtime_config_t *out_config);
@@ -26,5 +74,10 @@ uint16_t mcu_runtime_config_normalize_dshot_speed(uint16_t requested_speed);
 void mcu_runtime_config_validate(mcu_runtime_config_t *config);
 const char *mcu_runtime_config_protocol_name(thruster_protocol_t protocol);
 void mcu_runtime_config_send_version(const mcu_runtime_config_t *config);
+/* Read a capability query; false if it is malformed */
+bool mcu_runtime_config_parse_capability_query(const uint8_t *packet, bool *apply,
+                                               uint32_t *features);
+/* Reply with the capability packet, given the features now on */
+void mcu_runtime_config_send_capabilities(uint32_t features);
 
 #endif
@@ -2,28 +2,148 @@
 #define TESTS_SUPPORT_USB_COMM_HOST_H
 
 #include "../mocks/pico/types.h"
+#include "link/frame.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #define USB_INPUT_START_BYTE 0x5A
 #define USB_CONFIG_START_BYTE 0xC5
+#define USB_LINK_PROTOCOL_START_BYTE 0xC6
+#define USB_LINK_PROTOCOL_PACKET_SIZE 3
 #define USB_INPUT_PACKET_SIZE(num_motors) (1 + ((num_motors) * 2) + 1)
+#define USB_INPUT_PACKED_START_BYTE 0x5B
+#define USB_INPUT_PACKED_PACKET_SIZE(num_motors) (1 + ((((num_motors) * 3) + 1) / 2) + 1)
+#define USB_INPUT_CHANGED_START_BYTE 0x5C
+#define USB_INPUT_MASK_SIZE(num_motors) (((num_motors) + 7) / 8)
+#define USB_INPUT_CHANGED_PACKET_SIZE(num_motors, changed)                                         \
+    (1 + USB_INPUT_MASK_SIZE(num_motors) + ((changed) * 2) + 1)
+#define USB_INPUT_DELTA_START_BYTE 0x5D
+#define USB_INPUT_DELTA_PACKET_SIZE(num_motors) (1 + (num_motors) + 1)
+/* Largest command packet in any format */
+#define USB_COMMAND_BUFFER_SIZE(num_motors) USB_INPUT_CHANGED_PACKET_SIZE(num_motors, num_motors)
+#define USB_COMMAND_VALUE_MAX 0x0FFF /* Largest value a packed or delta command can carry */
 #define USB_COMM_TIMEOUT_MS 200
+#define USB_LINK_STATS_START_BYTE 0xE5
+#define USB_LINK_STATS_PACKET_SIZE 74
+#define USB_RX_RING_SIZE 512 /* Power of two, holds many packets so bursts are not dropped */
+#define USB_RX_FRAME_MAX 192 /* Longest v2 input frame; longer runs without a delimiter are junk */
+/* Longest input packet: a v2 frame adds a COBS code, a sequence number and a CRC for the XOR */
+#define USB_INPUT_PACKET_MAX (USB_RX_FRAME_MAX - 3)
 
 typedef enum {
     USB_PACKET_NONE = 0,
     USB_PACKET_COMMAND,
     USB_PACKET_CONFIG,
+    USB_PACKET_LINK_PROTOCOL,
+    USB_PACKET_TRAJECTORY, /* src/trajectory.h */
+    USB_PACKET_CLOCK_SYNC,       /* Ping, src/clock_sync.h */
+    USB_PACKET_CAPABILITY_QUERY, /* src/runtime_config.h */
 } usb_packet_kind_t;
 
+/*
+ * Command packet formats, chosen by the config packet (src/runtime_config.h).
+ * Full packets are accepted in every format; the others only once chosen.
+ *   FULL:    [0x5A] [value u16 LE per motor] [xor_checksum]
+ *   PACKED:  [0x5B] [value u12 per motor, two motors per 3 bytes] [xor_checksum]
+ *            Motor 2k is the low 12 bits of the 3 bytes LE, motor 2k+1 the high
+ *            12; an odd last motor takes 2 bytes.
+ *   CHANGED: [0x5C] [motor mask, bit i = motor i] [value u16 LE per set bit]
+ *            [xor_checksum]; motors not in the mask keep their value
+ *   DELTA:   [0x5D] [change i8 per motor] [xor_checksum]; the change is added
+ *            to the motor's value, clamped to 0..USB_COMMAND_VALUE_MAX
+ * CHANGED and DELTA packets build on the values in use, so only a newer FULL
+ * or PACKED packet makes them stale. After a timeout or a lost packet the
+ * host sends a FULL or PACKED one.
+ */
+typedef enum {
+    USB_COMMAND_FORMAT_FULL = 0,
+    USB_COMMAND_FORMAT_PACKED,
+    USB_COMMAND_FORMAT_CHANGED,
+    USB_COMMAND_FORMAT_DELTA,
+    USB_COMMAND_FORMAT_COUNT,
+} usb_command_format_t;
+
+/* Input counters since boot, kept by usb_poll_multi() */
+typedef struct {
+    uint32_t command_packets; /* Complete command and trajectory packets, checksum valid */
+    uint32_t config_packets;  /* Complete packets of every other kind, checksum valid */
+    uint32_t checksum_errors; /* Packet candidates or v2 frames that failed their check */
+    uint32_t bytes_discarded; /* Bytes skipped while looking for a start byte or delimiter */
+    uint32_t sequence_gaps;   /* v2 frames missing from the input sequence */
+    uint32_t stale_commands;  /* Command packets replaced by a newer one before use */
+} usb_link_stats_t;
+
 uint8_t usb_calculate_checksum(const uint8_t *data, size_t len);
+/*
+ * Read all buffered USB input into the receive ring in bulk, then return the
+ * next complete packet with a valid checksum, copied to command_buf or
+ * config_buf. Bytes before a start byte are skipped. After a checksum failure
+ * the scan resumes one byte later, so a good packet that follows a damaged
+ * one is still found. An incomplete packet stays in the ring for the next call.
+ *
+ * In protocol v2 the input is split into frames at their delimiters instead
+ * (link/frame.h). A decoded packet is returned in its v1 layout, XOR byte
+ * included. A v1 config or link protocol packet where a frame should start,
+ * or inside input that does not decode as frames, switches the link back to
+ * v1, so a v1 host can always take over.
+ *
+ * config_buf also receives link protocol packets. command_packet_size is the
+ * size of a full command packet and sets the motor count; with the CHANGED
+ * format, command_buf needs USB_COMMAND_BUFFER_SIZE() bytes. command_buf also
+ * receives trajectory, ping and capability query packets, up to
+ * USB_INPUT_PACKET_MAX bytes.
+ */
 usb_packet_kind_t usb_poll_multi(uint8_t *command_buf, size_t command_packet_size,
-                                 size_t *command_idx, uint8_t *config_buf,
-                                 size_t config_packet_size, size_t *config_idx);
+                                 uint8_t *config_buf, size_t config_packet_size);
+/*
+ * As usb_poll_multi(), but a command packet is returned only once no newer
+ * FULL or PACKED one follows it in the buffered input; the ones it replaces
+ * are counted as stale. Any other packet after a command, CHANGED and DELTA
+ * ones included, is returned by the next call, so it keeps its place between
+ * commands. Called until it returns USB_PACKET_NONE, it drains all
+ * buffered input.
+ */
+usb_packet_kind_t usb_poll_latest(uint8_t *command_buf, size_t command_packet_size,
+                                  uint8_t *config_buf, size_t config_packet_size);
+/* Parse a FULL command packet */
 bool usb_parse_packet(const uint8_t *usb_buf, size_t packet_size, uint16_t *raw_values,
                       int num_motors, absolute_time_t *last_comm_time);
+/* Apply a command packet in any format to raw_values, after checking its checksum */
+bool usb_apply_command(const uint8_t *usb_buf, uint16_t *raw_values, int num_motors,
+                       absolute_time_t *last_comm_time);
+/* Accept FULL packets and those of the format; USB_COMMAND_FORMAT_FULL after a reset */
+void usb_set_command_format(usb_command_format_t format);
+usb_command_format_t usb_command_format(void);
 void usb_check_timeout(absolute_time_t last_comm_time, uint16_t *thruster_values, int num_motors,
-                       uint16_t neutral_value, size_t *usb_idx, bool *comm_timed_out);
+                       uint16_t neutral_value, bool *comm_timed_out);
+
+/*
+ * Link protocol packet (3 bytes, host to MCU, in v1 or v2):
+ *   [0xC6] [version u8] [xor_checksum]
+ * Switches both directions to the version if it is supported; returns false
+ * and keeps the current one otherwise. The firmware answers with a version
+ * packet in the protocol then in use.
+ */
+bool usb_set_link_protocol(uint8_t version);
+link_protocol_t usb_link_protocol(void);
+
+const usb_link_stats_t *usb_link_stats(void);
+/* Drop buffered input and held packets, clear the link stats and return to protocol v1 */
+void usb_comm_reset(void);
+/*
+ * Link stats packet (74 bytes):
+ *   [0xE5] [command_packets u32] [config_packets u32] [checksum_errors u32]
+ *   [bytes_discarded u32] [tx bytes_written u32] [tx write_time_us u32]
+ *   [dropped u32 x 4: control, log, telemetry values, capture]
+ *   [sequence_gaps u32] [stale_commands u32] [time_us u32]
+ *   [trajectory points_late u32] [trajectory points_dropped u32]
+ *   [rtt_min_us u32] [rtt_mean_us u32] [rtt_max_us u32] [xor_checksum]
+ * The tx fields are link_tx_stats() (link/transport.h) and the drops
+ * link_tx_dropped() (link/tx.h). time_us is the MCU time the packet was
+ * queued, the clock trajectory packets are timed on (trajectory.h). The round
+ * trips are those the host reported in its pings (clock_sync.h).
+ */
+void usb_link_stats_send(void);
 
 #endif
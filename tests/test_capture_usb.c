@@ -0,0 +1,136 @@
+#include "dshot/capture_usb.h"
+#include "dshot/telemetry_usb.h"
+#include "link/tx.h"
+#include "mocks/mock_sdk.h"
+#include "support/link_capture.h"
+#include "unity/unity.h"
+#include <string.h>
+
+/* Encoded size of a capture with this many words */
+#define CAPTURE_PACKET_SIZE(words) (CAPTURE_HEADER_SIZE + ((words) * 4) + 1)
+
+static dshot_telemetry_context_t capture_context = {.controller_base_global_id = 4};
+
+static void start_capture(enum dshot_capture_usb_mode mode) {
+    link_tx_reset();
+    link_capture_select(NULL, 0, LINK_CAPTURE_SIZE);
+    dshot_capture_usb_init();
+    dshot_capture_usb_set_mode(mode);
+}
+
+static void stop_capture(void) {
+    dshot_capture_usb_set_mode(CAPTURE_USB_MODE_OFF);
+    dshot_capture_usb_init();
+    link_tx_init();
+    link_transport_select(&link_transport_stdio);
+}
+
+static void record(enum dshot_capture_reason reason, uint32_t word) {
+    dshot_capture_callback(&capture_context, 1, reason, DSHOT_RX_CAPTURE_EDGE, &word, 1);
+}
+
+/* Send what the ring and rate limit allow and return the number of packets written */
+static uint32_t drain_captures(void) {
+    dshot_capture_usb_flush();
+    link_tx_flush();
+    uint32_t packets = (uint32_t)(link_capture_output_len / CAPTURE_PACKET_SIZE(1));
+    link_capture_output_len = 0;
+    return packets;
+}
+
+static void test_capture_usb_encodes_packet(void) {
+    const uint32_t words[2] = {0x11223344, 0x55667788};
+    const uint8_t expected_header[CAPTURE_HEADER_SIZE] = {
+        CAPTURE_START_BYTE, 5, DSHOT_CAPTURE_REASON_BAD_CRC, DSHOT_RX_CAPTURE_EDGE,
+        0x40, 0xE2, 0x01, 0x00, 2};
+    uint8_t checksum = 0;
+
+    start_capture(CAPTURE_USB_MODE_FAILED);
+    mock_time_set_us(123456);
+    dshot_capture_callback(&capture_context, 1, DSHOT_CAPTURE_REASON_BAD_CRC,
+                           DSHOT_RX_CAPTURE_EDGE, words, 2);
+    dshot_capture_usb_flush();
+    link_tx_flush();
+    size_t written = link_capture_output_len;
+    for (size_t i = 0; i < CAPTURE_PACKET_SIZE(2) - 1; ++i) {
+        checksum ^= link_capture_output[i];
+    }
+    stop_capture();
+
+    TEST_ASSERT_EQUAL_size_t(CAPTURE_PACKET_SIZE(2), written);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected_header, link_capture_output, CAPTURE_HEADER_SIZE);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(words, &link_capture_output[CAPTURE_HEADER_SIZE], sizeof(words));
+    TEST_ASSERT_EQUAL_HEX8(checksum, link_capture_output[CAPTURE_PACKET_SIZE(2) - 1]);
+}
+
+static void test_capture_usb_full_ring_drops_oldest(void) {
+    uint32_t first_word;
+
+    start_capture(CAPTURE_USB_MODE_FAILED);
+    /* The ring keeps one slot free, so the sixteenth capture pushes out the first */
+    for (uint32_t i = 0; i < 16; ++i) {
+        record(DSHOT_CAPTURE_REASON_BAD_GCR, i);
+    }
+    uint32_t dropped = dshot_capture_usb_dropped();
+    uint32_t link_dropped = link_tx_dropped(LINK_STREAM_CAPTURE);
+    dshot_capture_usb_flush();
+    link_tx_flush();
+    memcpy(&first_word, &link_capture_output[CAPTURE_HEADER_SIZE], sizeof(first_word));
+    stop_capture();
+
+    TEST_ASSERT_EQUAL_UINT32(1, dropped);
+    TEST_ASSERT_EQUAL_UINT32(1, link_dropped);
+    TEST_ASSERT_EQUAL_UINT32(1, first_word);
+}
+
+static void test_capture_usb_limits_packets_per_second(void) {
+    uint32_t sent = 0;
+
+    start_capture(CAPTURE_USB_MODE_FAILED);
+    for (uint32_t i = 0; i < CAPTURE_MAX_PER_SECOND + 10; ++i) {
+        mock_time_advance_us(1000);
+        record(DSHOT_CAPTURE_REASON_BAD_CRC, i);
+        sent += drain_captures();
+    }
+    uint32_t sent_in_first_second = sent;
+    mock_time_advance_us(1000000);
+    sent += drain_captures();
+    uint32_t dropped = dshot_capture_usb_dropped();
+    stop_capture();
+
+    TEST_ASSERT_EQUAL_UINT32(CAPTURE_MAX_PER_SECOND, sent_in_first_second);
+    TEST_ASSERT_EQUAL_UINT32(CAPTURE_MAX_PER_SECOND + 10, sent);
+    TEST_ASSERT_EQUAL_UINT32(0, dropped);
+}
+
+static void test_capture_usb_samples_good_frames(void) {
+    uint32_t failed_only = 0;
+    uint32_t sampled = 0;
+
+    start_capture(CAPTURE_USB_MODE_FAILED);
+    for (uint32_t i = 0; i < CAPTURE_GOOD_SAMPLE_INTERVAL; ++i) {
+        record(DSHOT_CAPTURE_REASON_OK, i);
+    }
+    failed_only = drain_captures();
+
+    dshot_capture_usb_init();
+    dshot_capture_usb_set_mode(CAPTURE_USB_MODE_FAILED_AND_SAMPLED);
+    for (uint32_t i = 1; i <= 2 * CAPTURE_GOOD_SAMPLE_INTERVAL; ++i) {
+        record(DSHOT_CAPTURE_REASON_OK, i);
+        if (i == CAPTURE_GOOD_SAMPLE_INTERVAL - 1) {
+            TEST_ASSERT_EQUAL_UINT32(0, drain_captures());
+        }
+    }
+    sampled = drain_captures();
+    stop_capture();
+
+    TEST_ASSERT_EQUAL_UINT32(0, failed_only);
+    TEST_ASSERT_EQUAL_UINT32(2, sampled);
+}
+
+void test_capture_usb(void) {
+    RUN_TEST(test_capture_usb_encodes_packet);
+    RUN_TEST(test_capture_usb_full_ring_drops_oldest);
+    RUN_TEST(test_capture_usb_limits_packets_per_second);
+    RUN_TEST(test_capture_usb_samples_good_frames);
+}
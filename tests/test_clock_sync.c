@@ -0,0 +1,163 @@
+#include "clock_sync.h"
+#include "link/tx.h"
+#include "mocks/mock_sdk.h"
+#include "support/link_capture.h"
+#include "support/usb_comm_host.h"
+#include "unity/unity.h"
+#include <string.h>
+
+static void build_ping(uint8_t *packet, uint8_t seq, uint32_t host_time_us,
+                       uint32_t previous_rtt_us) {
+    packet[0] = CLOCK_SYNC_PING_START_BYTE;
+    packet[1] = seq;
+    memcpy(&packet[2], &host_time_us, sizeof(host_time_us));
+    memcpy(&packet[6], &previous_rtt_us, sizeof(previous_rtt_us));
+    packet[CLOCK_SYNC_PING_PACKET_SIZE - 1] =
+        usb_calculate_checksum(packet, CLOCK_SYNC_PING_PACKET_SIZE - 1);
+}
+
+/* The host clock runs 100 ppm fast and 5 s ahead; pings take half of rtt_us each way */
+static uint32_t host_time_at(uint64_t mcu_us) {
+    return (uint32_t)(5000000 + mcu_us + (mcu_us / 10000));
+}
+
+static uint8_t ping_seq;
+
+/* A ping that took in_us to arrive at mcu_us, reporting the previous ping's round trip */
+static void send_ping(uint64_t mcu_us, uint32_t in_us, uint32_t host_step_us,
+                      uint32_t previous_rtt_us) {
+    uint8_t packet[CLOCK_SYNC_PING_PACKET_SIZE];
+    mock_time_set_us(mcu_us);
+    build_ping(packet, ping_seq++, host_time_at(mcu_us - in_us) + host_step_us, previous_rtt_us);
+    TEST_ASSERT_TRUE(clock_sync_handle_ping(packet, mock_time_get_us()));
+}
+
+static void ping_at(uint64_t mcu_us, uint32_t rtt_us) {
+    send_ping(mcu_us, rtt_us / 2, 0, rtt_us);
+}
+
+static void start_sync(void) {
+    clock_sync_reset();
+    link_tx_reset();
+    ping_seq = 0;
+}
+
+static void stop_sync(void) {
+    clock_sync_reset();
+    link_tx_reset();
+    link_transport_select(&link_transport_stdio);
+}
+
+static void test_clock_sync_tracks_host_offset_and_drift(void) {
+    uint32_t host_us = 0;
+
+    start_sync();
+    TEST_ASSERT_FALSE(clock_sync_host_time_us(1000, &host_us));
+    for (int i = 1; i <= 100; ++i) {
+        ping_at((uint64_t)i * 100000, 300);
+        link_tx_reset();
+    }
+
+    TEST_ASSERT_TRUE(clock_sync_synced());
+    TEST_ASSERT_TRUE(clock_sync_host_time_us(10500000, &host_us));
+    TEST_ASSERT_INT32_WITHIN(20, (int32_t)host_time_at(10500000), (int32_t)host_us);
+    TEST_ASSERT_INT32_WITHIN(10000, 100000, clock_sync_stats()->drift_ppb);
+    /* The last ping's sample waits for the next ping's round trip */
+    TEST_ASSERT_EQUAL_UINT32(99, clock_sync_stats()->samples_used);
+    TEST_ASSERT_EQUAL_UINT32(300, clock_sync_stats()->rtt_mean_us);
+    stop_sync();
+}
+
+static void test_clock_sync_skips_slow_round_trips(void) {
+    uint32_t before_us = 0;
+    uint32_t after_us = 0;
+
+    start_sync();
+    ping_at(100000, 300);
+    ping_at(200000, 300);
+    /* Held on the host for 8 ms after it was stamped, following a fast ping */
+    send_ping(300000, 8150, 0, 300);
+    clock_sync_host_time_us(250000, &before_us);
+    ping_at(400000, 8300);
+    clock_sync_host_time_us(250000, &after_us);
+
+    TEST_ASSERT_EQUAL_UINT32(before_us, after_us);
+    TEST_ASSERT_EQUAL_UINT32(4, clock_sync_stats()->pings);
+    TEST_ASSERT_EQUAL_UINT32(2, clock_sync_stats()->samples_used);
+    TEST_ASSERT_EQUAL_UINT32(300, clock_sync_stats()->rtt_min_us);
+    TEST_ASSERT_EQUAL_UINT32(8300, clock_sync_stats()->rtt_max_us);
+    stop_sync();
+}
+
+static void test_clock_sync_restarts_after_host_clock_step(void) {
+    uint32_t before_us = 0;
+    uint32_t host_us = 0;
+
+    start_sync();
+    ping_at(100000, 300);
+    ping_at(200000, 300);
+    ping_at(300000, 300);
+
+    /* The first sample after the step is taken for an outlier */
+    send_ping(400000, 150, 1000000, 300);
+    clock_sync_host_time_us(400000, &before_us);
+    send_ping(500000, 150, 1000000, 300);
+    TEST_ASSERT_TRUE(clock_sync_host_time_us(400000, &host_us));
+    TEST_ASSERT_EQUAL_UINT32(before_us, host_us);
+    TEST_ASSERT_GREATER_THAN_INT32(CLOCK_SYNC_STEP_US, clock_sync_stats()->offset_error_us);
+
+    send_ping(600000, 150, 1000000, 300);
+    TEST_ASSERT_TRUE(clock_sync_host_time_us(500000, &host_us));
+    TEST_ASSERT_UINT32_WITHIN(2, host_time_at(500000) + 1000000, host_us);
+    TEST_ASSERT_EQUAL_INT32(0, clock_sync_stats()->drift_ppb);
+    stop_sync();
+}
+
+static void test_clock_sync_needs_round_trip_of_previous_ping(void) {
+    start_sync();
+    ping_at(100000, 0);
+    ping_seq++; /* Lost on the way */
+    ping_at(300000, 300);
+
+    TEST_ASSERT_FALSE(clock_sync_synced());
+    TEST_ASSERT_EQUAL_UINT32(0, clock_sync_stats()->samples_used);
+    ping_at(400000, 300);
+    TEST_ASSERT_TRUE(clock_sync_synced());
+    stop_sync();
+}
+
+static void test_clock_sync_answers_ping_with_pong(void) {
+    uint8_t packet[CLOCK_SYNC_PING_PACKET_SIZE];
+    uint32_t value;
+
+    start_sync();
+    link_capture_select(NULL, 0, LINK_CAPTURE_SIZE);
+    build_ping(packet, 7, 123456, 0);
+    mock_time_set_us(2000);
+    TEST_ASSERT_TRUE(clock_sync_handle_ping(packet, 1500));
+    packet[CLOCK_SYNC_PING_PACKET_SIZE - 1] ^= 0xFF;
+    TEST_ASSERT_FALSE(clock_sync_handle_ping(packet, 1500));
+    link_tx_flush();
+
+    TEST_ASSERT_FALSE(clock_sync_synced());
+    TEST_ASSERT_EQUAL_size_t(CLOCK_SYNC_PONG_PACKET_SIZE, link_capture_output_len);
+    TEST_ASSERT_EQUAL_HEX8(CLOCK_SYNC_PONG_START_BYTE, link_capture_output[0]);
+    TEST_ASSERT_EQUAL_UINT8(7, link_capture_output[1]);
+    memcpy(&value, &link_capture_output[2], sizeof(value));
+    TEST_ASSERT_EQUAL_UINT32(123456, value);
+    memcpy(&value, &link_capture_output[6], sizeof(value));
+    TEST_ASSERT_EQUAL_UINT32(1500, value);
+    memcpy(&value, &link_capture_output[10], sizeof(value));
+    TEST_ASSERT_EQUAL_UINT32(2000, value);
+    TEST_ASSERT_EQUAL_HEX8(usb_calculate_checksum(link_capture_output, 14),
+                           link_capture_output[14]);
+    stop_sync();
+}
+
+void test_clock_sync(void) {
+    RUN_TEST(test_clock_sync_tracks_host_offset_and_drift);
+    RUN_TEST(test_clock_sync_skips_slow_round_trips);
+    RUN_TEST(test_clock_sync_restarts_after_host_clock_step);
+    RUN_TEST(test_clock_sync_needs_round_trip_of_previous_ping);
+    RUN_TEST(test_clock_sync_answers_ping_with_pong);
+}
@@ -1,50 +1,21 @@
 /* Include the implementation directly to access static functions */
 #include "../src/dshot/dshot.c"
+#include "mocks/mock_sdk.h"
+#include "sim/pio_emu.h"
+#include "support/dshot_capture_synth.h"
 #include "unity/unity.h"
 
-static const uint8_t reverse_gcr_table[16] = {
-    0x19, 0x1B, 0x12, 0x13, 0x1D, 0x15, 0x16, 0x17, 0x1A, 0x09, 0x0A, 0x0B, 0x1E, 0x0D, 0x0E, 0x0F,
-};
-
 static uint16_t expected_dshot_frame(uint16_t throttle, int telemetry) {
     uint16_t value = (uint16_t)((throttle << 1) | telemetry);
     uint16_t crc = (uint16_t)(~(value ^ (value >> 4) ^ (value >> 8)) & 0x0F);
     return (uint16_t)((value << 4) | crc);
 }
 
-static uint32_t encode_gcr20_from_final_word(uint16_t final_word) {
-    return ((uint32_t)reverse_gcr_table[(final_word >> 12) & 0x0F] << 15) |
-           ((uint32_t)reverse_gcr_table[(final_word >> 8) & 0x0F] << 10) |
-           ((uint32_t)reverse_gcr_table[(final_word >> 4) & 0x0F] << 5) |
-           reverse_gcr_table[final_word & 0x0F];
-}
-
-static uint16_t build_final_word(uint16_t value12) {
-    uint16_t crc = (uint16_t)(~(value12 ^ (value12 >> 4) ^ (value12 >> 8)) & 0x0F);
-    return (uint16_t)((value12 << 4) | crc);
-}
-
-static int gcr20_to_edge_diffs(uint32_t gcr20, uint8_t *edge_diffs) {
-    uint32_t stream21 = (1u << 20) | gcr20;
-    int edge_count = 0;
-    int run_length = 0;
-
-    for (int bit = 20; bit >= 0; --bit) {
-        run_length++;
-        if (bit == 0 || ((stream21 >> (bit - 1)) & 0x1u) != 0) {
-            edge_diffs[edge_count++] = (uint8_t)run_length;
-            run_length = 0;
-        }
-    }
-
-    return edge_count;
-}
-
-static void set_simple_run_length_thresholds(void) {
-    length_transitions[0] = 0;
-    length_transitions[1] = 2;
-    length_transitions[2] = 3;
-    length_transitions[3] = 4;
+static void set_simple_run_length_thresholds(struct dshot_rx_calibration *calibration) {
+    calibration->length_transitions[0] = 0;
+    calibration->length_transitions[1] = 2;
+    calibration->length_transitions[2] = 3;
+    calibration->length_transitions[3] = 4;
 }
 
 static void test_dshot_compute_frame_builds_zero_throttle_frame(void) {
@@ -146,28 +117,329 @@ static void test_dshot_get_telemetry_quality_percent_rejects_invalid_channel(voi
 }
 
 static void test_build_gcr_word_rejects_invalid_edge_counts(void) {
+    struct dshot_rx_calibration calibration = {0};
     uint32_t gcr20 = 0;
     uint8_t edge_diffs[22] = {0};
 
-    TEST_ASSERT_EQUAL_INT(DECODE_FAIL_EDGE_COUNT, build_gcr_word(edge_diffs, 1, &gcr20));
-    TEST_ASSERT_EQUAL_INT(DECODE_FAIL_EDGE_COUNT, build_gcr_word(edge_diffs, 22, &gcr20));
+    TEST_ASSERT_EQUAL_INT(DECODE_FAIL_EDGE_COUNT,
+                          build_gcr_word(&calibration, edge_diffs, 1, &gcr20));
+    TEST_ASSERT_EQUAL_INT(DECODE_FAIL_EDGE_COUNT,
+                          build_gcr_word(&calibration, edge_diffs, 22, &gcr20));
 }
 
 static void test_build_gcr_word_builds_expected_word_from_valid_edges(void) {
     uint16_t final_word = build_final_word(0x0ABC);
     uint32_t target_gcr20 = encode_gcr20_from_final_word(final_word);
+    struct dshot_rx_calibration calibration = {0};
     uint8_t edge_diffs[MAX_EDGES] = {0};
     uint32_t built_word = 0;
     int edge_count;
 
-    set_simple_run_length_thresholds();
+    set_simple_run_length_thresholds(&calibration);
     edge_count = gcr20_to_edge_diffs(target_gcr20, edge_diffs);
 
-    TEST_ASSERT_EQUAL_INT(DECODE_OK, build_gcr_word(edge_diffs, edge_count, &built_word));
+    TEST_ASSERT_EQUAL_INT(DECODE_OK,
+                          build_gcr_word(&calibration, edge_diffs, edge_count, &built_word));
     TEST_ASSERT_EQUAL_HEX32(1u << 20, built_word & (1u << 20));
     TEST_ASSERT_EQUAL_HEX32(target_gcr20, built_word & 0xFFFFFu);
 }
 
+static void test_set_length_transitions_matches_default_thresholds(void) {
+    struct dshot_rx_calibration calibration = {0};
+
+    reset_rx_calibration(&calibration, DSHOT_RX_CAPTURE_OVERSAMPLE);
+
+    TEST_ASSERT_EQUAL_UINT16(1422, calibration.samples_per_bit_q8);
+    TEST_ASSERT_EQUAL_UINT8(3, calibration.length_transitions[0]);
+    TEST_ASSERT_EQUAL_UINT8(9, calibration.length_transitions[1]);
+    TEST_ASSERT_EQUAL_UINT8(14, calibration.length_transitions[2]);
+    TEST_ASSERT_EQUAL_UINT8(22, calibration.length_transitions[3]);
+}
+
+static void fill_single_bit_runs(uint8_t *edge_diffs, int edge_count, uint8_t samples) {
+    for (int i = 0; i < edge_count; ++i) {
+        edge_diffs[i] = samples;
+    }
+}
+
+static void test_bit_period_calibration_is_tracked_per_motor(void) {
+    struct dshot_controller controller = {0};
+    uint8_t edge_diffs[15];
+
+    controller.num_channels = 2;
+    dshot_controller_reset_calibration(&controller);
+    fill_single_bit_runs(edge_diffs, 15, 6);
+
+    for (int frame = 0; frame < CALIBRATION_FRAMES; ++frame) {
+        update_bit_period_tracking(&controller.motor[1].calibration, edge_diffs, 15);
+    }
+
+    TEST_ASSERT_FALSE(controller.motor[0].calibration.complete);
+    TEST_ASSERT_EQUAL_UINT16(1422, controller.motor[0].calibration.samples_per_bit_q8);
+    TEST_ASSERT_TRUE(controller.motor[1].calibration.complete);
+    TEST_ASSERT_EQUAL_UINT16(6u << 8, controller.motor[1].calibration.samples_per_bit_q8);
+    TEST_ASSERT_EQUAL_UINT8(15, controller.motor[1].calibration.length_transitions[2]);
+    TEST_ASSERT_EQUAL_UINT8(21, controller.motor[1].calibration.length_transitions[3]);
+}
+
+static void test_bit_period_tracking_follows_drift_after_acquisition(void) {
+    struct dshot_rx_calibration calibration = {0};
+    uint8_t edge_diffs[15];
+
+    reset_rx_calibration(&calibration, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    fill_single_bit_runs(edge_diffs, 15, 6);
+    for (int frame = 0; frame < CALIBRATION_FRAMES; ++frame) {
+        update_bit_period_tracking(&calibration, edge_diffs, 15);
+    }
+
+    fill_single_bit_runs(edge_diffs, 15, 7);
+    for (int frame = 0; frame < 200; ++frame) {
+        update_bit_period_tracking(&calibration, edge_diffs, 15);
+    }
+
+    TEST_ASSERT_UINT16_WITHIN(2, 7u << 8, calibration.samples_per_bit_q8);
+    TEST_ASSERT_EQUAL_UINT8(11, calibration.length_transitions[1]);
+}
+
+static void test_bit_period_tracking_rejects_outliers(void) {
+    struct dshot_rx_calibration calibration = {0};
+    uint8_t edge_diffs[15];
+
+    reset_rx_calibration(&calibration, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    fill_single_bit_runs(edge_diffs, 15, 8);
+    for (int frame = 0; frame < CALIBRATION_FRAMES; ++frame) {
+        update_bit_period_tracking(&calibration, edge_diffs, 15);
+    }
+
+    TEST_ASSERT_FALSE(calibration.complete);
+    TEST_ASSERT_EQUAL_UINT8(0, calibration.frame_count);
+}
+
+static void test_decode_oversampled_capture_returns_frame(void) {
+    struct dshot_rx_calibration calibration = {0};
+    uint16_t final_word = build_final_word(0x0ABC);
+    uint32_t buffer[OVERSAMPLE_WORDS];
+    uint32_t decoded = 0;
+
+    reset_rx_calibration(&calibration, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    synthesize_oversampled_capture(encode_gcr20_from_final_word(final_word), buffer);
+
+    TEST_ASSERT_EQUAL_INT(DECODE_OK,
+                          decode_oversampled_telemetry(&calibration, DSHOT_RX_CAPTURE_OVERSAMPLE,
+                                                       buffer, OVERSAMPLE_WORDS, &decoded));
+    TEST_ASSERT_EQUAL_HEX32(final_word, decoded);
+}
+
+static void queue_oversampled_response(uint16_t value12) {
+    uint32_t buffer[OVERSAMPLE_WORDS];
+
+    synthesize_oversampled_capture(encode_gcr20_from_final_word(build_final_word(value12)), buffer);
+    for (int i = 0; i < OVERSAMPLE_WORDS; ++i) {
+        mock_pio_rx_push(0, 0, buffer[i]);
+    }
+    mock_pio_rx_push(0, 0, 0);
+}
+
+static void test_dshot_loop_decodes_queued_response(void) {
+    struct dshot_controller controller;
+    uint32_t word;
+
+    dshot_controller_init(&controller, 600, pio0, 0, 6, 1, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    queue_oversampled_response(0x0064);
+    dshot_loop(&controller);
+
+    TEST_ASSERT_TRUE(mock_pio_tx_pop(0, 0, &word));
+    TEST_ASSERT_EQUAL_HEX32(~(uint32_t)controller.motor[0].frame << 16, word);
+    TEST_ASSERT_EQUAL_UINT32(1, controller.motor[0].stats.rx_frames);
+    TEST_ASSERT_EQUAL_UINT32(6000, controller.motor[0].telemetry_data[DSHOT_TELEMETRY_TYPE_ERPM]);
+    TEST_ASSERT_EQUAL_UINT32(0, mock_pio_rx_level(0, 0));
+}
+
+static void test_dshot_loop_times_out_on_virtual_clock(void) {
+    struct dshot_controller controller;
+
+    dshot_controller_init(&controller, 600, pio0, 0, 6, 1, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    dshot_loop(&controller);
+
+    TEST_ASSERT_EQUAL_UINT32(1, controller.motor[0].stats.rx_timeout);
+    TEST_ASSERT_UINT64_WITHIN(2 * MOCK_FIFO_POLL_US, RX_READ_TIMEOUT_US, mock_time_get_us());
+    TEST_ASSERT_TRUE(mock_pio_sm_is_enabled(0, 0));
+}
+
+static void test_dshot_loop_drains_word_left_after_edge_marker(void) {
+    struct dshot_controller controller;
+    uint32_t buffer[EDGE_CAPTURE_MAX_WORDS];
+    uint32_t word;
+
+    dshot_controller_init(&controller, 600, pio0, 0, 6, 1, DSHOT_RX_CAPTURE_EDGE);
+    /* A stuck-low abort whose marker completed the word, as in test_pio_emu.c */
+    mock_pio_rx_push(0, 0, 0xC8AF64FF);
+    mock_pio_rx_push(0, 0, 0);
+    TEST_ASSERT_EQUAL_INT(1, dshot_read_rx_words(&controller, buffer));
+    dshot_loop_async_start(&controller);
+
+    TEST_ASSERT_EQUAL_UINT32(0, mock_pio_rx_level(0, 0));
+    TEST_ASSERT_TRUE(mock_pio_tx_pop(0, 0, &word));
+    TEST_ASSERT_EQUAL_HEX32(~(uint32_t)controller.motor[0].frame << 16, word);
+}
+
+static void test_dshot_quality_window_expires_old_failures(void) {
+    struct dshot_controller controller;
+    uint32_t word;
+
+    dshot_controller_init(&controller, 600, pio0, 0, 6, 1, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    dshot_loop(&controller);
+    TEST_ASSERT_EQUAL_UINT32(1, controller.motor[0].quality.invalid_count_sum);
+
+    for (int bucket = 1; bucket <= DSHOT_TELEMETRY_QUALITY_BUCKET_COUNT; ++bucket) {
+        mock_time_set_us((uint64_t)bucket * DSHOT_TELEMETRY_QUALITY_BUCKET_MS * 1000);
+        while (mock_pio_tx_pop(0, 0, &word)) {
+        }
+        queue_oversampled_response(0x0064);
+        dshot_loop(&controller);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, controller.motor[0].quality.invalid_count_sum);
+    TEST_ASSERT_EQUAL_INT16(10000, dshot_get_telemetry_quality_percent(&controller, 0));
+}
+
+static void test_filter_glitch_runs_merges_short_spikes(void) {
+    uint8_t edge_diffs[] = {5, 4, 1, 6, 11, 2, 5};
+    uint8_t expected[] = {5, 11, 11, 2, 5};
+
+    TEST_ASSERT_EQUAL_INT(7, filter_glitch_runs(edge_diffs, 7, 0));
+    TEST_ASSERT_EQUAL_INT(5, filter_glitch_runs(edge_diffs, 7, 2));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, edge_diffs, 5);
+}
+
+static void test_decode_edge_capture_returns_frame(void) {
+    struct dshot_rx_calibration calibration = {0};
+    uint16_t final_word = build_final_word(0x0ABC);
+    uint32_t buffer[EDGE_CAPTURE_MAX_WORDS];
+    uint32_t decoded = 0;
+    int word_count;
+
+    reset_rx_calibration(&calibration, DSHOT_RX_CAPTURE_EDGE);
+    word_count = synthesize_edge_capture(encode_gcr20_from_final_word(final_word), buffer);
+
+    TEST_ASSERT_EQUAL_UINT8(EDGE_CAPTURE_END_MARKER, buffer[word_count - 1] & 0xFF);
+    TEST_ASSERT_EQUAL_INT(DECODE_OK, decode_oversampled_telemetry(&calibration,
+                                                                  DSHOT_RX_CAPTURE_EDGE, buffer,
+                                                                  word_count, &decoded));
+    TEST_ASSERT_EQUAL_HEX32(final_word, decoded);
+}
+
+/* Play a response into the assembled dshot.pio program and decode what it captures */
+static uint32_t decode_emulated_capture(const char *program_name, enum dshot_rx_capture capture,
+                                        uint16_t final_word) {
+    struct pio_emu_program program;
+    struct pio_emu_sm sm;
+    struct pio_emu_line line = {.pin = 6};
+    struct dshot_rx_calibration calibration = {0};
+    uint32_t wait_cycles = (25 * 600 * 125) / 1000;
+    uint32_t tx_words[] = {~(uint32_t)0x1234 << 16, wait_cycles, EDGE_CAPTURE_RUN_LIMIT};
+    uint32_t rx_words[EDGE_CAPTURE_MAX_WORDS + 1];
+    uint32_t decoded = 0;
+
+    TEST_ASSERT_EQUAL_INT(0, pio_emu_assemble_file("src/dshot/dshot.pio", program_name, &program));
+    pio_emu_init(&sm, &program, 6, 125000000u, 125e6F / (600e3F * PIO_CYCLES_PER_TX_BIT));
+    pio_emu_set_input(&sm, pio_emu_line_input, &line);
+
+    /* Response starts 40 cycles into the RX window */
+    uint64_t release = 3 + (16 * PIO_CYCLES_PER_TX_BIT) + wait_cycles +
+                       (capture == DSHOT_RX_CAPTURE_EDGE ? 5 : 3);
+    uint32_t stream21 = (1u << 20) | encode_gcr20_from_final_word(final_word);
+    pio_emu_line_add_nrzi(&line, release + 40, stream21, GCR_FRAME_BITS, 100.0);
+
+    int word_count = pio_emu_run_frame(&sm, tx_words, capture == DSHOT_RX_CAPTURE_EDGE ? 3 : 2,
+                                       rx_words, EDGE_CAPTURE_MAX_WORDS + 1, 20000);
+    reset_rx_calibration(&calibration, capture);
+    if (capture == DSHOT_RX_CAPTURE_OVERSAMPLE) {
+        TEST_ASSERT_EQUAL_INT(OVERSAMPLE_TOTAL_WORDS, word_count);
+        word_count = OVERSAMPLE_WORDS;
+    }
+    TEST_ASSERT_EQUAL_INT(DECODE_OK, decode_oversampled_telemetry(&calibration, capture, rx_words,
+                                                                  word_count, &decoded));
+    return decoded;
+}
+
+static void test_decode_emulated_pio_captures(void) {
+    uint16_t final_word = build_final_word(0x0ABC);
+
+    TEST_ASSERT_EQUAL_HEX32(final_word, decode_emulated_capture("pio_dshot",
+                                                                DSHOT_RX_CAPTURE_OVERSAMPLE,
+                                                                final_word));
+    TEST_ASSERT_EQUAL_HEX32(final_word, decode_emulated_capture("pio_dshot_edge",
+                                                                DSHOT_RX_CAPTURE_EDGE, final_word));
+}
+
+static void test_decode_edge_capture_reports_same_failure_codes(void) {
+    struct dshot_rx_calibration calibration = {0};
+    uint16_t good_word = build_final_word(0x0ABC);
+    uint16_t bad_word = (uint16_t)((good_word & 0xFFF0u) | (((good_word & 0x0Fu) + 1u) & 0x0Fu));
+    uint32_t buffer[EDGE_CAPTURE_MAX_WORDS];
+    uint32_t decoded = 0;
+    int word_count;
+
+    reset_rx_calibration(&calibration, DSHOT_RX_CAPTURE_EDGE);
+    word_count = synthesize_edge_capture(encode_gcr20_from_final_word(bad_word), buffer);
+
+    TEST_ASSERT_EQUAL_INT(DECODE_FAIL_CRC, decode_oversampled_telemetry(&calibration,
+                                                                        DSHOT_RX_CAPTURE_EDGE,
+                                                                        buffer, word_count,
+                                                                        &decoded));
+
+    buffer[0] = EDGE_CAPTURE_END_MARKER;
+    TEST_ASSERT_TRUE(capture_is_silent(DSHOT_RX_CAPTURE_EDGE, buffer));
+    TEST_ASSERT_EQUAL_INT(DECODE_FAIL_EDGE_COUNT,
+                          decode_oversampled_telemetry(&calibration, DSHOT_RX_CAPTURE_EDGE,
+                                                       buffer, 1, &decoded));
+}
+
+struct capture_recorder {
+    int calls;
+    enum dshot_capture_reason reason;
+    enum dshot_rx_capture format;
+    int word_count;
+    uint32_t first_word;
+};
+
+static void record_capture(void *context, int channel, enum dshot_capture_reason reason,
+                           enum dshot_rx_capture format, const uint32_t *words, int word_count) {
+    struct capture_recorder *recorder = context;
+
+    (void)channel;
+    recorder->calls++;
+    recorder->reason = reason;
+    recorder->format = format;
+    recorder->word_count = word_count;
+    recorder->first_word = words[0];
+}
+
+static void test_receive_reports_failed_capture_to_callback(void) {
+    struct dshot_controller controller = {0};
+    struct capture_recorder recorder = {0};
+    uint16_t good_word = build_final_word(0x0ABC);
+    uint16_t bad_word = (uint16_t)((good_word & 0xFFF0u) | (((good_word & 0x0Fu) + 1u) & 0x0Fu));
+    uint32_t buffer[EDGE_CAPTURE_MAX_WORDS];
+    int word_count;
+
+    controller.num_channels = 1;
+    controller.rx_capture = DSHOT_RX_CAPTURE_EDGE;
+    dshot_controller_reset_calibration(&controller);
+    dshot_register_capture_cb(&controller, record_capture, &recorder);
+    word_count = synthesize_edge_capture(encode_gcr20_from_final_word(bad_word), buffer);
+
+    dshot_receive_oversampled(&controller, buffer, word_count);
+
+    TEST_ASSERT_EQUAL_INT(1, recorder.calls);
+    TEST_ASSERT_EQUAL_INT(DSHOT_CAPTURE_REASON_BAD_CRC, recorder.reason);
+    TEST_ASSERT_EQUAL_INT(DSHOT_RX_CAPTURE_EDGE, recorder.format);
+    TEST_ASSERT_EQUAL_INT(word_count, recorder.word_count);
+    TEST_ASSERT_EQUAL_HEX32(buffer[0], recorder.first_word);
+    TEST_ASSERT_EQUAL_UINT32(1, controller.motor[0].stats.rx_bad_crc);
+}
+
 void test_dshot_protocol(void) {
     RUN_TEST(test_dshot_compute_frame_builds_zero_throttle_frame);
     RUN_TEST(test_dshot_compute_frame_builds_throttle_frame);
@@ -185,4 +457,18 @@ void test_dshot_protocol(void) {
     RUN_TEST(test_dshot_get_telemetry_quality_percent_rejects_invalid_channel);
     RUN_TEST(test_build_gcr_word_rejects_invalid_edge_counts);
     RUN_TEST(test_build_gcr_word_builds_expected_word_from_valid_edges);
+    RUN_TEST(test_set_length_transitions_matches_default_thresholds);
+    RUN_TEST(test_bit_period_calibration_is_tracked_per_motor);
+    RUN_TEST(test_bit_period_tracking_follows_drift_after_acquisition);
+    RUN_TEST(test_bit_period_tracking_rejects_outliers);
+    RUN_TEST(test_decode_oversampled_capture_returns_frame);
+    RUN_TEST(test_filter_glitch_runs_merges_short_spikes);
+    RUN_TEST(test_dshot_loop_decodes_queued_response);
+    RUN_TEST(test_dshot_loop_times_out_on_virtual_clock);
+    RUN_TEST(test_dshot_loop_drains_word_left_after_edge_marker);
+    RUN_TEST(test_dshot_quality_window_expires_old_failures);
+    RUN_TEST(test_decode_edge_capture_returns_frame);
+    RUN_TEST(test_decode_edge_capture_reports_same_failure_codes);
+    RUN_TEST(test_decode_emulated_pio_captures);
+    RUN_TEST(test_receive_reports_failed_capture_to_callback);
 }
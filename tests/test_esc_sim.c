@@ -0,0 +1,143 @@
+#include "dshot/control.h"
+#include "dshot/dshot.h"
+#include "mocks/mock_sdk.h"
+#include "motors.h"
+#include "sim/esc_sim.h"
+#include "unity/unity.h"
+
+#define SIM_DSHOT_SPEED 600
+#define SIM_LOOP_PERIOD_US 1000
+
+static struct esc_sim_bank bank;
+static struct dshot_controller controller0;
+static struct dshot_controller controller1;
+
+static void start_bank(const struct esc_sim_config *config, enum dshot_rx_capture capture) {
+    esc_sim_init(&bank, config, SIM_DSHOT_SPEED, capture);
+    esc_sim_add_escs(&bank, MOTOR0_PIN_BASE, NUM_MOTORS_0);
+    esc_sim_add_escs(&bank, MOTOR1_PIN_BASE, NUM_MOTORS_1);
+
+    dshot_controller_init(&controller0, SIM_DSHOT_SPEED, pio0, 0, MOTOR0_PIN_BASE, NUM_MOTORS_0,
+                          capture);
+    dshot_controller_init(&controller1, SIM_DSHOT_SPEED, pio0, 1, MOTOR1_PIN_BASE, NUM_MOTORS_1,
+                          capture);
+    controller0.edt_always_decode = true;
+    controller1.edt_always_decode = true;
+}
+
+static void run_loops(int loops) {
+    for (int i = 0; i < loops; ++i) {
+        dshot_mark_activity(&controller0);
+        dshot_mark_activity(&controller1);
+        dshot_loop(&controller0);
+        dshot_loop(&controller1);
+        mock_time_advance_us(SIM_LOOP_PERIOD_US);
+    }
+}
+
+static void test_esc_sim_reports_erpm_after_spin_up(void) {
+    struct esc_sim_config config;
+
+    esc_sim_default_config(&config);
+    start_bank(&config, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    dshot_throttle(&controller0, 0, 1047);
+    run_loops(400);
+
+    const struct dshot_motor *motor = &controller0.motor[0];
+    TEST_ASSERT_EQUAL_UINT32(0, motor->stats.rx_timeout + motor->stats.rx_bad_gcr +
+                                    motor->stats.rx_bad_crc);
+    TEST_ASSERT_UINT32_WITHIN(5, 500, esc_sim_erpm(&bank, MOTOR0_PIN_BASE));
+    TEST_ASSERT_UINT32_WITHIN(5, esc_sim_erpm(&bank, MOTOR0_PIN_BASE),
+                              motor->telemetry_data[DSHOT_TELEMETRY_TYPE_ERPM]);
+    TEST_ASSERT_EQUAL_UINT32(0, esc_sim_erpm(&bank, MOTOR0_PIN_BASE + 1));
+}
+
+static void test_esc_sim_applies_3d_mode_on_save(void) {
+    struct esc_sim_config config;
+
+    esc_sim_default_config(&config);
+    start_bank(&config, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    dshot_send_command_to_all(&controller0, &controller1, DSHOT_CMD_3D_MODE_ON, 10);
+
+    const struct esc_sim_esc *esc = esc_sim_get(&bank, MOTOR1_PIN_BASE + 3);
+    TEST_ASSERT_TRUE(esc->mode_3d_pending);
+    TEST_ASSERT_FALSE(esc->mode_3d);
+
+    dshot_send_command_to_all(&controller0, &controller1, DSHOT_CMD_SAVE_SETTINGS, 10);
+    TEST_ASSERT_TRUE(esc->mode_3d);
+    TEST_ASSERT_EQUAL_UINT32(1, esc->stats.settings_saved);
+    TEST_ASSERT_EQUAL_UINT32(2, esc->stats.commands_applied);
+}
+
+static void test_esc_sim_edt_enable_activates_telemetry(void) {
+    struct esc_sim_config config;
+
+    esc_sim_default_config(&config);
+    start_bank(&config, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    dshot_send_command_to_all(&controller0, &controller1, DSHOT_EXTENDED_TELEMETRY_ENABLE, 10);
+    dshot_wait_for_telemetry(&controller0, &controller1);
+
+    TEST_ASSERT_TRUE(dshot_is_telemetry_active(&controller0));
+    TEST_ASSERT_TRUE(dshot_is_telemetry_active(&controller1));
+    const struct dshot_motor *motor = &controller1.motor[2];
+    TEST_ASSERT_EQUAL_UINT32(ESC_SIM_EDT_VERSION,
+                             motor->telemetry_data[DSHOT_TELEMETRY_TYPE_STATE_EVENTS]);
+
+    run_loops(8 * 3 * NUM_MOTORS_0);
+    TEST_ASSERT_EQUAL_UINT32(config.temperature_c,
+                             controller0.motor[1].telemetry_data[DSHOT_TELEMETRY_TYPE_TEMPERATURE]);
+    TEST_ASSERT_EQUAL_UINT32(config.voltage_mv / 250,
+                             controller0.motor[1].telemetry_data[DSHOT_TELEMETRY_TYPE_VOLTAGE]);
+}
+
+static void test_esc_sim_decodes_edge_captures(void) {
+    struct esc_sim_config config;
+
+    esc_sim_default_config(&config);
+    config.clock_skew_pct = 3.0;
+    start_bank(&config, DSHOT_RX_CAPTURE_EDGE);
+    dshot_throttle(&controller1, 3, 1500);
+    run_loops(200);
+
+    const struct dshot_motor *motor = &controller1.motor[3];
+    TEST_ASSERT_EQUAL_UINT32(motor->stats.tx_frames, motor->stats.rx_frames);
+    TEST_ASSERT_UINT32_WITHIN(5, esc_sim_erpm(&bank, MOTOR1_PIN_BASE + 3),
+                              motor->telemetry_data[DSHOT_TELEMETRY_TYPE_ERPM]);
+}
+
+static void test_esc_sim_responses_outside_rx_window_time_out(void) {
+    struct esc_sim_config config;
+
+    esc_sim_default_config(&config);
+    config.latency_us = 40;
+    start_bank(&config, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    run_loops(20);
+
+    const struct dshot_motor *motor = &controller0.motor[0];
+    TEST_ASSERT_EQUAL_UINT32(0, motor->stats.rx_frames);
+    TEST_ASSERT_EQUAL_UINT32(motor->stats.tx_frames, motor->stats.rx_timeout);
+    TEST_ASSERT_EQUAL_UINT32(esc_sim_get(&bank, MOTOR0_PIN_BASE)->stats.responses,
+                             esc_sim_get(&bank, MOTOR0_PIN_BASE)->stats.missed);
+}
+
+static void test_esc_sim_noise_degrades_quality(void) {
+    struct esc_sim_config config;
+
+    esc_sim_default_config(&config);
+    config.drop_pct = 50.0;
+    start_bank(&config, DSHOT_RX_CAPTURE_OVERSAMPLE);
+    dshot_throttle(&controller0, 2, 1200);
+    run_loops(400);
+
+    int16_t quality = dshot_get_telemetry_quality_percent(&controller0, 2);
+    TEST_ASSERT_INT16_WITHIN(1500, 5000, quality);
+}
+
+void test_esc_sim(void) {
+    RUN_TEST(test_esc_sim_reports_erpm_after_spin_up);
+    RUN_TEST(test_esc_sim_applies_3d_mode_on_save);
+    RUN_TEST(test_esc_sim_edt_enable_activates_telemetry);
+    RUN_TEST(test_esc_sim_decodes_edge_captures);
+    RUN_TEST(test_esc_sim_responses_outside_rx_window_time_out);
+    RUN_TEST(test_esc_sim_noise_degrades_quality);
+}
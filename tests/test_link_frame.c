@@ -0,0 +1,69 @@
+#include "link/frame.h"
+#include "unity/unity.h"
+#include <string.h>
+
+static void test_link_crc16_matches_ccitt_false_check_value(void) {
+    const uint8_t data[] = "123456789";
+
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, link_crc16(data, 9, 0xFFFF));
+}
+
+static void test_link_cobs_round_trips_zeros_and_long_runs(void) {
+    uint8_t data[300];
+    uint8_t encoded[310];
+    uint8_t decoded[300];
+    size_t decoded_len = 0;
+
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (i % 100 == 0) ? 0x00 : 0xFF;
+    }
+    size_t encoded_len = link_cobs_encode(data, sizeof(data), encoded);
+
+    TEST_ASSERT_NULL(memchr(encoded, LINK_FRAME_DELIMITER, encoded_len));
+    TEST_ASSERT_TRUE(link_cobs_decode(encoded, encoded_len, decoded, &decoded_len));
+    TEST_ASSERT_EQUAL_size_t(sizeof(data), decoded_len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data, decoded, sizeof(data));
+}
+
+static void test_link_frame_round_trips_packet_and_sequence(void) {
+    const uint8_t packet[] = {0x5A, 0x00, 0x00, 0xDC, 0x05};
+    uint8_t frame[LINK_FRAME_MAX_SIZE(sizeof(packet))];
+    uint8_t decoded[sizeof(frame)];
+    size_t decoded_len = 0;
+    uint8_t seq = 0;
+
+    size_t frame_len = link_frame_encode(200, packet, sizeof(packet), frame);
+
+    TEST_ASSERT_LESS_OR_EQUAL_size_t(sizeof(frame), frame_len);
+    TEST_ASSERT_EQUAL_HEX8(LINK_FRAME_DELIMITER, frame[frame_len - 1]);
+    TEST_ASSERT_NULL(memchr(frame, LINK_FRAME_DELIMITER, frame_len - 1));
+    TEST_ASSERT_TRUE(link_frame_decode(frame, frame_len - 1, &seq, decoded, &decoded_len));
+    TEST_ASSERT_EQUAL_UINT8(200, seq);
+    TEST_ASSERT_EQUAL_size_t(sizeof(packet), decoded_len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(packet, decoded, sizeof(packet));
+}
+
+static void test_link_frame_decode_rejects_any_flipped_bit(void) {
+    const uint8_t packet[] = {0xC5, 0x01, 0x58, 0x02};
+    uint8_t frame[LINK_FRAME_MAX_SIZE(sizeof(packet))];
+    uint8_t decoded[sizeof(frame)];
+    size_t decoded_len = 0;
+    uint8_t seq = 0;
+    uint32_t accepted = 0;
+
+    size_t frame_len = link_frame_encode(7, packet, sizeof(packet), frame);
+    for (size_t bit = 0; bit < (frame_len - 1) * 8; ++bit) {
+        frame[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+        accepted += link_frame_decode(frame, frame_len - 1, &seq, decoded, &decoded_len);
+        frame[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, accepted);
+}
+
+void test_link_frame(void) {
+    RUN_TEST(test_link_crc16_matches_ccitt_false_check_value);
+    RUN_TEST(test_link_cobs_round_trips_zeros_and_long_runs);
+    RUN_TEST(test_link_frame_round_trips_packet_and_sequence);
+    RUN_TEST(test_link_frame_decode_rejects_any_flipped_bit);
+}
@@ -0,0 +1,112 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "link/pipe.h"
+#include "link/transport.h"
+#include "link/tx.h"
+#include "mocks/mock_sdk.h"
+#include "support/link_capture.h"
+#include "support/runtime_config_host.h"
+#include "support/usb_comm_host.h"
+#include "unity/unity.h"
+#include <unistd.h>
+
+static void test_link_transport_defaults_to_stdio(void) {
+    const uint8_t input[] = {0x11, 0x22};
+    uint8_t buf[4];
+
+    TEST_ASSERT_EQUAL_PTR(&link_transport_stdio, link_transport());
+    mock_stdin_push(input, sizeof(input));
+    TEST_ASSERT_EQUAL_size_t(2, link_read(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(input, buf, sizeof(input));
+    TEST_ASSERT_EQUAL_size_t(0, link_read(buf, sizeof(buf)));
+}
+
+static void test_usb_poll_multi_reads_selected_transport(void) {
+    uint8_t packet[USB_CONFIG_PACKET_SIZE] = {USB_CONFIG_START_BYTE, THRUSTER_PROTOCOL_DSHOT,
+                                              0x58, 0x02};
+    uint8_t command_buf[USB_INPUT_PACKET_SIZE(2)];
+    uint8_t config_buf[USB_CONFIG_PACKET_SIZE];
+
+    packet[USB_CONFIG_PACKET_SIZE - 1] = usb_calculate_checksum(packet, USB_CONFIG_PACKET_SIZE - 1);
+    usb_comm_reset();
+    link_capture_select(packet, sizeof(packet), LINK_CAPTURE_SIZE);
+
+    usb_packet_kind_t kind = usb_poll_multi(command_buf, sizeof(command_buf), config_buf,
+                                            sizeof(config_buf));
+    link_transport_select(&link_transport_stdio);
+
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_CONFIG, kind);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(packet, config_buf, sizeof(packet));
+}
+
+static void test_output_packets_leave_through_transport_in_one_flush(void) {
+    mcu_runtime_config_t config = {.protocol = THRUSTER_PROTOCOL_DSHOT, .dshot_speed = 600};
+
+    usb_comm_reset();
+    link_tx_reset();
+    link_capture_select(NULL, 0, LINK_CAPTURE_SIZE);
+    mcu_runtime_config_send_version(&config);
+    usb_link_stats_send();
+    size_t before_flush = link_capture_output_len;
+    link_tx_flush();
+    link_transport_select(&link_transport_stdio);
+
+    TEST_ASSERT_EQUAL_size_t(0, before_flush);
+    TEST_ASSERT_EQUAL_size_t(USB_VERSION_PACKET_SIZE + USB_LINK_STATS_PACKET_SIZE,
+                             link_capture_output_len);
+    TEST_ASSERT_EQUAL_HEX8(USB_VERSION_START_BYTE, link_capture_output[0]);
+    TEST_ASSERT_EQUAL_HEX8(USB_LINK_STATS_START_BYTE,
+                           link_capture_output[USB_VERSION_PACKET_SIZE]);
+    TEST_ASSERT_EQUAL_UINT32(1, link_capture_flushes);
+}
+
+static void test_link_tx_stats_count_bytes_and_flushes(void) {
+    const uint8_t data[] = {0x01, 0x02, 0x03};
+
+    link_tx_stats_reset();
+    link_capture_select(NULL, 0, LINK_CAPTURE_SIZE);
+    link_write(data, sizeof(data));
+    link_write(data, sizeof(data));
+    link_flush();
+    link_transport_select(&link_transport_stdio);
+
+    TEST_ASSERT_EQUAL_UINT32(6, link_tx_stats()->bytes_written);
+    TEST_ASSERT_EQUAL_UINT32(1, link_tx_stats()->flushes);
+    TEST_ASSERT_EQUAL_UINT32(1, link_capture_flushes);
+}
+
+static void test_link_pipe_reads_without_blocking_and_writes_through(void) {
+    const uint8_t input[] = {USB_INPUT_START_BYTE, 0x01, 0x02};
+    uint8_t buf[8];
+    int in_fds[2];
+    int out_fds[2];
+
+    TEST_ASSERT_EQUAL_INT(0, pipe(in_fds));
+    TEST_ASSERT_EQUAL_INT(0, pipe(out_fds));
+    link_pipe_open(in_fds[0], out_fds[1]);
+    link_transport_select(&link_transport_pipe);
+
+    TEST_ASSERT_EQUAL_size_t(0, link_read(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_INT((int)sizeof(input), (int)write(in_fds[1], input, sizeof(input)));
+    TEST_ASSERT_EQUAL_size_t(sizeof(input), link_read(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(input, buf, sizeof(input));
+
+    TEST_ASSERT_TRUE(link_writable() > 0);
+    TEST_ASSERT_EQUAL_size_t(sizeof(input), link_write(input, sizeof(input)));
+    link_transport_select(&link_transport_stdio);
+    TEST_ASSERT_EQUAL_INT((int)sizeof(input), (int)read(out_fds[0], buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(input, buf, sizeof(input));
+
+    close(in_fds[0]);
+    close(in_fds[1]);
+    close(out_fds[0]);
+    close(out_fds[1]);
+}
+
+void test_link_transport(void) {
+    RUN_TEST(test_link_transport_defaults_to_stdio);
+    RUN_TEST(test_usb_poll_multi_reads_selected_transport);
+    RUN_TEST(test_output_packets_leave_through_transport_in_one_flush);
+    RUN_TEST(test_link_tx_stats_count_bytes_and_flushes);
+    RUN_TEST(test_link_pipe_reads_without_blocking_and_writes_through);
+}
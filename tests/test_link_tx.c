@@ -0,0 +1,413 @@
+#include "clock_sync.h"
+#include "dshot/telemetry_usb.h"
+#include "link/tx.h"
+#include "mocks/mock_sdk.h"
+#include "support/link_capture.h"
+#include "support/usb_comm_host.h"
+#include "unity/unity.h"
+
+#define BATCH_SIZE(entries) (2 + ((entries) * TELEMETRY_BATCH_ENTRY_SIZE) + 1)
+
+static void start_link(size_t room, link_tx_policy_t policy) {
+    link_tx_reset();
+    link_tx_set_policy(policy);
+    dshot_telemetry_usb_reset();
+    link_capture_select(NULL, 0, room);
+}
+
+static void stop_link(void) {
+    dshot_telemetry_usb_reset();
+    clock_sync_reset();
+    link_tx_set_policy(LINK_TX_POLICY_DROP_OLDEST);
+    link_tx_set_protocol(LINK_PROTOCOL_V1);
+    link_tx_init();
+    link_transport_select(&link_transport_stdio);
+}
+
+static void test_link_tx_send_queues_packet_until_flush(void) {
+    const uint8_t packet[8] = {0xD5, 1, 2, 3, 4, 5, 6, 7};
+
+    start_link(LINK_CAPTURE_SIZE, LINK_TX_POLICY_DROP_OLDEST);
+    bool queued = link_tx_send(LINK_STREAM_CONTROL, packet, sizeof(packet));
+    size_t before_flush = link_capture_output_len;
+    link_tx_flush();
+    stop_link();
+
+    TEST_ASSERT_TRUE(queued);
+    TEST_ASSERT_EQUAL_size_t(0, before_flush);
+    TEST_ASSERT_EQUAL_size_t(sizeof(packet), link_capture_output_len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(packet, link_capture_output, sizeof(packet));
+    TEST_ASSERT_EQUAL_UINT32(1, link_capture_flushes);
+}
+
+static void test_link_tx_send_drops_packet_when_queue_is_full(void) {
+    const uint8_t packet[16] = {0xB5};
+    uint32_t queued = 0;
+
+    start_link(0, LINK_TX_POLICY_DROP_OLDEST);
+    while (link_tx_send(LINK_STREAM_LOG, packet, sizeof(packet))) {
+        queued++;
+    }
+    uint32_t dropped = link_tx_dropped(LINK_STREAM_LOG);
+    stop_link();
+
+    TEST_ASSERT_EQUAL_UINT32(LINK_TX_QUEUE_SIZE / sizeof(packet), queued);
+    TEST_ASSERT_EQUAL_UINT32(1, dropped);
+}
+
+static void test_link_tx_flush_keeps_packets_that_do_not_fit(void) {
+    const uint8_t packet[8] = {0xD5};
+
+    start_link(12, LINK_TX_POLICY_DROP_OLDEST);
+    link_tx_send(LINK_STREAM_CONTROL, packet, sizeof(packet));
+    link_tx_send(LINK_STREAM_CONTROL, packet, sizeof(packet));
+    link_tx_flush();
+    size_t first_len = link_capture_output_len;
+
+    link_capture_limit = LINK_CAPTURE_SIZE;
+    link_tx_flush();
+    size_t total_len = link_capture_output_len;
+    uint32_t dropped = link_tx_dropped(LINK_STREAM_CONTROL);
+    stop_link();
+
+    TEST_ASSERT_EQUAL_size_t(sizeof(packet), first_len);
+    TEST_ASSERT_EQUAL_size_t(2 * sizeof(packet), total_len);
+    TEST_ASSERT_EQUAL_UINT32(0, dropped);
+}
+
+static void test_link_tx_flush_packs_streams_in_priority_order(void) {
+    const uint8_t capture[3] = {0xA7, 0xA7, 0xA7};
+    const uint8_t telemetry[2] = {0xA6, 0xA6};
+    const uint8_t log[2] = {0xB5, 0xB5};
+    const uint8_t control[1] = {0xD5};
+    const uint8_t expected[] = {0xD5, 0xB5, 0xB5, 0xA6, 0xA6, 0xA7, 0xA7, 0xA7};
+
+    start_link(LINK_CAPTURE_SIZE, LINK_TX_POLICY_DROP_OLDEST);
+    link_tx_send(LINK_STREAM_CAPTURE, capture, sizeof(capture));
+    link_tx_send(LINK_STREAM_TELEMETRY, telemetry, sizeof(telemetry));
+    link_tx_send(LINK_STREAM_LOG, log, sizeof(log));
+    link_tx_send(LINK_STREAM_CONTROL, control, sizeof(control));
+    link_tx_flush();
+    stop_link();
+
+    TEST_ASSERT_EQUAL_size_t(sizeof(expected), link_capture_output_len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, link_capture_output, sizeof(expected));
+    TEST_ASSERT_EQUAL_UINT32(1, link_capture_flushes);
+}
+
+static void test_link_tx_set_priority_reorders_streams(void) {
+    const uint8_t capture[1] = {0xA7};
+    const uint8_t control[1] = {0xD5};
+
+    start_link(LINK_CAPTURE_SIZE, LINK_TX_POLICY_DROP_OLDEST);
+    link_tx_set_priority(LINK_STREAM_CONTROL, 9);
+    link_tx_send(LINK_STREAM_CONTROL, control, sizeof(control));
+    link_tx_send(LINK_STREAM_CAPTURE, capture, sizeof(capture));
+    link_tx_flush();
+    stop_link();
+
+    TEST_ASSERT_EQUAL_size_t(2, link_capture_output_len);
+    TEST_ASSERT_EQUAL_HEX8(0xA7, link_capture_output[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xD5, link_capture_output[1]);
+}
+
+static void test_link_tx_prioritize_reserves_room_for_control(void) {
+    const uint8_t telemetry[20] = {0xA6};
+    const uint8_t control[8] = {0xD5};
+
+    start_link(LINK_TX_PRIORITY_RESERVE + 10, LINK_TX_POLICY_PRIORITIZE);
+    link_tx_send(LINK_STREAM_TELEMETRY, telemetry, sizeof(telemetry));
+    link_tx_send(LINK_STREAM_CONTROL, control, sizeof(control));
+    link_tx_flush();
+    size_t prioritized = link_capture_output_len;
+    stop_link();
+
+    start_link(LINK_TX_PRIORITY_RESERVE + 10, LINK_TX_POLICY_DROP_OLDEST);
+    link_tx_send(LINK_STREAM_TELEMETRY, telemetry, sizeof(telemetry));
+    link_tx_send(LINK_STREAM_CONTROL, control, sizeof(control));
+    link_tx_flush();
+    size_t unreserved = link_capture_output_len;
+    stop_link();
+
+    TEST_ASSERT_EQUAL_size_t(sizeof(control), prioritized);
+    TEST_ASSERT_EQUAL_size_t(sizeof(control) + sizeof(telemetry), unreserved);
+}
+
+static void test_link_tx_budget_limits_bytes_per_interval(void) {
+    const uint8_t packet[200] = {0xB5};
+
+    start_link(LINK_CAPTURE_SIZE, LINK_TX_POLICY_DROP_OLDEST);
+    link_tx_set_budget(300, 1000);
+    link_tx_send(LINK_STREAM_LOG, packet, sizeof(packet));
+    link_tx_send(LINK_STREAM_LOG, packet, sizeof(packet));
+    link_tx_flush();
+    size_t first_interval = link_capture_output_len;
+
+    mock_time_advance_us(999);
+    link_tx_flush();
+    size_t same_interval = link_capture_output_len;
+
+    mock_time_advance_us(1);
+    link_tx_flush();
+    size_t next_interval = link_capture_output_len;
+    stop_link();
+
+    TEST_ASSERT_EQUAL_size_t(sizeof(packet), first_interval);
+    TEST_ASSERT_EQUAL_size_t(sizeof(packet), same_interval);
+    TEST_ASSERT_EQUAL_size_t(2 * sizeof(packet), next_interval);
+}
+
+static void test_link_tx_budget_below_largest_packet_still_sends_it(void) {
+    const uint8_t packet[200] = {0xE5};
+
+    start_link(LINK_CAPTURE_SIZE, LINK_TX_POLICY_DROP_OLDEST);
+    link_tx_set_budget(64, 1000);
+    link_tx_send(LINK_STREAM_CONTROL, packet, sizeof(packet));
+    link_tx_flush();
+    size_t written = link_capture_output_len;
+    stop_link();
+
+    TEST_ASSERT_EQUAL_size_t(sizeof(packet), written);
+}
+
+/* A pty that reports room but takes at most short_write_size bytes per write */
+static size_t short_write_size;
+
+static size_t short_write_writable(void) {
+    return LINK_CAPTURE_SIZE;
+}
+
+static size_t short_write(const uint8_t *data, size_t len) {
+    return link_capture_write(data, len < short_write_size ? len : short_write_size);
+}
+
+static const link_transport_t short_write_transport = {
+    .name = "short",
+    .init = NULL,
+    .read = link_capture_read,
+    .write = short_write,
+    .writable = short_write_writable,
+    .flush = link_capture_flush,
+};
+
+static void test_link_tx_flush_resends_tail_of_short_write(void) {
+    uint8_t packets[3][20];
+    size_t written[3];
+
+    start_link(LINK_CAPTURE_SIZE, LINK_TX_POLICY_DROP_OLDEST);
+    link_transport_select(&short_write_transport);
+    short_write_size = 25;
+    for (int i = 0; i < 3; ++i) {
+        memset(packets[i], 0xD0 + i, sizeof(packets[i]));
+        link_tx_send(LINK_STREAM_CONTROL, packets[i], sizeof(packets[i]));
+    }
+    for (int i = 0; i < 3; ++i) {
+        link_tx_flush();
+        written[i] = link_capture_output_len;
+    }
+    link_tx_send(LINK_STREAM_LOG, packets[0], sizeof(packets[0]));
+    link_tx_flush();
+    size_t total = link_capture_output_len;
+    uint32_t dropped = link_tx_dropped(LINK_STREAM_CONTROL);
+    stop_link();
+
+    TEST_ASSERT_EQUAL_size_t(25, written[0]);
+    TEST_ASSERT_EQUAL_size_t(50, written[1]);
+    TEST_ASSERT_EQUAL_size_t(60, written[2]);
+    TEST_ASSERT_EQUAL_size_t(80, total);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(packets, link_capture_output, sizeof(packets));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(packets[0], &link_capture_output[60], sizeof(packets[0]));
+    TEST_ASSERT_EQUAL_UINT32(0, dropped);
+}
+
+static void test_link_tx_reset_counts_unwritten_tail_as_dropped(void) {
+    const uint8_t packet[40] = {0xD5};
+
+    start_link(LINK_CAPTURE_SIZE, LINK_TX_POLICY_DROP_OLDEST);
+    link_transport_select(&short_write_transport);
+    short_write_size = 15;
+    link_tx_stats_reset();
+    link_tx_send(LINK_STREAM_CONTROL, packet, sizeof(packet));
+    link_tx_flush();
+    link_tx_reset();
+    uint32_t bytes_dropped = link_tx_stats()->bytes_dropped;
+    link_tx_flush();
+    size_t written = link_capture_output_len;
+    stop_link();
+
+    TEST_ASSERT_EQUAL_UINT32(sizeof(packet) - 15, bytes_dropped);
+    TEST_ASSERT_EQUAL_size_t(15, written);
+}
+
+static void test_link_tx_v2_frames_packets_in_wire_order_after_a_delimiter(void) {
+    const uint8_t control[8] = {0xD5, 1, 0, 0, 1, 0x58, 0x02, 0x8B};
+    const uint8_t log[5] = {0xB5, 0, 1, 'x', 0xCC};
+    uint8_t packet[sizeof(control)];
+    size_t packet_len = 0;
+    uint8_t seq = 0xFF;
+
+    start_link(LINK_CAPTURE_SIZE, LINK_TX_POLICY_DROP_OLDEST);
+    link_tx_set_protocol(LINK_PROTOCOL_V2);
+    link_tx_send(LINK_STREAM_LOG, log, sizeof(log));
+    link_tx_send(LINK_STREAM_CONTROL, control, sizeof(control));
+    link_tx_flush();
+    size_t len = link_capture_output_len;
+    stop_link();
+
+    TEST_ASSERT_EQUAL_size_t(1 + LINK_FRAME_MAX_SIZE(7) + LINK_FRAME_MAX_SIZE(4), len);
+    TEST_ASSERT_EQUAL_HEX8(LINK_FRAME_DELIMITER, link_capture_output[0]);
+    size_t frame_len = LINK_FRAME_MAX_SIZE(7) - 1;
+    TEST_ASSERT_EQUAL_HEX8(LINK_FRAME_DELIMITER, link_capture_output[1 + frame_len]);
+    TEST_ASSERT_TRUE(link_frame_decode(&link_capture_output[1], frame_len, &seq, packet,
+                                       &packet_len));
+    TEST_ASSERT_EQUAL_UINT8(0, seq);
+    TEST_ASSERT_EQUAL_size_t(sizeof(control) - 1, packet_len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(control, packet, packet_len);
+    TEST_ASSERT_TRUE(link_frame_decode(&link_capture_output[2 + frame_len],
+                                       LINK_FRAME_MAX_SIZE(4) - 1, &seq, packet, &packet_len));
+    TEST_ASSERT_EQUAL_UINT8(1, seq);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(log, packet, sizeof(log) - 1);
+}
+
+static void test_telemetry_batch_waits_whole_until_link_has_room(void) {
+    start_link(BATCH_SIZE(2), LINK_TX_POLICY_DROP_OLDEST);
+    for (int i = 0; i < 3; ++i) {
+        dshot_telemetry_usb_send((uint8_t)i, TELEMETRY_TYPE_ERPM, 1000 + i);
+    }
+    dshot_telemetry_usb_flush();
+    link_tx_flush();
+    size_t first_len = link_capture_output_len;
+
+    link_capture_limit += BATCH_SIZE(1);
+    dshot_telemetry_usb_flush();
+    link_tx_flush();
+    size_t total_len = link_capture_output_len;
+    uint8_t count = link_capture_output[1];
+    stop_link();
+
+    TEST_ASSERT_EQUAL_size_t(0, first_len);
+    TEST_ASSERT_EQUAL_size_t(BATCH_SIZE(3), total_len);
+    TEST_ASSERT_EQUAL_UINT8(3, count);
+    TEST_ASSERT_EQUAL_UINT32(0, link_tx_dropped(LINK_STREAM_TELEMETRY));
+}
+
+static void test_telemetry_stays_queued_while_output_queue_is_full(void) {
+    const uint8_t filler[LINK_TX_PACKET_MAX_SIZE] = {0xA6};
+
+    start_link(0, LINK_TX_POLICY_DROP_OLDEST);
+    while (link_tx_room(LINK_STREAM_TELEMETRY) > 0) {
+        link_tx_send(LINK_STREAM_TELEMETRY, filler, link_tx_room(LINK_STREAM_TELEMETRY));
+    }
+    dshot_telemetry_usb_send(5, TELEMETRY_TYPE_ERPM, 1234);
+    dshot_telemetry_usb_flush();
+    uint32_t dropped = link_tx_dropped(LINK_STREAM_TELEMETRY);
+
+    link_tx_reset();
+    link_capture_limit = LINK_CAPTURE_SIZE;
+    dshot_telemetry_usb_flush();
+    link_tx_flush();
+    stop_link();
+
+    TEST_ASSERT_EQUAL_UINT32(0, dropped);
+    TEST_ASSERT_EQUAL_size_t(BATCH_SIZE(1), link_capture_output_len);
+    TEST_ASSERT_EQUAL_UINT8(5, link_capture_output[2]);
+}
+
+static void test_telemetry_drop_oldest_counts_queue_overflow(void) {
+    start_link(0, LINK_TX_POLICY_DROP_OLDEST);
+    for (int i = 0; i < 300; ++i) {
+        dshot_telemetry_usb_send(0, TELEMETRY_TYPE_ERPM, i);
+    }
+    dshot_telemetry_usb_flush();
+    link_tx_flush();
+    size_t written = link_capture_output_len;
+    uint32_t dropped = link_tx_dropped(LINK_STREAM_TELEMETRY);
+    stop_link();
+
+    TEST_ASSERT_EQUAL_size_t(0, written);
+    /* The queue keeps one slot free to tell full from empty */
+    TEST_ASSERT_EQUAL_UINT32(300 - 255, dropped);
+}
+
+static void test_telemetry_coalesce_keeps_latest_value_per_motor_and_type(void) {
+    int32_t value = 0;
+
+    start_link(0, LINK_TX_POLICY_COALESCE);
+    for (int i = 0; i < 300; ++i) {
+        dshot_telemetry_usb_send(3, TELEMETRY_TYPE_ERPM, i);
+        dshot_telemetry_usb_send(3, TELEMETRY_TYPE_VOLTAGE, -i);
+    }
+    link_capture_limit = LINK_CAPTURE_SIZE;
+    dshot_telemetry_usb_flush();
+    link_tx_flush();
+    size_t written = link_capture_output_len;
+    uint8_t count = link_capture_output[1];
+    memcpy(&value, &link_capture_output[2 + 2], sizeof(value));
+    uint32_t dropped = link_tx_dropped(LINK_STREAM_TELEMETRY);
+    stop_link();
+
+    TEST_ASSERT_EQUAL_size_t(BATCH_SIZE(2), written);
+    TEST_ASSERT_EQUAL_UINT8(2, count);
+    TEST_ASSERT_EQUAL_INT32(299, value);
+    TEST_ASSERT_EQUAL_UINT32(2 * 299, dropped);
+}
+
+static void test_telemetry_batch_carries_host_time_once_synced(void) {
+    uint8_t ping[CLOCK_SYNC_PING_PACKET_SIZE] = {CLOCK_SYNC_PING_START_BYTE, 0};
+    /* Host time sent and previous round trip; the second ping's round trip times the first */
+    const uint32_t ping_values[2][2] = {{900000, 0}, {920000, 200}};
+    uint32_t host_time_us;
+    uint16_t after_us;
+
+    clock_sync_reset();
+    for (uint8_t i = 0; i < 2; ++i) {
+        ping[1] = i;
+        memcpy(&ping[2], ping_values[i], sizeof(ping_values[i]));
+        ping[CLOCK_SYNC_PING_PACKET_SIZE - 1] = usb_calculate_checksum(ping, sizeof(ping) - 1);
+        TEST_ASSERT_TRUE(clock_sync_handle_ping(ping, 100000 + (i * 20000)));
+    }
+
+    start_link(LINK_CAPTURE_SIZE, LINK_TX_POLICY_DROP_OLDEST);
+    /* Values sent before the first flush after the ping are stamped at the flush */
+    dshot_telemetry_usb_send(0, TELEMETRY_TYPE_ERPM, 0);
+    dshot_telemetry_usb_flush();
+    link_tx_reset();
+    mock_time_set_us(150000);
+    dshot_telemetry_usb_send(1, TELEMETRY_TYPE_ERPM, 1000);
+    mock_time_set_us(150300);
+    dshot_telemetry_usb_send(2, TELEMETRY_TYPE_ERPM, 2000);
+    dshot_telemetry_usb_flush();
+    link_tx_flush();
+    size_t written = link_capture_output_len;
+    memcpy(&host_time_us, &link_capture_output[2], sizeof(host_time_us));
+    memcpy(&after_us, &link_capture_output[TELEMETRY_TIMED_BATCH_HEADER_SIZE +
+                                           TELEMETRY_TIMED_BATCH_ENTRY_SIZE + 6],
+           sizeof(after_us));
+    uint8_t start_byte = link_capture_output[0];
+    stop_link();
+
+    TEST_ASSERT_EQUAL_HEX8(TELEMETRY_TIMED_BATCH_START_BYTE, start_byte);
+    TEST_ASSERT_EQUAL_size_t(
+        TELEMETRY_TIMED_BATCH_HEADER_SIZE + (2 * TELEMETRY_TIMED_BATCH_ENTRY_SIZE) + 1, written);
+    TEST_ASSERT_EQUAL_UINT32(900000 + 100 + 50000, host_time_us);
+    TEST_ASSERT_EQUAL_UINT16(300, after_us);
+}
+
+void test_link_tx(void) {
+    RUN_TEST(test_link_tx_send_queues_packet_until_flush);
+    RUN_TEST(test_link_tx_send_drops_packet_when_queue_is_full);
+    RUN_TEST(test_link_tx_flush_keeps_packets_that_do_not_fit);
+    RUN_TEST(test_link_tx_flush_packs_streams_in_priority_order);
+    RUN_TEST(test_link_tx_set_priority_reorders_streams);
+    RUN_TEST(test_link_tx_prioritize_reserves_room_for_control);
+    RUN_TEST(test_link_tx_budget_limits_bytes_per_interval);
+    RUN_TEST(test_link_tx_budget_below_largest_packet_still_sends_it);
+    RUN_TEST(test_link_tx_flush_resends_tail_of_short_write);
+    RUN_TEST(test_link_tx_reset_counts_unwritten_tail_as_dropped);
+    RUN_TEST(test_link_tx_v2_frames_packets_in_wire_order_after_a_delimiter);
+    RUN_TEST(test_telemetry_batch_waits_whole_until_link_has_room);
+    RUN_TEST(test_telemetry_stays_queued_while_output_queue_is_full);
+    RUN_TEST(test_telemetry_drop_oldest_counts_queue_overflow);
+    RUN_TEST(test_telemetry_coalesce_keeps_latest_value_per_motor_and_type);
+    RUN_TEST(test_telemetry_batch_carries_host_time_once_synced);
+}
@@ -1,21 +1,40 @@
+#include "mocks/mock_sdk.h"
 #include "unity/unity.h"
 
 extern void test_usb_comm(void);
+extern void test_link_frame(void);
+extern void test_link_transport(void);
+extern void test_link_tx(void);
 extern void test_runtime_config(void);
+extern void test_trajectory(void);
+extern void test_clock_sync(void);
 extern void test_dshot_control(void);
+extern void test_capture_usb(void);
 extern void test_dshot_protocol(void);
 extern void test_pwm_control(void);
+extern void test_esc_sim(void);
+extern void test_pio_emu(void);
 
-void setUp(void) {}
+void setUp(void) {
+    mock_sdk_reset();
+}
 
 void tearDown(void) {}
 
 int main(void) {
     UNITY_BEGIN();
     test_usb_comm();
+    test_link_frame();
+    test_link_transport();
+    test_link_tx();
     test_runtime_config();
+    test_trajectory();
+    test_clock_sync();
     test_dshot_control();
+    test_capture_usb();
     test_dshot_protocol();
     test_pwm_control();
+    test_esc_sim();
+    test_pio_emu();
     return UNITY_END();
 }
@@ -0,0 +1,280 @@
+#include "sim/pio_emu.h"
+#include "unity/unity.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DSHOT_PIO_SOURCE "src/dshot/dshot.pio"
+#define EMU_PIN 6
+#define EMU_SYS_CLOCK_HZ 125000000u
+#define EMU_MAX_FRAME_CYCLES 20000
+#define EMU_MAX_WORDS 8
+#define EMU_MAX_EDGES 32
+#define EMU_WAIT_CYCLES 1875 /* dshot_loop_async_start() at DShot600 */
+#define EMU_RUN_LIMIT 250
+#define EMU_FIRST_BIT_CYCLE 3 /* set pindirs, pull, set x */
+#define EMU_TX_CYCLES (16 * 125)
+
+struct frame_capture {
+    uint32_t words[EMU_MAX_WORDS];
+    int word_count;
+    uint64_t release_cycle; /* set pindirs, 0 */
+    uint64_t redrive_cycle; /* set pindirs, 1 after the RX phase */
+};
+
+static struct pio_emu_program oversample_program;
+static struct pio_emu_program edge_program;
+
+static void load_programs(void) {
+    TEST_ASSERT_EQUAL_INT(0, pio_emu_assemble_file(DSHOT_PIO_SOURCE, "pio_dshot",
+                                                   &oversample_program));
+    TEST_ASSERT_EQUAL_INT(0, pio_emu_assemble_file(DSHOT_PIO_SOURCE, "pio_dshot_edge",
+                                                   &edge_program));
+}
+
+static void init_sm(struct pio_emu_sm *sm, const struct pio_emu_program *program, uint16_t speed,
+                    struct pio_emu_line *line) {
+    pio_emu_init(sm, program, EMU_PIN, EMU_SYS_CLOCK_HZ,
+                 (float)EMU_SYS_CLOCK_HZ / (1000.0F * (float)speed * 125.0F));
+    sm->pins = 1u << EMU_PIN; /* Idle high, as left by the previous frame's cleanup */
+    line->pin = EMU_PIN;
+    pio_emu_set_input(sm, pio_emu_line_input, line);
+}
+
+/* Queue a frame the way dshot_loop_async_start() does and run until the SM wraps to pull */
+static void run_frame(struct pio_emu_sm *sm, uint16_t frame, struct frame_capture *capture) {
+    const uint32_t tx_words[] = {~(uint32_t)frame << 16, EMU_WAIT_CYCLES, EMU_RUN_LIMIT};
+    int tx_count = sm->program == &edge_program ? 3 : 2;
+
+    capture->word_count = pio_emu_run_frame(sm, tx_words, tx_count, capture->words, EMU_MAX_WORDS,
+                                            EMU_MAX_FRAME_CYCLES);
+    TEST_ASSERT_TRUE(sm->stalled);
+
+    capture->release_cycle = 0;
+    capture->redrive_cycle = 0;
+    for (int i = 1; i < sm->event_count; ++i) {
+        bool driven = (sm->events[i].pindirs >> EMU_PIN) & 0x1u;
+        bool was_driven = (sm->events[i - 1].pindirs >> EMU_PIN) & 0x1u;
+        if (was_driven && !driven) {
+            capture->release_cycle = sm->events[i].cycle;
+        } else if (!was_driven && driven && capture->release_cycle != 0) {
+            capture->redrive_cycle = sm->events[i].cycle;
+        }
+    }
+}
+
+/* Falling and rising edges of the driven output, in event order */
+static int driven_edges(const struct pio_emu_sm *sm, uint64_t *cycles, bool *levels) {
+    bool level = true;
+    int count = 0;
+    for (int i = 0; i < sm->event_count && count < EMU_MAX_EDGES * 2; ++i) {
+        const struct pio_emu_pin_event *event = &sm->events[i];
+        if (!((event->pindirs >> EMU_PIN) & 0x1u)) {
+            continue;
+        }
+        bool next = (event->pins >> EMU_PIN) & 0x1u;
+        if (next != level) {
+            cycles[count] = event->cycle;
+            levels[count++] = next;
+            level = next;
+        }
+    }
+    return count;
+}
+
+static void test_pio_emu_assembles_dshot_programs(void) {
+    load_programs();
+
+    TEST_ASSERT_EQUAL_UINT8(29, oversample_program.length);
+    TEST_ASSERT_EQUAL_UINT8(30, edge_program.length);
+    TEST_ASSERT_EQUAL_UINT8(0, oversample_program.wrap_target);
+    TEST_ASSERT_EQUAL_UINT8(oversample_program.length - 1, oversample_program.wrap);
+    TEST_ASSERT_EQUAL_HEX16(0xE081, oversample_program.instructions[0]); /* set pindirs, 1 */
+    TEST_ASSERT_EQUAL_HEX16(0x80A0, oversample_program.instructions[1]); /* pull block */
+    TEST_ASSERT_EQUAL_INT(-1, pio_emu_assemble_file(DSHOT_PIO_SOURCE, "missing",
+                                                    &oversample_program));
+}
+
+static void test_pio_emu_rejects_unknown_instructions(void) {
+    struct pio_emu_program program;
+    const char *source = ".program bad\n"
+                         "    set x, 1\n"
+                         "    wiggle pins\n";
+
+    TEST_ASSERT_EQUAL_INT(3, pio_emu_assemble(source, "bad", &program));
+}
+
+static void test_pio_emu_tx_bits_are_125_cycles_with_betaflight_duty(void) {
+    struct pio_emu_sm sm;
+    struct pio_emu_line line = {0};
+    struct frame_capture capture;
+    uint64_t cycles[EMU_MAX_EDGES * 2];
+    bool levels[EMU_MAX_EDGES * 2];
+    const uint16_t frame = 0xA5C3;
+
+    load_programs();
+    init_sm(&sm, &oversample_program, 600, &line);
+    run_frame(&sm, frame, &capture);
+
+    int edge_count = driven_edges(&sm, cycles, levels);
+    TEST_ASSERT_TRUE(edge_count >= 32);
+    for (int bit = 0; bit < 16; ++bit) {
+        bool one = (frame >> (15 - bit)) & 0x1u;
+        TEST_ASSERT_FALSE(levels[bit * 2]);
+        TEST_ASSERT_TRUE(levels[(bit * 2) + 1]);
+        TEST_ASSERT_EQUAL_UINT64(cycles[0] + ((uint64_t)bit * 125), cycles[bit * 2]);
+        TEST_ASSERT_EQUAL_UINT64(one ? 83 : 42, cycles[(bit * 2) + 1] - cycles[bit * 2]);
+    }
+}
+
+static void test_pio_emu_frame_timing_matches_wait_cycles(void) {
+    struct pio_emu_sm sm;
+    struct pio_emu_line line = {0};
+    struct frame_capture capture;
+    uint64_t cycles[EMU_MAX_EDGES * 2];
+    bool levels[EMU_MAX_EDGES * 2];
+
+    load_programs();
+
+    /* pull and mov x, osr, then the wait loop runs wait + 1 times */
+    init_sm(&sm, &oversample_program, 600, &line);
+    run_frame(&sm, 0x1234, &capture);
+    driven_edges(&sm, cycles, levels);
+    TEST_ASSERT_EQUAL_UINT64(EMU_TX_CYCLES + 2 + EMU_WAIT_CYCLES + 1,
+                             capture.release_cycle - cycles[0]);
+
+    /* The edge program also pulls the run limit into Y */
+    init_sm(&sm, &edge_program, 600, &line);
+    run_frame(&sm, 0x1234, &capture);
+    driven_edges(&sm, cycles, levels);
+    TEST_ASSERT_EQUAL_UINT64(EMU_TX_CYCLES + 4 + EMU_WAIT_CYCLES + 1,
+                             capture.release_cycle - cycles[0]);
+
+    /* 2000 TX cycles at DShot600 from 125 MHz: clkdiv 1.6640625 after truncation */
+    uint32_t tx_ns = (uint32_t)(pio_emu_cycle_time_ns(&sm, cycles[0] + EMU_TX_CYCLES) -
+                                pio_emu_cycle_time_ns(&sm, cycles[0]));
+    TEST_ASSERT_UINT32_WITHIN(100, 26667, tx_ns);
+}
+
+static void test_pio_emu_oversample_samples_every_18_cycles(void) {
+    struct pio_emu_sm sm;
+    struct pio_emu_line line = {0};
+    struct frame_capture capture;
+    const uint64_t response_delay = 40;
+    const uint64_t low_cycles = 18 * 20;
+
+    load_programs();
+    init_sm(&sm, &oversample_program, 600, &line);
+
+    uint64_t release = EMU_FIRST_BIT_CYCLE + EMU_TX_CYCLES + 2 + EMU_WAIT_CYCLES + 1;
+    line.toggles[0] = release + response_delay;
+    line.toggles[1] = release + response_delay + low_cycles;
+    line.toggle_count = 2;
+    run_frame(&sm, 0x1234, &capture);
+    TEST_ASSERT_EQUAL_UINT64(release, capture.release_cycle);
+
+    /* 4 sample words and the completion word */
+    TEST_ASSERT_EQUAL_INT(5, capture.word_count);
+    int zeros = __builtin_clz(capture.words[0]);
+    TEST_ASSERT_INT_WITHIN(1, (int)(low_cycles / 18), zeros);
+    TEST_ASSERT_EQUAL_HEX32(UINT32_MAX, capture.words[3]);
+    TEST_ASSERT_EQUAL_HEX32(0, capture.words[4]);
+
+    /* 128 samples of 18 cycles after the falling edge is seen */
+    uint64_t rx_cycles = capture.redrive_cycle - line.toggles[0];
+    TEST_ASSERT_TRUE(rx_cycles >= 128 * 18);
+    TEST_ASSERT_TRUE(rx_cycles <= (128 * 18) + 12);
+}
+
+static void test_pio_emu_oversample_times_out_after_288_cycles(void) {
+    struct pio_emu_sm sm;
+    struct pio_emu_line line = {0};
+    struct frame_capture capture;
+
+    load_programs();
+    init_sm(&sm, &oversample_program, 600, &line);
+    run_frame(&sm, 0x1234, &capture);
+
+    TEST_ASSERT_EQUAL_INT(0, capture.word_count);
+    TEST_ASSERT_UINT64_WITHIN(4, 288, capture.redrive_cycle - capture.release_cycle);
+}
+
+static void test_pio_emu_edge_capture_counts_two_cycles(void) {
+    struct pio_emu_sm sm;
+    struct pio_emu_line line = {0};
+    struct frame_capture capture;
+    const uint64_t runs[] = {100, 200, 100};
+
+    load_programs();
+    init_sm(&sm, &edge_program, 600, &line);
+
+    uint64_t release = EMU_FIRST_BIT_CYCLE + EMU_TX_CYCLES + 4 + EMU_WAIT_CYCLES + 1;
+    uint64_t t = release + 40;
+    line.toggles[line.toggle_count++] = t;
+    for (int i = 0; i < 3; ++i) {
+        t += runs[i];
+        line.toggles[line.toggle_count++] = t;
+    }
+    run_frame(&sm, 0x1234, &capture);
+
+    /* Idle run and three data runs fill one word; the end marker follows */
+    TEST_ASSERT_EQUAL_INT(2, capture.word_count);
+    TEST_ASSERT_EQUAL_HEX32(0x000000FF, capture.words[1]);
+    TEST_ASSERT_UINT32_WITHIN(2, EMU_RUN_LIMIT - 20, capture.words[0] >> 24);
+    for (int i = 0; i < 3; ++i) {
+        uint32_t remaining = (capture.words[0] >> (16 - (i * 8))) & 0xFF;
+        uint32_t counts = EMU_RUN_LIMIT - remaining + 1; /* EDGE_CAPTURE_RUN_OVERHEAD */
+        TEST_ASSERT_UINT32_WITHIN(1, runs[i] / 2, counts);
+    }
+}
+
+static void test_pio_emu_edge_capture_times_out_with_marker(void) {
+    struct pio_emu_sm sm;
+    struct pio_emu_line line = {0};
+    struct frame_capture capture;
+
+    load_programs();
+    init_sm(&sm, &edge_program, 600, &line);
+    run_frame(&sm, 0x1234, &capture);
+
+    TEST_ASSERT_EQUAL_INT(1, capture.word_count);
+    TEST_ASSERT_EQUAL_HEX32(0x000000FF, capture.words[0]);
+    TEST_ASSERT_UINT64_WITHIN(8, 2 * EMU_RUN_LIMIT, capture.redrive_cycle - capture.release_cycle);
+}
+
+static void test_pio_emu_edge_capture_stuck_low_aborts_with_marker(void) {
+    struct pio_emu_sm sm;
+    struct pio_emu_line line = {0};
+    struct frame_capture capture;
+
+    load_programs();
+    init_sm(&sm, &edge_program, 600, &line);
+
+    /* Idle, low and high runs, then the line stays low */
+    uint64_t release = EMU_FIRST_BIT_CYCLE + EMU_TX_CYCLES + 4 + EMU_WAIT_CYCLES + 1;
+    line.toggles[line.toggle_count++] = release + 40;
+    line.toggles[line.toggle_count++] = release + 140;
+    line.toggles[line.toggle_count++] = release + 340;
+    run_frame(&sm, 0x1234, &capture);
+
+    /* The marker completes the word, so autopush sends it and the push adds an empty word
+     * that dshot_loop_async_start() drains before the next frame */
+    TEST_ASSERT_EQUAL_INT(2, capture.word_count);
+    TEST_ASSERT_EQUAL_HEX32(0x000000FF, capture.words[0] & 0xFF);
+    TEST_ASSERT_UINT32_WITHIN(2, EMU_RUN_LIMIT - 50, (capture.words[0] >> 16) & 0xFF);
+    TEST_ASSERT_UINT32_WITHIN(2, EMU_RUN_LIMIT - 100, (capture.words[0] >> 8) & 0xFF);
+    TEST_ASSERT_EQUAL_HEX32(0, capture.words[1]);
+    TEST_ASSERT_UINT64_WITHIN(16, 340 + (2 * EMU_RUN_LIMIT),
+                              capture.redrive_cycle - capture.release_cycle);
+}
+
+void test_pio_emu(void) {
+    RUN_TEST(test_pio_emu_assembles_dshot_programs);
+    RUN_TEST(test_pio_emu_rejects_unknown_instructions);
+    RUN_TEST(test_pio_emu_tx_bits_are_125_cycles_with_betaflight_duty);
+    RUN_TEST(test_pio_emu_frame_timing_matches_wait_cycles);
+    RUN_TEST(test_pio_emu_oversample_samples_every_18_cycles);
+    RUN_TEST(test_pio_emu_oversample_times_out_after_288_cycles);
+    RUN_TEST(test_pio_emu_edge_capture_counts_two_cycles);
+    RUN_TEST(test_pio_emu_edge_capture_times_out_with_marker);
+    RUN_TEST(test_pio_emu_edge_capture_stuck_low_aborts_with_marker);
+}
@@ -1,6 +1,10 @@
+#include "link/tx.h"
+#include "motors.h"
+#include "support/link_capture.h"
 #include "support/runtime_config_host.h"
 #include "support/usb_comm_host.h"
 #include "unity/unity.h"
+#include <string.h>
 
 static void test_normalize_dshot_speed_accepts_supported_values(void) {
     TEST_ASSERT_EQUAL_UINT16(150, mcu_runtime_config_normalize_dshot_speed(150));
@@ -54,6 +58,27 @@ static void test_parse_packet_accepts_valid_packet_and_populates_config(void) {
     TEST_ASSERT_EQUAL_UINT16(150, config.dshot_speed);
 }
 
+static void test_parse_packet_reads_command_format_from_protocol_byte(void) {
+    uint8_t packet[USB_CONFIG_PACKET_SIZE] = {
+        USB_CONFIG_START_BYTE,
+        (USB_COMMAND_FORMAT_DELTA << 4) | THRUSTER_PROTOCOL_DSHOT,
+        0x58,
+        0x02,
+    };
+    mcu_runtime_config_t config = {0};
+
+    packet[USB_CONFIG_PACKET_SIZE - 1] = usb_calculate_checksum(packet, USB_CONFIG_PACKET_SIZE - 1);
+    TEST_ASSERT_TRUE(mcu_runtime_config_parse_packet(packet, sizeof(packet), &config));
+    TEST_ASSERT_EQUAL_INT(THRUSTER_PROTOCOL_DSHOT, config.protocol);
+    TEST_ASSERT_EQUAL_UINT8(USB_COMMAND_FORMAT_DELTA, config.command_format);
+
+    packet[1] = (0x0F << 4) | THRUSTER_PROTOCOL_PWM;
+    packet[USB_CONFIG_PACKET_SIZE - 1] = usb_calculate_checksum(packet, USB_CONFIG_PACKET_SIZE - 1);
+    TEST_ASSERT_TRUE(mcu_runtime_config_parse_packet(packet, sizeof(packet), &config));
+    TEST_ASSERT_EQUAL_INT(THRUSTER_PROTOCOL_PWM, config.protocol);
+    TEST_ASSERT_EQUAL_UINT8(USB_COMMAND_FORMAT_FULL, config.command_format);
+}
+
 static void test_parse_packet_rejects_wrong_size(void) {
     const uint8_t packet[] = {USB_CONFIG_START_BYTE, THRUSTER_PROTOCOL_DSHOT, 0x58, 0x02};
     mcu_runtime_config_t config = {0};
@@ -84,6 +109,49 @@ static void test_protocol_name_returns_expected_strings(void) {
     TEST_ASSERT_EQUAL_STRING("DShot", mcu_runtime_config_protocol_name(THRUSTER_PROTOCOL_DSHOT));
 }
 
+static void test_parse_capability_query_keeps_supported_features(void) {
+    uint8_t packet[USB_CAPABILITY_QUERY_PACKET_SIZE] = {USB_CAPABILITY_QUERY_START_BYTE, 1};
+    uint32_t requested = MCU_FEATURE_CAPTURE_FAILED | (1u << 31);
+    bool apply = false;
+    uint32_t features = 0;
+
+    memcpy(&packet[2], &requested, sizeof(requested));
+    packet[USB_CAPABILITY_QUERY_PACKET_SIZE - 1] =
+        usb_calculate_checksum(packet, USB_CAPABILITY_QUERY_PACKET_SIZE - 1);
+
+    TEST_ASSERT_TRUE(mcu_runtime_config_parse_capability_query(packet, &apply, &features));
+    TEST_ASSERT_TRUE(apply);
+    TEST_ASSERT_EQUAL_HEX32(MCU_FEATURE_CAPTURE_FAILED, features);
+
+    packet[USB_CAPABILITY_QUERY_PACKET_SIZE - 1] ^= 0xFF;
+    TEST_ASSERT_FALSE(mcu_runtime_config_parse_capability_query(packet, &apply, &features));
+}
+
+static void test_send_capabilities_reports_limits_and_features(void) {
+    uint32_t features;
+    uint16_t input_max;
+
+    link_tx_reset();
+    link_capture_select(NULL, 0, LINK_CAPTURE_SIZE);
+    mcu_runtime_config_send_capabilities(MCU_FEATURE_TELEMETRY_COALESCE);
+    link_tx_flush();
+    link_tx_reset();
+    link_transport_select(&link_transport_stdio);
+
+    TEST_ASSERT_EQUAL_size_t(USB_CAPABILITY_PACKET_SIZE, link_capture_output_len);
+    TEST_ASSERT_EQUAL_HEX8(USB_CAPABILITY_START_BYTE, link_capture_output[0]);
+    memcpy(&features, &link_capture_output[5], sizeof(features));
+    TEST_ASSERT_EQUAL_HEX32(MCU_FEATURE_TELEMETRY_COALESCE, features);
+    TEST_ASSERT_EQUAL_UINT8(NUM_MOTORS, link_capture_output[9]);
+    /* 150, 300 and 600; 1200 needs an RP2350 */
+    TEST_ASSERT_EQUAL_HEX8(0x07, link_capture_output[10]);
+    TEST_ASSERT_EQUAL_HEX8(0x03, link_capture_output[13]);
+    memcpy(&input_max, &link_capture_output[14], sizeof(input_max));
+    TEST_ASSERT_EQUAL_UINT16(USB_INPUT_PACKET_MAX, input_max);
+    TEST_ASSERT_EQUAL_HEX8(usb_calculate_checksum(link_capture_output, 21),
+                           link_capture_output[21]);
+}
+
 void test_runtime_config(void) {
     RUN_TEST(test_normalize_dshot_speed_accepts_supported_values);
     RUN_TEST(test_normalize_dshot_speed_limits_1200_on_non_rp2350_hosts);
@@ -91,8 +159,11 @@ void test_runtime_config(void) {
     RUN_TEST(test_validate_keeps_valid_config_unchanged);
     RUN_TEST(test_validate_corrects_invalid_protocol_and_speed);
     RUN_TEST(test_parse_packet_accepts_valid_packet_and_populates_config);
+    RUN_TEST(test_parse_packet_reads_command_format_from_protocol_byte);
     RUN_TEST(test_parse_packet_rejects_wrong_size);
     RUN_TEST(test_parse_packet_rejects_wrong_start_byte);
     RUN_TEST(test_parse_packet_rejects_bad_checksum);
     RUN_TEST(test_protocol_name_returns_expected_strings);
+    RUN_TEST(test_parse_capability_query_keeps_supported_features);
+    RUN_TEST(test_send_capabilities_reports_limits_and_features);
 }
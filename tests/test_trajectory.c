@@ -0,0 +1,117 @@
+#include "mocks/mock_sdk.h"
+#include "support/usb_comm_host.h"
+#include "trajectory.h"
+#include "unity/unity.h"
+#include <string.h>
+
+/* points holds each point's offset followed by a value per motor in the mask */
+static void build_packet(uint8_t *packet, uint8_t mask, uint32_t start_us, uint8_t count,
+                         const uint16_t *points) {
+    int motors = 0;
+    for (int i = 0; i < 8; ++i) {
+        motors += (mask >> i) & 1;
+    }
+    size_t size = TRAJECTORY_PACKET_SIZE(motors, count);
+
+    packet[0] = TRAJECTORY_START_BYTE;
+    packet[1] = mask;
+    packet[2] = count;
+    memcpy(&packet[3], &start_us, sizeof(start_us));
+    for (size_t i = 0; i < (size_t)count * (1 + motors); ++i) {
+        packet[TRAJECTORY_HEADER_SIZE + (i * 2)] = (uint8_t)(points[i] & 0xFF);
+        packet[TRAJECTORY_HEADER_SIZE + (i * 2) + 1] = (uint8_t)(points[i] >> 8);
+    }
+    packet[size - 1] = usb_calculate_checksum(packet, size - 1);
+}
+
+static void test_trajectory_applies_newest_due_point_per_motor(void) {
+    const uint16_t points[] = {0, 1100, 1200, 500, 1300, 1400, 1000, 1500, 1600};
+    uint8_t packet[TRAJECTORY_PACKET_SIZE(2, 3)];
+    uint16_t values[8] = {0};
+
+    trajectory_reset();
+    mock_time_set_us(10000);
+    build_packet(packet, 0x05, 10100, 3, points);
+    TEST_ASSERT_TRUE(trajectory_parse_packet(packet, mock_time_get_us()));
+
+    trajectory_apply(10099, values);
+    TEST_ASSERT_EQUAL_UINT16(0, values[0]);
+    trajectory_apply(10700, values);
+    TEST_ASSERT_EQUAL_UINT16(1300, values[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, values[1]);
+    TEST_ASSERT_EQUAL_UINT16(1400, values[2]);
+    TEST_ASSERT_TRUE(trajectory_pending());
+    trajectory_apply(11100, values);
+    TEST_ASSERT_EQUAL_UINT16(1500, values[0]);
+    TEST_ASSERT_EQUAL_UINT16(1600, values[2]);
+    TEST_ASSERT_FALSE(trajectory_pending());
+    TEST_ASSERT_EQUAL_UINT32(6, trajectory_stats()->points_queued);
+    TEST_ASSERT_EQUAL_UINT32(0, trajectory_stats()->points_late);
+}
+
+static void test_trajectory_packet_replaces_points_from_its_start(void) {
+    const uint16_t first[] = {0, 1100, 100, 1200, 200, 1300};
+    const uint16_t second[] = {0, 1900};
+    uint8_t packet[TRAJECTORY_PACKET_SIZE(1, 3)];
+    uint16_t values[8] = {0};
+
+    trajectory_reset();
+    build_packet(packet, 0x01, 1000, 3, first);
+    TEST_ASSERT_TRUE(trajectory_parse_packet(packet, 0));
+    build_packet(packet, 0x01, 1100, 1, second);
+    TEST_ASSERT_TRUE(trajectory_parse_packet(packet, 0));
+
+    trajectory_apply(1000, values);
+    TEST_ASSERT_EQUAL_UINT16(1100, values[0]);
+    trajectory_apply(1250, values);
+    TEST_ASSERT_EQUAL_UINT16(1900, values[0]);
+    TEST_ASSERT_FALSE(trajectory_pending());
+}
+
+static void test_trajectory_rejects_bad_packets(void) {
+    const uint16_t falling[] = {100, 1100, 100, 1200};
+    const uint16_t distant[] = {0, 1100};
+    uint8_t packet[TRAJECTORY_PACKET_SIZE(1, 2)];
+
+    trajectory_reset();
+    build_packet(packet, 0x01, 1000, 2, falling);
+    TEST_ASSERT_FALSE(trajectory_parse_packet(packet, 0));
+
+    build_packet(packet, 0x01, (USB_COMM_TIMEOUT_MS * 1000) + 1, 1, distant);
+    TEST_ASSERT_FALSE(trajectory_parse_packet(packet, 0));
+
+    build_packet(packet, 0x01, 1000, 1, distant);
+    packet[TRAJECTORY_PACKET_SIZE(1, 1) - 1] ^= 0xFF;
+    TEST_ASSERT_FALSE(trajectory_parse_packet(packet, 0));
+    TEST_ASSERT_FALSE(trajectory_pending());
+}
+
+static void test_trajectory_counts_late_and_dropped_points(void) {
+    uint16_t points[(TRAJECTORY_QUEUE_POINTS + 2) * 2];
+    uint8_t packet[TRAJECTORY_PACKET_SIZE(1, TRAJECTORY_QUEUE_POINTS + 2)];
+    uint16_t values[8] = {0};
+
+    for (int i = 0; i < TRAJECTORY_QUEUE_POINTS + 2; ++i) {
+        points[i * 2] = (uint16_t)(i * 100);
+        points[(i * 2) + 1] = (uint16_t)(1000 + i);
+    }
+    trajectory_reset();
+    build_packet(packet, 0x02, 5000, TRAJECTORY_QUEUE_POINTS + 2, points);
+    TEST_ASSERT_TRUE(trajectory_parse_packet(packet, 5150));
+
+    TEST_ASSERT_EQUAL_UINT32(TRAJECTORY_QUEUE_POINTS, trajectory_stats()->points_queued);
+    TEST_ASSERT_EQUAL_UINT32(2, trajectory_stats()->points_late);
+    TEST_ASSERT_EQUAL_UINT32(2, trajectory_stats()->points_dropped);
+    trajectory_apply(5150, values);
+    TEST_ASSERT_EQUAL_UINT16(1001, values[1]);
+
+    trajectory_clear();
+    TEST_ASSERT_FALSE(trajectory_pending());
+}
+
+void test_trajectory(void) {
+    RUN_TEST(test_trajectory_applies_newest_due_point_per_motor);
+    RUN_TEST(test_trajectory_packet_replaces_points_from_its_start);
+    RUN_TEST(test_trajectory_rejects_bad_packets);
+    RUN_TEST(test_trajectory_counts_late_and_dropped_points);
+}
@@ -1,5 +1,10 @@
+#include "clock_sync.h"
+#include "link/tx.h"
+#include "mocks/mock_sdk.h"
 #include "support/usb_comm_host.h"
+#include "trajectory.h"
 #include "unity/unity.h"
+#include <string.h>
 
 static void test_usb_calculate_checksum_returns_zero_for_empty_data(void) {
     TEST_ASSERT_EQUAL_HEX8(0x00, usb_calculate_checksum(0, 0));
@@ -67,6 +72,352 @@ static void test_usb_parse_packet_rejects_bad_checksum(void) {
     TEST_ASSERT_EQUAL_UINT64(123, last_comm_time);
 }
 
+static void test_usb_parse_packet_unpacks_12_bit_values(void) {
+    /* 0x123, 0x456, then 0x7D0 alone in the last two bytes */
+    uint8_t packet[USB_INPUT_PACKED_PACKET_SIZE(3)] = {USB_INPUT_PACKED_START_BYTE, 0x23, 0x61,
+                                                      0x45, 0xD0, 0x07};
+    uint16_t raw_values[3] = {0};
+    absolute_time_t last_comm_time = 0;
+
+    packet[sizeof(packet) - 1] = usb_calculate_checksum(packet, sizeof(packet) - 1);
+
+    TEST_ASSERT_EQUAL_size_t(7, sizeof(packet));
+    TEST_ASSERT_TRUE(usb_apply_command(packet, raw_values, 3, &last_comm_time));
+    TEST_ASSERT_EQUAL_UINT16(0x123, raw_values[0]);
+    TEST_ASSERT_EQUAL_UINT16(0x456, raw_values[1]);
+    TEST_ASSERT_EQUAL_UINT16(0x7D0, raw_values[2]);
+}
+
+static void test_usb_parse_packet_applies_changed_motors_and_deltas(void) {
+    uint8_t changed[USB_INPUT_CHANGED_PACKET_SIZE(3, 1)] = {USB_INPUT_CHANGED_START_BYTE, 0x04,
+                                                           0xDC, 0x05};
+    uint8_t delta[USB_INPUT_DELTA_PACKET_SIZE(3)] = {USB_INPUT_DELTA_START_BYTE, 0x05, 0x80,
+                                                     0x7F};
+    uint16_t raw_values[3] = {1000, 100, 4090};
+    absolute_time_t last_comm_time = 0;
+
+    changed[sizeof(changed) - 1] = usb_calculate_checksum(changed, sizeof(changed) - 1);
+    delta[sizeof(delta) - 1] = usb_calculate_checksum(delta, sizeof(delta) - 1);
+
+    TEST_ASSERT_TRUE(usb_apply_command(changed, raw_values, 3, &last_comm_time));
+    TEST_ASSERT_EQUAL_UINT16(1000, raw_values[0]);
+    TEST_ASSERT_EQUAL_UINT16(100, raw_values[1]);
+    TEST_ASSERT_EQUAL_UINT16(1500, raw_values[2]);
+
+    /* +5, -128 clamped at 0, +127 clamped at the 12-bit maximum */
+    raw_values[2] = 4090;
+    TEST_ASSERT_TRUE(usb_apply_command(delta, raw_values, 3, &last_comm_time));
+    TEST_ASSERT_EQUAL_UINT16(1005, raw_values[0]);
+    TEST_ASSERT_EQUAL_UINT16(0, raw_values[1]);
+    TEST_ASSERT_EQUAL_UINT16(USB_COMMAND_VALUE_MAX, raw_values[2]);
+}
+
+static void test_usb_poll_multi_assembles_command_from_stdin(void) {
+    uint8_t stream[] = {0x00, USB_INPUT_START_BYTE, 0xE8, 0x03, 0xD0, 0x07, 0x00};
+    uint8_t command_buf[USB_INPUT_PACKET_SIZE(2)];
+    uint8_t config_buf[8];
+
+    usb_comm_reset();
+    stream[sizeof(stream) - 1] = usb_calculate_checksum(&stream[1], sizeof(stream) - 2);
+    mock_stdin_push(stream, sizeof(stream));
+
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_COMMAND, usb_poll_multi(command_buf, sizeof(command_buf),
+                                                             config_buf, sizeof(config_buf)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&stream[1], command_buf, sizeof(command_buf));
+}
+
+static void test_usb_poll_multi_keeps_partial_packet_for_next_call(void) {
+    uint8_t stream[] = {USB_INPUT_START_BYTE, 0xE8, 0x03, 0xD0, 0x07, 0x00};
+    uint8_t command_buf[USB_INPUT_PACKET_SIZE(2)];
+    uint8_t config_buf[8];
+
+    usb_comm_reset();
+    stream[sizeof(stream) - 1] = usb_calculate_checksum(stream, sizeof(stream) - 1);
+    mock_stdin_push(stream, 4);
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_NONE, usb_poll_multi(command_buf, sizeof(command_buf),
+                                                          config_buf, sizeof(config_buf)));
+
+    mock_stdin_push(&stream[4], sizeof(stream) - 4);
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_COMMAND, usb_poll_multi(command_buf, sizeof(command_buf),
+                                                             config_buf, sizeof(config_buf)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(stream, command_buf, sizeof(command_buf));
+}
+
+static void test_usb_poll_multi_resyncs_after_truncated_packet(void) {
+    /* A packet cut short by a lost transfer, then a good config and command packet */
+    uint8_t stream[] = {USB_INPUT_START_BYTE, 0xE8, 0x03,
+                        USB_CONFIG_START_BYTE, 0x01, 0x58, 0x02, 0x00,
+                        USB_INPUT_START_BYTE, 0xDC, 0x05, 0xDC, 0x05, 0x00};
+    uint8_t command_buf[USB_INPUT_PACKET_SIZE(2)];
+    uint8_t config_buf[5];
+
+    usb_comm_reset();
+    stream[7] = usb_calculate_checksum(&stream[3], 4);
+    stream[13] = usb_calculate_checksum(&stream[8], 5);
+    mock_stdin_push(stream, sizeof(stream));
+
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_CONFIG,
+                          usb_poll_multi(command_buf, sizeof(command_buf), config_buf, 5));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&stream[3], config_buf, 5);
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_COMMAND,
+                          usb_poll_multi(command_buf, sizeof(command_buf), config_buf, 5));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&stream[8], command_buf, sizeof(command_buf));
+    TEST_ASSERT_EQUAL_UINT32(1, usb_link_stats()->checksum_errors);
+}
+
+static void test_usb_poll_multi_counts_link_stats(void) {
+    uint8_t stream[] = {0x00, 0x11, USB_INPUT_START_BYTE, 0xE8, 0x03, 0xD0, 0x07, 0x00,
+                        USB_INPUT_START_BYTE, 0xE8, 0x03, 0xD0, 0x07, 0x00};
+    uint8_t command_buf[USB_INPUT_PACKET_SIZE(2)];
+    uint8_t config_buf[8];
+
+    usb_comm_reset();
+    stream[7] = usb_calculate_checksum(&stream[2], 5);
+    stream[13] = (uint8_t)~usb_calculate_checksum(&stream[8], 5);
+    mock_stdin_push(stream, sizeof(stream));
+
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_COMMAND, usb_poll_multi(command_buf, sizeof(command_buf),
+                                                             config_buf, sizeof(config_buf)));
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_NONE, usb_poll_multi(command_buf, sizeof(command_buf),
+                                                          config_buf, sizeof(config_buf)));
+
+    /* The damaged packet is one failed candidate, then skipped byte by byte */
+    const usb_link_stats_t *stats = usb_link_stats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats->command_packets);
+    TEST_ASSERT_EQUAL_UINT32(0, stats->config_packets);
+    TEST_ASSERT_EQUAL_UINT32(1, stats->checksum_errors);
+    TEST_ASSERT_EQUAL_UINT32(2 + 5, stats->bytes_discarded);
+}
+
+static void test_usb_poll_latest_skips_stale_commands_but_keeps_config_order(void) {
+    uint8_t stream[] = {USB_INPUT_START_BYTE, 0xE8, 0x03, 0xE8, 0x03, 0x00,
+                        USB_INPUT_START_BYTE, 0xDC, 0x05, 0xDC, 0x05, 0x00,
+                        USB_CONFIG_START_BYTE, 0x01, 0x58, 0x02, 0x00,
+                        USB_INPUT_START_BYTE, 0xD0, 0x07, 0xD0, 0x07, 0x00};
+    uint8_t command_buf[USB_INPUT_PACKET_SIZE(2)];
+    uint8_t config_buf[5];
+
+    usb_comm_reset();
+    stream[5] = usb_calculate_checksum(&stream[0], 5);
+    stream[11] = usb_calculate_checksum(&stream[6], 5);
+    stream[16] = usb_calculate_checksum(&stream[12], 4);
+    stream[22] = usb_calculate_checksum(&stream[17], 5);
+    mock_stdin_push(stream, sizeof(stream));
+
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_COMMAND,
+                          usb_poll_latest(command_buf, sizeof(command_buf), config_buf, 5));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&stream[6], command_buf, sizeof(command_buf));
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_CONFIG,
+                          usb_poll_latest(command_buf, sizeof(command_buf), config_buf, 5));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&stream[12], config_buf, 5);
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_COMMAND,
+                          usb_poll_latest(command_buf, sizeof(command_buf), config_buf, 5));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&stream[17], command_buf, sizeof(command_buf));
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_NONE,
+                          usb_poll_latest(command_buf, sizeof(command_buf), config_buf, 5));
+    TEST_ASSERT_EQUAL_UINT32(3, usb_link_stats()->command_packets);
+    TEST_ASSERT_EQUAL_UINT32(1, usb_link_stats()->stale_commands);
+}
+
+static void test_usb_poll_latest_skips_only_for_commands_that_set_every_motor(void) {
+    uint8_t stream[] = {USB_INPUT_CHANGED_START_BYTE, 0x01, 0xE8, 0x03, 0x00,
+                        USB_INPUT_CHANGED_START_BYTE, 0x02, 0xD0, 0x07, 0x00,
+                        USB_INPUT_START_BYTE, 0xDC, 0x05, 0xDC, 0x05, 0x00,
+                        USB_INPUT_START_BYTE, 0xE8, 0x03, 0xE8, 0x03, 0x00};
+    uint8_t command_buf[USB_COMMAND_BUFFER_SIZE(2)];
+    uint8_t config_buf[5];
+    uint16_t values[2] = {0};
+    absolute_time_t last_comm_time = 0;
+    int commands = 0;
+
+    usb_comm_reset();
+    stream[4] = usb_calculate_checksum(&stream[0], 4);
+    stream[9] = usb_calculate_checksum(&stream[5], 4);
+    stream[15] = usb_calculate_checksum(&stream[10], 5);
+    stream[21] = usb_calculate_checksum(&stream[16], 5);
+    usb_set_command_format(USB_COMMAND_FORMAT_CHANGED);
+    mock_stdin_push(stream, sizeof(stream));
+
+    while (usb_poll_latest(command_buf, USB_INPUT_PACKET_SIZE(2), config_buf, 5) ==
+           USB_PACKET_COMMAND) {
+        TEST_ASSERT_TRUE(usb_apply_command(command_buf, values, 2, &last_comm_time));
+        commands++;
+    }
+
+    /* The first CHANGED packet is not skipped for the second; both are skipped for a FULL one */
+    TEST_ASSERT_EQUAL_INT(2, commands);
+    TEST_ASSERT_EQUAL_UINT32(2, usb_link_stats()->stale_commands);
+    TEST_ASSERT_EQUAL_UINT16(1000, values[0]);
+    TEST_ASSERT_EQUAL_UINT16(1000, values[1]);
+    usb_comm_reset();
+}
+
+static void test_usb_poll_multi_ignores_formats_not_chosen(void) {
+    uint8_t stream[] = {USB_INPUT_DELTA_START_BYTE, 0x01, 0x01, 0x00};
+    uint8_t command_buf[USB_COMMAND_BUFFER_SIZE(2)];
+    uint8_t config_buf[5];
+
+    usb_comm_reset();
+    stream[3] = usb_calculate_checksum(stream, 3);
+    mock_stdin_push(stream, sizeof(stream));
+
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_NONE,
+                          usb_poll_multi(command_buf, USB_INPUT_PACKET_SIZE(2), config_buf, 5));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(stream), usb_link_stats()->bytes_discarded);
+}
+
+static void test_usb_poll_latest_keeps_trajectory_packets_in_order(void) {
+    uint8_t stream[] = {USB_INPUT_START_BYTE, 0xE8, 0x03, 0xE8, 0x03, 0x00,
+                        TRAJECTORY_START_BYTE, 0x01, 0x01, 0x10, 0x27, 0x00, 0x00, 0x00, 0x00,
+                        0xDC, 0x05, 0x00,
+                        USB_INPUT_START_BYTE, 0xD0, 0x07, 0xD0, 0x07, 0x00};
+    uint8_t command_buf[USB_INPUT_PACKET_MAX];
+    uint8_t config_buf[5];
+
+    usb_comm_reset();
+    stream[5] = usb_calculate_checksum(&stream[0], 5);
+    stream[17] = usb_calculate_checksum(&stream[6], 11);
+    stream[23] = usb_calculate_checksum(&stream[18], 5);
+    mock_stdin_push(stream, sizeof(stream));
+
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_COMMAND,
+                          usb_poll_latest(command_buf, USB_INPUT_PACKET_SIZE(2), config_buf, 5));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&stream[0], command_buf, 6);
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_TRAJECTORY,
+                          usb_poll_latest(command_buf, USB_INPUT_PACKET_SIZE(2), config_buf, 5));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&stream[6], command_buf, 12);
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_COMMAND,
+                          usb_poll_latest(command_buf, USB_INPUT_PACKET_SIZE(2), config_buf, 5));
+    TEST_ASSERT_EQUAL_UINT32(3, usb_link_stats()->command_packets);
+    TEST_ASSERT_EQUAL_UINT32(0, usb_link_stats()->stale_commands);
+}
+
+static void test_usb_poll_latest_returns_ping_after_command(void) {
+    uint8_t stream[6 + CLOCK_SYNC_PING_PACKET_SIZE] = {USB_INPUT_START_BYTE, 0xE8, 0x03, 0xE8,
+                                                       0x03};
+    uint8_t *ping = &stream[6];
+    uint8_t command_buf[USB_INPUT_PACKET_MAX];
+    uint8_t config_buf[5];
+
+    usb_comm_reset();
+    stream[5] = usb_calculate_checksum(stream, 5);
+    ping[0] = CLOCK_SYNC_PING_START_BYTE;
+    ping[1] = 9;
+    ping[CLOCK_SYNC_PING_PACKET_SIZE - 1] =
+        usb_calculate_checksum(ping, CLOCK_SYNC_PING_PACKET_SIZE - 1);
+    mock_stdin_push(stream, sizeof(stream));
+
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_COMMAND,
+                          usb_poll_latest(command_buf, USB_INPUT_PACKET_SIZE(2), config_buf, 5));
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_CLOCK_SYNC,
+                          usb_poll_latest(command_buf, USB_INPUT_PACKET_SIZE(2), config_buf, 5));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ping, command_buf, CLOCK_SYNC_PING_PACKET_SIZE);
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_NONE,
+                          usb_poll_latest(command_buf, USB_INPUT_PACKET_SIZE(2), config_buf, 5));
+}
+
+static size_t push_frame(uint8_t seq, const uint8_t *packet, size_t len) {
+    uint8_t frame[LINK_FRAME_MAX_SIZE(USB_INPUT_PACKET_SIZE(2))];
+    size_t frame_len = link_frame_encode(seq, packet, len - 1, frame);
+    mock_stdin_push(frame, frame_len);
+    return frame_len;
+}
+
+static void test_usb_poll_multi_decodes_v2_frames_and_counts_sequence_gaps(void) {
+    uint8_t command[USB_INPUT_PACKET_SIZE(2)] = {USB_INPUT_START_BYTE, 0x00, 0x00, 0xDC, 0x05};
+    uint8_t command_buf[USB_INPUT_PACKET_SIZE(2)];
+    uint8_t config_buf[5];
+
+    usb_comm_reset();
+    command[sizeof(command) - 1] = usb_calculate_checksum(command, sizeof(command) - 1);
+    TEST_ASSERT_TRUE(usb_set_link_protocol(LINK_PROTOCOL_V2));
+    push_frame(250, command, sizeof(command));
+    push_frame(251, command, sizeof(command));
+    push_frame(2, command, sizeof(command));
+
+    for (int i = 0; i < 3; ++i) {
+        memset(command_buf, 0, sizeof(command_buf));
+        TEST_ASSERT_EQUAL_INT(USB_PACKET_COMMAND,
+                              usb_poll_multi(command_buf, sizeof(command_buf), config_buf, 5));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(command, command_buf, sizeof(command));
+    }
+    /* 252 to 1 wrapped around */
+    TEST_ASSERT_EQUAL_UINT32(6, usb_link_stats()->sequence_gaps);
+    TEST_ASSERT_EQUAL_UINT32(0, usb_link_stats()->checksum_errors);
+    usb_comm_reset();
+}
+
+static void test_usb_poll_multi_v2_resyncs_after_damaged_frame(void) {
+    uint8_t command[USB_INPUT_PACKET_SIZE(2)] = {USB_INPUT_START_BYTE, 0xE8, 0x03, 0xD0, 0x07};
+    uint8_t frame[LINK_FRAME_MAX_SIZE(sizeof(command))];
+    uint8_t command_buf[USB_INPUT_PACKET_SIZE(2)];
+    uint8_t config_buf[5];
+
+    usb_comm_reset();
+    command[sizeof(command) - 1] = usb_calculate_checksum(command, sizeof(command) - 1);
+    usb_set_link_protocol(LINK_PROTOCOL_V2);
+    size_t frame_len = link_frame_encode(0, command, sizeof(command) - 1, frame);
+    frame[3] ^= 0x10;
+    mock_stdin_push(frame, frame_len);
+    push_frame(1, command, sizeof(command));
+
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_COMMAND,
+                          usb_poll_multi(command_buf, sizeof(command_buf), config_buf, 5));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(command, command_buf, sizeof(command));
+    TEST_ASSERT_EQUAL_UINT32(1, usb_link_stats()->command_packets);
+    TEST_ASSERT_EQUAL_UINT32(1, usb_link_stats()->checksum_errors);
+    usb_comm_reset();
+}
+
+static void test_usb_poll_multi_v2_returns_to_v1_for_v1_config(void) {
+    uint8_t config[] = {USB_CONFIG_START_BYTE, 0x01, 0x58, 0x02, 0x00};
+    uint8_t command_buf[USB_INPUT_PACKET_SIZE(2)];
+    uint8_t config_buf[5];
+
+    usb_comm_reset();
+    config[4] = usb_calculate_checksum(config, 4);
+    usb_set_link_protocol(LINK_PROTOCOL_V2);
+    mock_stdin_push(config, sizeof(config));
+
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_CONFIG,
+                          usb_poll_multi(command_buf, sizeof(command_buf), config_buf, 5));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(config, config_buf, sizeof(config));
+    TEST_ASSERT_EQUAL_INT(LINK_PROTOCOL_V1, usb_link_protocol());
+    TEST_ASSERT_EQUAL_INT(LINK_PROTOCOL_V1, link_tx_protocol());
+}
+
+static void test_usb_poll_multi_accepts_link_protocol_packet(void) {
+    uint8_t request[USB_LINK_PROTOCOL_PACKET_SIZE] = {USB_LINK_PROTOCOL_START_BYTE, 2};
+    uint8_t command_buf[USB_INPUT_PACKET_SIZE(2)];
+    uint8_t config_buf[5];
+
+    usb_comm_reset();
+    request[2] = usb_calculate_checksum(request, 2);
+    mock_stdin_push(request, sizeof(request));
+
+    TEST_ASSERT_EQUAL_INT(USB_PACKET_LINK_PROTOCOL,
+                          usb_poll_multi(command_buf, sizeof(command_buf), config_buf, 5));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(request, config_buf, sizeof(request));
+    TEST_ASSERT_FALSE(usb_set_link_protocol(3));
+    TEST_ASSERT_EQUAL_INT(LINK_PROTOCOL_V1, usb_link_protocol());
+}
+
+static void test_usb_check_timeout_neutralizes_after_virtual_timeout(void) {
+    uint16_t thruster_values[2] = {1200, 1800};
+    bool comm_timed_out = false;
+
+    mock_time_set_us(USB_COMM_TIMEOUT_MS * 1000);
+    usb_check_timeout(0, thruster_values, 2, 1500, &comm_timed_out);
+    TEST_ASSERT_FALSE(comm_timed_out);
+    TEST_ASSERT_EQUAL_UINT16(1200, thruster_values[0]);
+
+    mock_time_advance_us(1);
+    usb_check_timeout(0, thruster_values, 2, 1500, &comm_timed_out);
+    TEST_ASSERT_TRUE(comm_timed_out);
+    TEST_ASSERT_EQUAL_UINT16(1500, thruster_values[0]);
+    TEST_ASSERT_EQUAL_UINT16(1500, thruster_values[1]);
+}
+
 void test_usb_comm(void) {
     RUN_TEST(test_usb_calculate_checksum_returns_zero_for_empty_data);
     RUN_TEST(test_usb_calculate_checksum_returns_single_byte_value);
@@ -75,4 +426,20 @@ void test_usb_comm(void) {
     RUN_TEST(test_usb_parse_packet_accepts_valid_packet_and_extracts_values);
     RUN_TEST(test_usb_parse_packet_rejects_wrong_start_byte);
     RUN_TEST(test_usb_parse_packet_rejects_bad_checksum);
+    RUN_TEST(test_usb_parse_packet_unpacks_12_bit_values);
+    RUN_TEST(test_usb_parse_packet_applies_changed_motors_and_deltas);
+    RUN_TEST(test_usb_poll_multi_assembles_command_from_stdin);
+    RUN_TEST(test_usb_poll_multi_keeps_partial_packet_for_next_call);
+    RUN_TEST(test_usb_poll_multi_resyncs_after_truncated_packet);
+    RUN_TEST(test_usb_poll_multi_counts_link_stats);
+    RUN_TEST(test_usb_poll_latest_skips_stale_commands_but_keeps_config_order);
+    RUN_TEST(test_usb_poll_latest_skips_only_for_commands_that_set_every_motor);
+    RUN_TEST(test_usb_poll_multi_ignores_formats_not_chosen);
+    RUN_TEST(test_usb_poll_latest_keeps_trajectory_packets_in_order);
+    RUN_TEST(test_usb_poll_latest_returns_ping_after_command);
+    RUN_TEST(test_usb_poll_multi_decodes_v2_frames_and_counts_sequence_gaps);
+    RUN_TEST(test_usb_poll_multi_v2_resyncs_after_damaged_frame);
+    RUN_TEST(test_usb_poll_multi_v2_returns_to_v1_for_v1_config);
+    RUN_TEST(test_usb_poll_multi_accepts_link_protocol_packet);
+    RUN_TEST(test_usb_check_timeout_neutralizes_after_virtual_timeout);
 }
@@ -0,0 +1,622 @@
+/*
+ * Full-firmware host build.
+ *
+ * Runs the unmodified src/main.c loop (firmware_init()/firmware_poll(), built
+ * with FIRMWARE_HOST_BUILD) against the mock SDK, with a simulated ESC bank
+ * (tests/sim/esc_sim.h) behind the PIO FIFOs. Time is the mock SDK's virtual
+ * clock: it advances with the PIO frame and response timing the ESC model
+ * produces, not with host CPU time, so the figures are PIO-bound and do not
+ * include the RP2040's own instruction cost.
+ *
+ * Load mode (default) sends a runtime config, then command packets at a fixed
+ * rate with every motor's throttle changing on each packet, and reports:
+ *   - command-to-frame latency: from the packet reaching USB input to the
+ *     first DShot frame carrying the new throttle, per motor
+ *   - DShot frames/s and main-loop iterations/s
+ *   - output bandwidth per packet type (tools/usb_output.h)
+ *
+ * Replay mode feeds a recorded session (tools/usb_session.h) into the
+ * firmware at its recorded times and reports the same figures. The virtual
+ * clock and the ESC model's fixed random seed make a replay deterministic,
+ * so two builds can be compared on identical real-world input.
+ *
+ * The firmware is built with the pipe transport (src/link/pipe.h): it reads
+ * its input from a pipe fed by this tool and writes its output to another
+ * pipe, or straight to stdout in pipe mode.
+ *
+ * Pipe mode bridges the process's stdin/stdout to the firmware's host link, so
+ * a host stack can talk to it as if it were the device. The virtual clock is
+ * paced to real time, and --record saves the input as a session. For a
+ * serial device node, use a pty:
+ *   socat PTY,link=/tmp/thrusters,raw,echo=0 EXEC:"build/tools/firmware_host --pipe"
+ *
+ * The ESC bank follows the DShot speed of every config packet sent.
+ *
+ * Usage: firmware_host [--pipe [--record session.bin] | --replay session.bin]
+ *                      [--speed n] [--rate-hz n] [--duration-ms n]
+ *                      [--latency-us n] [--drop-pct x] [--skew-pct x]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "dshot/control.h"
+#include "firmware.h"
+#include "link/pipe.h"
+#include "mocks/mock_sdk.h"
+#include "motors.h"
+#include "runtime_config.h"
+#include "sim/esc_sim.h"
+#include "usb_comm.h"
+#include "usb_output.h"
+#include "usb_session.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef DSHOT_RX_CAPTURE_MODE
+#define DSHOT_RX_CAPTURE_MODE DSHOT_RX_CAPTURE_OVERSAMPLE
+#endif
+
+#define HOST_INPUT_PACKET_SIZE USB_INPUT_PACKET_SIZE(NUM_MOTORS)
+#define HOST_SETUP_TIMEOUT_US 10000000u
+#define HOST_MIN_POLL_US 1
+#define HOST_OUTPUT_BUFFER_SIZE 65536
+#define HOST_THROTTLE_MIN 1100
+#define HOST_THROTTLE_SPAN 800
+#define HOST_REPLAY_TAIL_US 100000u
+
+struct host_options {
+    bool pipe;
+    const char *record_path;
+    const char *replay_path;
+    uint16_t speed;
+    uint32_t rate_hz;
+    uint32_t duration_ms;
+    struct esc_sim_config esc;
+};
+
+struct host_output {
+    int fd;
+    uint8_t buffer[HOST_OUTPUT_BUFFER_SIZE];
+    size_t length;
+    struct usb_output_parser parser;
+    uint64_t bytes[USB_OUTPUT_KIND_COUNT];
+    uint32_t packets[USB_OUTPUT_KIND_COUNT];
+    uint32_t telemetry_values;
+};
+
+struct host_latency {
+    uint32_t *samples_us;
+    size_t count;
+    size_t capacity;
+    uint32_t superseded; /* Throttle replaced by the next packet before it was sent */
+};
+
+/* Tracks the input the firmware was given, to time when each motor's frame follows */
+struct host_input {
+    uint8_t packet[HOST_INPUT_PACKET_SIZE];
+    size_t index;
+    uint32_t commands;
+    uint32_t configs;
+    uint32_t bad_checksums;
+    uint16_t expected[NUM_MOTORS]; /* DShot value the last command asks for */
+    bool pending[NUM_MOTORS];
+    uint64_t sent_us[NUM_MOTORS];
+    struct host_latency latency;
+};
+
+static struct esc_sim_bank bank;
+static struct host_input input;
+static int input_fd = -1; /* Write end of the firmware's input pipe */
+
+static void usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--pipe [--record session.bin] | --replay session.bin]\n"
+            "       [--speed n] [--rate-hz n] [--duration-ms n]\n"
+            "       [--latency-us n] [--drop-pct x] [--skew-pct x]\n",
+            program);
+}
+
+static bool parse_options(int argc, char **argv, struct host_options *options) {
+    memset(options, 0, sizeof(*options));
+    options->speed = 600;
+    options->rate_hz = 100;
+    options->duration_ms = 2000;
+    esc_sim_default_config(&options->esc);
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--pipe") == 0) {
+            options->pipe = true;
+        } else if (value == NULL) {
+            return false;
+        } else if (strcmp(arg, "--record") == 0) {
+            options->record_path = value;
+            i++;
+        } else if (strcmp(arg, "--replay") == 0) {
+            options->replay_path = value;
+            i++;
+        } else if (strcmp(arg, "--speed") == 0) {
+            options->speed = mcu_runtime_config_normalize_dshot_speed((uint16_t)atoi(value));
+            i++;
+        } else if (strcmp(arg, "--rate-hz") == 0) {
+            options->rate_hz = (uint32_t)atoi(value);
+            i++;
+        } else if (strcmp(arg, "--duration-ms") == 0) {
+            options->duration_ms = (uint32_t)atoi(value);
+            i++;
+        } else if (strcmp(arg, "--latency-us") == 0) {
+            options->esc.latency_us = (uint32_t)atoi(value);
+            i++;
+        } else if (strcmp(arg, "--drop-pct") == 0) {
+            options->esc.drop_pct = strtod(value, NULL);
+            i++;
+        } else if (strcmp(arg, "--skew-pct") == 0) {
+            options->esc.clock_skew_pct = strtod(value, NULL);
+            i++;
+        } else {
+            return false;
+        }
+    }
+
+    return options->rate_hz > 0 && options->duration_ms > 0 &&
+           (options->record_path == NULL || options->pipe) &&
+           (options->replay_path == NULL || !options->pipe);
+}
+
+static void start_esc_bank(const struct host_options *options) {
+    mock_sdk_reset();
+    esc_sim_init(&bank, &options->esc, options->speed, DSHOT_RX_CAPTURE_MODE);
+    esc_sim_add_escs(&bank, MOTOR0_PIN_BASE, NUM_MOTORS_0);
+    esc_sim_add_escs(&bank, MOTOR1_PIN_BASE, NUM_MOTORS_1);
+}
+
+static const struct esc_sim_esc *motor_esc(int motor) {
+    uint pin = motor < NUM_MOTORS_0 ? MOTOR0_PIN_BASE + motor
+                                    : MOTOR1_PIN_BASE + (motor - NUM_MOTORS_0);
+    return esc_sim_get(&bank, pin);
+}
+
+/* One firmware loop iteration; the clock always moves so idle loops terminate */
+static void poll_firmware(void) {
+    uint64_t before = mock_time_get_us();
+    firmware_poll();
+    if (mock_time_get_us() == before) {
+        mock_time_advance_us(HOST_MIN_POLL_US);
+    }
+}
+
+static void record_latency(struct host_latency *latency, uint32_t us) {
+    if (latency->count == latency->capacity) {
+        latency->capacity = latency->capacity ? latency->capacity * 2 : 1024;
+        latency->samples_us =
+            realloc(latency->samples_us, latency->capacity * sizeof(*latency->samples_us));
+        if (latency->samples_us == NULL) {
+            perror("firmware_host");
+            exit(1);
+        }
+    }
+    latency->samples_us[latency->count++] = us;
+}
+
+static void track_command(const uint8_t *packet) {
+    input.commands++;
+    for (int i = 0; i < NUM_MOTORS; ++i) {
+        uint16_t value = (uint16_t)(packet[(2 * i) + 1] | (packet[(2 * i) + 2] << 8));
+        uint16_t expected = dshot_translate_throttle_to_command(value);
+        if (expected == input.expected[i]) {
+            continue;
+        }
+        input.latency.superseded += input.pending[i];
+        input.expected[i] = expected;
+        input.pending[i] = true;
+        input.sent_us[i] = mock_time_get_us();
+    }
+}
+
+static void track_config(const uint8_t *packet) {
+    mcu_runtime_config_t config;
+    if (mcu_runtime_config_parse_packet(packet, USB_CONFIG_PACKET_SIZE, &config)) {
+        mcu_runtime_config_validate(&config);
+        bank.dshot_speed = config.dshot_speed;
+        input.configs++;
+    } else {
+        input.bad_checksums++;
+    }
+}
+
+/* Follow the packet framing of usb_poll_multi() over the bytes sent; unlike the firmware,
+ * a damaged packet is skipped whole rather than rescanned from its second byte */
+static void track_input_byte(uint8_t byte) {
+    size_t size = 0;
+    if (input.index == 0) {
+        if (byte != USB_INPUT_START_BYTE && byte != USB_CONFIG_START_BYTE) {
+            return;
+        }
+    }
+    input.packet[input.index++] = byte;
+    size = input.packet[0] == USB_INPUT_START_BYTE ? HOST_INPUT_PACKET_SIZE
+                                                   : USB_CONFIG_PACKET_SIZE;
+    if (input.index < size) {
+        return;
+    }
+
+    if (input.packet[0] == USB_CONFIG_START_BYTE) {
+        track_config(input.packet);
+    } else if (usb_calculate_checksum(input.packet, size - 1) == input.packet[size - 1]) {
+        track_command(input.packet);
+    } else {
+        input.bad_checksums++;
+    }
+    input.index = 0;
+}
+
+/* Create the firmware's input pipe; returns the read end for link_pipe_open() */
+static int open_input_pipe(void) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("firmware_host");
+        exit(1);
+    }
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+    input_fd = fds[1];
+    return fds[0];
+}
+
+/* Queue bytes on the firmware's input pipe; returns the number accepted */
+static size_t send_input(const uint8_t *data, size_t length) {
+    ssize_t count = write(input_fd, data, length);
+    size_t accepted = count > 0 ? (size_t)count : 0;
+    for (size_t i = 0; i < accepted; ++i) {
+        track_input_byte(data[i]);
+    }
+    return accepted;
+}
+
+/* Record the latency of every motor whose frame now carries its last command */
+static void check_frames(void) {
+    for (int i = 0; i < NUM_MOTORS; ++i) {
+        const struct esc_sim_esc *esc = motor_esc(i);
+        if (input.pending[i] && esc->throttle == input.expected[i] &&
+            esc->throttle_changed_us >= input.sent_us[i]) {
+            input.pending[i] = false;
+            uint64_t latency_us = esc->throttle_changed_us - input.sent_us[i];
+            record_latency(&input.latency, (uint32_t)latency_us);
+        }
+    }
+}
+
+/* ---- Pipe mode ---- */
+
+static double monotonic_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e6) + ((double)now.tv_nsec / 1e3);
+}
+
+static void pace_to_real_time(double start_us) {
+    double ahead_us = (double)mock_time_get_us() - (monotonic_us() - start_us);
+    if (ahead_us > 0.0) {
+        struct timespec delay = {.tv_sec = (time_t)(ahead_us / 1e6),
+                                 .tv_nsec = (long)(ahead_us * 1e3) % 1000000000L};
+        nanosleep(&delay, NULL);
+    } else {
+        mock_time_advance_us((uint64_t)-ahead_us);
+    }
+}
+
+static int run_pipe(const struct host_options *options) {
+    uint8_t buffer[256];
+    size_t pending = 0;
+    size_t offset = 0;
+    double start_us = monotonic_us();
+    FILE *session = NULL;
+
+    if (options->record_path != NULL) {
+        session = fopen(options->record_path, "wb");
+        if (session == NULL || !usb_session_write_header(session)) {
+            perror(options->record_path);
+            return 1;
+        }
+    }
+
+    fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+    link_pipe_open(open_input_pipe(), STDOUT_FILENO);
+    firmware_init();
+
+    while (true) {
+        /* Read more only once the firmware's input pipe has taken the last chunk */
+        if (offset == pending) {
+            ssize_t count = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (count == 0) {
+                if (session != NULL) {
+                    fclose(session);
+                }
+                return 0;
+            }
+            if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("stdin");
+                return 1;
+            }
+            pending = count > 0 ? (size_t)count : 0;
+            offset = 0;
+        }
+
+        size_t accepted = send_input(buffer + offset, pending - offset);
+        if (accepted > 0 && session != NULL) {
+            usb_session_write_record(session, mock_time_get_us(), buffer + offset, accepted);
+        }
+        offset += accepted;
+        poll_firmware();
+        pace_to_real_time(start_us);
+    }
+}
+
+/* ---- Load and replay modes ---- */
+
+static void drain_output(struct host_output *output) {
+    while (true) {
+        ssize_t count = read(output->fd, output->buffer + output->length,
+                             sizeof(output->buffer) - output->length);
+        if (count <= 0) {
+            break;
+        }
+        output->length += (size_t)count;
+    }
+
+    size_t offset = 0;
+    while (offset < output->length) {
+        enum usb_output_kind kind;
+        const uint8_t *packet;
+        size_t packet_len;
+        size_t length = usb_output_next_packet(&output->parser, output->buffer + offset,
+                                               output->length - offset, &packet, &packet_len,
+                                               &kind);
+        if (length == 0) {
+            break;
+        }
+        output->bytes[kind] += length;
+        output->packets[kind]++;
+        if (packet_len > 0) {
+            output->telemetry_values += usb_output_telemetry_values(packet);
+        }
+        offset += length;
+    }
+    memmove(output->buffer, output->buffer + offset, output->length - offset);
+    output->length -= offset;
+}
+
+static void reset_output_counts(struct host_output *output) {
+    memset(output->bytes, 0, sizeof(output->bytes));
+    memset(output->packets, 0, sizeof(output->packets));
+    output->telemetry_values = 0;
+}
+
+/* Connect the firmware to the input pipe and a non-blocking output pipe read by drain_output() */
+static void open_firmware_link(struct host_output *output) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("firmware_host");
+        exit(1);
+    }
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+    output->fd = fds[0];
+    link_pipe_open(open_input_pipe(), fds[1]);
+}
+
+static void send_config(uint16_t speed) {
+    uint8_t packet[USB_CONFIG_PACKET_SIZE] = {USB_CONFIG_START_BYTE, THRUSTER_PROTOCOL_DSHOT,
+                                              (uint8_t)(speed & 0xFF), (uint8_t)(speed >> 8)};
+    packet[USB_CONFIG_PACKET_SIZE - 1] = usb_calculate_checksum(packet, USB_CONFIG_PACKET_SIZE - 1);
+    send_input(packet, sizeof(packet));
+}
+
+/* Every motor's throttle differs from the previous packet's */
+static uint16_t load_throttle(uint32_t sequence, int motor) {
+    return (uint16_t)(HOST_THROTTLE_MIN + (((sequence * 37) + ((uint32_t)motor * 101)) %
+                                           HOST_THROTTLE_SPAN));
+}
+
+static void send_command(uint32_t sequence) {
+    uint8_t packet[HOST_INPUT_PACKET_SIZE] = {USB_INPUT_START_BYTE};
+    for (int i = 0; i < NUM_MOTORS; ++i) {
+        uint16_t value = load_throttle(sequence, i);
+        packet[(2 * i) + 1] = (uint8_t)(value & 0xFF);
+        packet[(2 * i) + 2] = (uint8_t)(value >> 8);
+    }
+    packet[HOST_INPUT_PACKET_SIZE - 1] = usb_calculate_checksum(packet, HOST_INPUT_PACKET_SIZE - 1);
+    send_input(packet, sizeof(packet));
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(const struct host_latency *latency, double pct) {
+    size_t index = (size_t)((pct / 100.0) * (double)(latency->count - 1) + 0.5);
+    return latency->samples_us[index];
+}
+
+static uint32_t total_frames(void) {
+    uint32_t frames = 0;
+    for (int i = 0; i < NUM_MOTORS; ++i) {
+        frames += motor_esc(i)->stats.frames;
+    }
+    return frames;
+}
+
+static bool wait_for_config(struct host_output *output) {
+    uint64_t deadline = mock_time_get_us() + HOST_SETUP_TIMEOUT_US;
+    while (output->packets[USB_OUTPUT_VERSION] == 0 && mock_time_get_us() < deadline) {
+        poll_firmware();
+        drain_output(output);
+    }
+    return output->packets[USB_OUTPUT_VERSION] > 0;
+}
+
+struct host_run {
+    FILE *report;
+    uint64_t start_us;
+    uint32_t start_frames;
+    uint32_t loops;
+};
+
+static void start_run(struct host_run *run, struct host_output *output) {
+    run->start_us = mock_time_get_us();
+    run->start_frames = total_frames();
+    run->loops = 0;
+    reset_output_counts(output);
+    input.commands = 0;
+    input.configs = 0;
+    input.bad_checksums = 0;
+    input.latency.count = 0;
+    input.latency.superseded = 0;
+}
+
+static void step_run(struct host_run *run, struct host_output *output) {
+    poll_firmware();
+    run->loops++;
+    drain_output(output);
+    check_frames();
+}
+
+static void print_report(const struct host_run *run, const struct host_output *output) {
+    FILE *report = run->report;
+    struct host_latency *latency = &input.latency;
+    double seconds = (double)(mock_time_get_us() - run->start_us) / 1e6;
+    uint32_t frames = total_frames() - run->start_frames;
+
+    fprintf(report, "config:     DShot%u, %s capture, %.3f s virtual\n", bank.dshot_speed,
+            DSHOT_RX_CAPTURE_MODE == DSHOT_RX_CAPTURE_EDGE ? "edge" : "oversample", seconds);
+    fprintf(report, "commands:   %u packets, %u configs, %u bad checksums\n", input.commands,
+            input.configs, input.bad_checksums);
+    fprintf(report, "updates:    %zu motor updates, %u superseded\n", latency->count,
+            latency->superseded);
+    if (latency->count > 0) {
+        uint64_t sum = 0;
+        qsort(latency->samples_us, latency->count, sizeof(*latency->samples_us), compare_u32);
+        for (size_t i = 0; i < latency->count; ++i) {
+            sum += latency->samples_us[i];
+        }
+        fprintf(report, "latency_us: mean %.1f  p50 %u  p99 %u  max %u  (command to frame)\n",
+                (double)sum / (double)latency->count, percentile(latency, 50.0),
+                percentile(latency, 99.0), latency->samples_us[latency->count - 1]);
+    }
+    fprintf(report, "frames:     %.0f frames/s total, %.0f per motor, %.0f loops/s\n",
+            frames / seconds, frames / seconds / NUM_MOTORS, run->loops / seconds);
+
+    uint64_t total = 0;
+    for (int kind = 0; kind < USB_OUTPUT_KIND_COUNT; ++kind) {
+        total += output->bytes[kind];
+    }
+    fprintf(report, "output:     %.0f B/s total, %.0f telemetry values/s\n", total / seconds,
+            output->telemetry_values / seconds);
+    for (int kind = 0; kind < USB_OUTPUT_KIND_COUNT; ++kind) {
+        fprintf(report, "  %-10s %8.0f B/s  %7.1f packets/s\n", usb_output_kind_names[kind],
+                output->bytes[kind] / seconds, output->packets[kind] / seconds);
+    }
+}
+
+static int run_load(const struct host_options *options) {
+    static struct host_output output;
+    struct host_run run = {.report = stdout};
+
+    open_firmware_link(&output);
+    firmware_init();
+    send_config(options->speed);
+    if (!wait_for_config(&output)) {
+        fprintf(run.report, "firmware_host: no version packet after the runtime config\n");
+        return 1;
+    }
+
+    uint64_t period_us = 1000000u / options->rate_hz;
+    start_run(&run, &output);
+    uint64_t end_us = run.start_us + ((uint64_t)options->duration_ms * 1000u);
+    uint64_t next_command_us = run.start_us;
+    uint32_t sequence = 0;
+
+    while (mock_time_get_us() < end_us) {
+        if (mock_time_get_us() >= next_command_us) {
+            send_command(sequence++);
+            next_command_us += period_us;
+        }
+        step_run(&run, &output);
+    }
+
+    fprintf(run.report, "source:     generated, %u Hz commands\n", options->rate_hz);
+    print_report(&run, &output);
+    free(input.latency.samples_us);
+    return 0;
+}
+
+/* Feed each record at its recorded time after the first; bytes wait while the input pipe is full */
+static int run_replay(const struct host_options *options) {
+    static struct host_output output;
+    static struct usb_session_record record;
+    FILE *session = fopen(options->replay_path, "rb");
+    if (session == NULL || !usb_session_read_header(session)) {
+        fprintf(stderr, "%s: not a USB session file\n", options->replay_path);
+        return 1;
+    }
+
+    struct host_run run = {.report = stdout};
+    open_firmware_link(&output);
+    firmware_init();
+    start_run(&run, &output);
+
+    uint32_t records = 0;
+    uint64_t first_us = 0;
+    size_t offset = 0;
+    int status = usb_session_read_record(session, &record);
+    if (status > 0) {
+        first_us = record.timestamp_us;
+    }
+
+    while (status > 0) {
+        if (mock_time_get_us() - run.start_us >= record.timestamp_us - first_us) {
+            offset += send_input(record.data + offset, record.length - offset);
+            if (offset == record.length) {
+                records++;
+                offset = 0;
+                status = usb_session_read_record(session, &record);
+                continue;
+            }
+        }
+        step_run(&run, &output);
+    }
+
+    uint64_t end_us = mock_time_get_us() + HOST_REPLAY_TAIL_US;
+    while (mock_time_get_us() < end_us) {
+        step_run(&run, &output);
+    }
+
+    fprintf(run.report, "source:     %s, %u records%s\n", options->replay_path, records,
+            status < 0 ? ", truncated" : "");
+    print_report(&run, &output);
+    free(input.latency.samples_us);
+    fclose(session);
+    return status < 0 ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    struct host_options options;
+    if (!parse_options(argc, argv, &options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    start_esc_bank(&options);
+    if (options.pipe) {
+        return run_pipe(&options);
+    }
+    return options.replay_path != NULL ? run_replay(&options) : run_load(&options);
+}
@@ -0,0 +1,286 @@
+/*
+ * Offline telemetry decoder replay.
+ *
+ * Re-runs the firmware's DShot telemetry decoder over raw captures streamed by
+ * the capture diagnostics (0xA7 packets, see src/dshot/capture_usb.h) and
+ * reports how many frames decode under the chosen decoder settings.
+ * The decoder is the firmware's own, built from src/dshot/dshot.c.
+ *
+ * Usage: telemetry_replay <capture.bin> [options]
+ *   --samples-per-bit <x>  Starting samples per bit (default: per capture format)
+ *   --thresholds <a,b,c>   Fixed run-length thresholds for 1/2/3-bit runs
+ *   --calibration <mode>   track (default, like the firmware) or none
+ *   --strict               Use strict thresholds before calibration completes
+ *   --glitch <n>           Merge runs shorter than n samples (default DSHOT_GLITCH_FILTER)
+ *   --repeat <n>           Decode the file n times for throughput timing
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+/* Include the implementation directly to access the static decoder */
+#include "../src/dshot/dshot.c"
+#include "../src/dshot/capture_usb.h"
+#include "usb_comm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REPLAY_MAX_MOTORS 256
+#define REPLAY_RESULT_COUNT (DECODE_FAIL_CRC + 1)
+
+struct replay_capture {
+    uint8_t motor_id;
+    uint8_t reason;
+    uint8_t format;
+    uint8_t word_count;
+    uint32_t timestamp_us;
+    uint32_t words[DSHOT_CAPTURE_MAX_WORDS];
+};
+
+struct replay_options {
+    const char *path;
+    uint16_t samples_per_bit_q8;
+    bool fixed_thresholds;
+    uint8_t thresholds[3];
+    bool tracking;
+    bool strict;
+    uint8_t glitch_filter;
+    int repeat;
+};
+
+struct replay_stats {
+    uint32_t frames;
+    uint32_t results[REPLAY_RESULT_COUNT];
+    uint32_t recovered;
+    uint32_t lost;
+    uint32_t edt;
+    uint32_t bad_type;
+};
+
+static const char *const result_names[REPLAY_RESULT_COUNT] = {
+    [DECODE_OK] = "ok",
+    [DECODE_FAIL_EDGE_COUNT] = "edge_count",
+    [DECODE_FAIL_BIT_COUNT] = "bit_count",
+    [DECODE_FAIL_GCR] = "bad_gcr",
+    [DECODE_FAIL_CRC] = "bad_crc",
+};
+
+static void usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s <capture.bin> [--samples-per-bit x] [--thresholds a,b,c]\n"
+            "       [--calibration track|none] [--strict] [--glitch n] [--repeat n]\n",
+            program);
+}
+
+static bool parse_options(int argc, char **argv, struct replay_options *options) {
+    memset(options, 0, sizeof(*options));
+    options->tracking = true;
+    options->glitch_filter = DSHOT_GLITCH_FILTER;
+    options->repeat = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--strict") == 0) {
+            options->strict = true;
+        } else if (arg[0] != '-') {
+            options->path = arg;
+        } else if (value == NULL) {
+            return false;
+        } else if (strcmp(arg, "--samples-per-bit") == 0) {
+            options->samples_per_bit_q8 = (uint16_t)(strtod(value, NULL) * 256.0 + 0.5);
+            i++;
+        } else if (strcmp(arg, "--thresholds") == 0) {
+            unsigned a, b, c;
+            if (sscanf(value, "%u,%u,%u", &a, &b, &c) != 3 || a > 255 || b > 255 || c > 255) {
+                return false;
+            }
+            options->fixed_thresholds = true;
+            options->thresholds[0] = (uint8_t)a;
+            options->thresholds[1] = (uint8_t)b;
+            options->thresholds[2] = (uint8_t)c;
+            i++;
+        } else if (strcmp(arg, "--calibration") == 0) {
+            if (strcmp(value, "track") != 0 && strcmp(value, "none") != 0) {
+                return false;
+            }
+            options->tracking = strcmp(value, "track") == 0;
+            i++;
+        } else if (strcmp(arg, "--glitch") == 0) {
+            options->glitch_filter = (uint8_t)atoi(value);
+            i++;
+        } else if (strcmp(arg, "--repeat") == 0) {
+            options->repeat = atoi(value) > 0 ? atoi(value) : 1;
+            i++;
+        } else {
+            return false;
+        }
+    }
+
+    return options->path != NULL;
+}
+
+/* Extract every valid capture packet from a raw serial dump; other traffic is skipped */
+static size_t load_captures(const char *path, struct replay_capture **out) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return 0;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = malloc(size > 0 ? (size_t)size : 1);
+    size_t len = fread(data, 1, size > 0 ? (size_t)size : 0, file);
+    fclose(file);
+
+    struct replay_capture *captures = malloc(((len / CAPTURE_HEADER_SIZE) + 1) * sizeof(*captures));
+    size_t count = 0;
+    size_t i = 0;
+
+    while (i + CAPTURE_HEADER_SIZE < len) {
+        uint8_t word_count = data[i + 8];
+        size_t packet_len = CAPTURE_HEADER_SIZE + ((size_t)word_count * 4) + 1;
+        if (data[i] != CAPTURE_START_BYTE || word_count == 0 ||
+            word_count > DSHOT_CAPTURE_MAX_WORDS || data[i + 3] >= DSHOT_RX_CAPTURE_COUNT ||
+            i + packet_len > len ||
+            usb_calculate_checksum(&data[i], packet_len - 1) != data[i + packet_len - 1]) {
+            i++;
+            continue;
+        }
+
+        struct replay_capture *capture = &captures[count++];
+        capture->motor_id = data[i + 1];
+        capture->reason = data[i + 2];
+        capture->format = data[i + 3];
+        memcpy(&capture->timestamp_us, &data[i + 4], sizeof(capture->timestamp_us));
+        capture->word_count = word_count;
+        memcpy(capture->words, &data[i + CAPTURE_HEADER_SIZE], (size_t)word_count * 4);
+        i += packet_len;
+    }
+
+    free(data);
+    *out = captures;
+    return count;
+}
+
+static void configure_calibration(struct dshot_rx_calibration *calibration,
+                                  enum dshot_rx_capture format,
+                                  const struct replay_options *options) {
+    reset_rx_calibration(calibration, format);
+    if (options->samples_per_bit_q8 != 0 || options->strict) {
+        uint16_t samples_per_bit_q8 = options->samples_per_bit_q8 != 0
+                                          ? options->samples_per_bit_q8
+                                          : calibration->samples_per_bit_q8;
+        set_length_transitions(calibration, samples_per_bit_q8, options->strict);
+    }
+    if (options->fixed_thresholds) {
+        calibration->length_transitions[1] = options->thresholds[0];
+        calibration->length_transitions[2] = options->thresholds[1];
+        calibration->length_transitions[3] = options->thresholds[2];
+    }
+    calibration->glitch_filter = options->glitch_filter;
+}
+
+static struct dshot_rx_calibration calibrations[REPLAY_MAX_MOTORS][DSHOT_RX_CAPTURE_COUNT];
+
+/* Decodes frames as the firmware does: EDT is always on (src/main.c) */
+static struct dshot_controller replay_controller = {.edt_always_decode = true};
+
+/* Start every motor from the configured calibration; not part of the timed decode */
+static void reset_calibrations(const struct replay_options *options) {
+    struct dshot_rx_calibration configured[DSHOT_RX_CAPTURE_COUNT];
+
+    for (int format = 0; format < DSHOT_RX_CAPTURE_COUNT; ++format) {
+        configure_calibration(&configured[format], (enum dshot_rx_capture)format, options);
+    }
+    for (int motor = 0; motor < REPLAY_MAX_MOTORS; ++motor) {
+        memcpy(calibrations[motor], configured, sizeof(configured));
+    }
+}
+
+static void replay_pass(const struct replay_capture *captures, size_t count,
+                        const struct replay_options *options, struct replay_stats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    for (size_t i = 0; i < count; ++i) {
+        const struct replay_capture *capture = &captures[i];
+        struct dshot_rx_calibration *calibration =
+            &calibrations[capture->motor_id][capture->format];
+        struct dshot_rx_calibration frozen = *calibration;
+        uint32_t frame = 0;
+
+        enum decode_result result = decode_oversampled_telemetry(
+            options->tracking ? calibration : &frozen, (enum dshot_rx_capture)capture->format,
+            capture->words, capture->word_count, &frame);
+
+        stats->frames++;
+        stats->results[result]++;
+        if (result == DECODE_OK && capture->reason != DSHOT_CAPTURE_REASON_OK) {
+            stats->recovered++;
+        } else if (result != DECODE_OK && capture->reason == DSHOT_CAPTURE_REASON_OK) {
+            stats->lost++;
+        }
+        if (result == DECODE_OK) {
+            enum dshot_telemetry_type type;
+            uint32_t decoded;
+            dshot_decode_telemetry_value(&replay_controller, (frame >> 4) & 0x0FFF, &decoded,
+                                         &type);
+            if (type != DSHOT_TELEMETRY_TYPE_ERPM) {
+                stats->edt++;
+            } else if (decoded == DSHOT_TELEMETRY_INVALID) {
+                stats->bad_type++;
+            }
+        }
+    }
+}
+
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) + ((double)(end->tv_nsec - start->tv_nsec) / 1e9);
+}
+
+int main(int argc, char **argv) {
+    struct replay_options options;
+    if (!parse_options(argc, argv, &options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    struct replay_capture *captures = NULL;
+    size_t count = load_captures(options.path, &captures);
+    if (count == 0) {
+        fprintf(stderr, "%s: no capture packets found\n", options.path);
+        free(captures);
+        return 1;
+    }
+
+    struct replay_stats stats;
+    double seconds = 0.0;
+    for (int pass = 0; pass < options.repeat; ++pass) {
+        struct timespec start;
+        struct timespec end;
+        reset_calibrations(&options);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        replay_pass(captures, count, &options, &stats);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        seconds += elapsed_seconds(&start, &end);
+    }
+
+    double frames_per_second = seconds > 0.0 ? (double)count * options.repeat / seconds : 0.0;
+
+    printf("captures: %zu\n", count);
+    for (int result = 0; result < REPLAY_RESULT_COUNT; ++result) {
+        printf("%-11s %8u  %6.2f%%\n", result_names[result], stats.results[result],
+               100.0 * stats.results[result] / stats.frames);
+    }
+    printf("recovered:  %8u  (failed on the MCU, decode now)\n", stats.recovered);
+    printf("lost:       %8u  (decoded on the MCU, fail now)\n", stats.lost);
+    printf("edt:        %8u  (extended telemetry frames)\n", stats.edt);
+    printf("bad_erpm:   %8u  (eRPM frame with zero period)\n", stats.bad_type);
+    printf("throughput: %.0f frames/s\n", frames_per_second);
+
+    free(captures);
+    return 0;
+}
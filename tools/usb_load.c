@@ -0,0 +1,726 @@
+/*
+ * USB link load generator.
+ *
+ * Streams command packets to the firmware at a fixed rate, optionally with
+ * corrupted packets and interleaved config packets, and reads its output
+ * back. The firmware's link stats packets (0xE5, src/usb_comm.h) give the
+ * packets it actually assembled and the checksum failures it saw. Their
+ * change over the run, compared with what was sent, shows the command rate
+ * the link sustains. They also carry the firmware's output byte count, the
+ * time it spent writing and the output it dropped while the link was full.
+ *
+ * The target is a serial device (the Pico's USB CDC port) or a command whose
+ * stdin/stdout is the link, such as the host firmware build:
+ *   usb_load --device /dev/ttyACM0 --rate-hz 2000
+ *   usb_load --exec "build/tools/firmware_host --pipe" --rate-hz 500
+ *
+ * All motors are commanded to --throttle (default neutral), so a real bank
+ * stays stopped unless asked otherwise.
+ *
+ * --link-protocol 2 asks for link protocol v2 (src/link/frame.h) before the
+ * run and sends every packet framed; corrupted frames then fail their CRC.
+ *
+ * --command-format packed|changed|delta chooses that command format in the
+ * config packet and sends every command after the first in it: CHANGED
+ * packets list every motor and DELTA packets carry no change.
+ *
+ * --trajectory-points n sends trajectory packets (src/trajectory.h) of n
+ * setpoints instead, spread over the period until the next packet and timed
+ * LOAD_TRAJECTORY_LEAD_US ahead on the MCU clock. The clock is estimated
+ * from the link stats packets.
+ *
+ * --ping-hz x sends clock sync pings (src/clock_sync.h) at that rate, each
+ * with the round trip of the one before if it was answered. The firmware
+ * then stamps its telemetry and logs in host time, and reports the round
+ * trips in its link stats.
+ *
+ * Before the run it queries the firmware's capabilities (src/runtime_config.h)
+ * and prints them; --speed 0 picks the fastest DShot speed the board supports.
+ *
+ * Usage: usb_load (--device path | --exec command) [--rate-hz n] [--duration-s x]
+ *                 [--corrupt-pct x] [--config-every n] [--speed n] [--throttle n]
+ *                 [--link-protocol 1|2] [--command-format full|packed|changed|delta]
+ *                 [--trajectory-points n] [--ping-hz x]
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "clock_sync.h"
+#include "dshot/control.h"
+#include "link/frame.h"
+#include "link/transport.h"
+#include "link/tx.h"
+#include "motors.h"
+#include "runtime_config.h"
+#include "trajectory.h"
+#include "usb_comm.h"
+#include "usb_output.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOAD_COMMAND_BUFFER_SIZE USB_COMMAND_BUFFER_SIZE(NUM_MOTORS)
+#define LOAD_RX_BUFFER_SIZE 65536
+#define LOAD_VERSION_TIMEOUT_MS 5000
+#define LOAD_LINK_STATS_TIMEOUT_MS 2500
+#define LOAD_CAPABILITY_TIMEOUT_MS 1000
+#define LOAD_TRAJECTORY_LEAD_US 10000
+/* Trajectory points for every motor that fit in one input packet */
+#define LOAD_TRAJECTORY_POINTS_MAX                                                                 \
+    ((USB_INPUT_PACKET_MAX - TRAJECTORY_HEADER_SIZE - 1) / (2 + (NUM_MOTORS * 2)))
+
+struct load_options {
+    const char *device;
+    const char *command;
+    double rate_hz;
+    double duration_s;
+    double corrupt_pct;
+    uint32_t config_every;
+    uint16_t speed;
+    uint16_t throttle;
+    uint8_t link_protocol;
+    usb_command_format_t command_format;
+    uint32_t trajectory_points;
+    double ping_hz;
+};
+
+/* Contents of a link stats packet */
+struct load_stats {
+    usb_link_stats_t input;
+    link_tx_stats_t tx;
+    uint32_t dropped[LINK_STREAM_COUNT];
+    uint32_t time_us;
+    trajectory_stats_t trajectory;
+    uint32_t rtt_min_us;
+    uint32_t rtt_mean_us;
+    uint32_t rtt_max_us;
+};
+
+struct load_link {
+    int read_fd;
+    int write_fd;
+    uint8_t buffer[LOAD_RX_BUFFER_SIZE];
+    size_t length;
+    struct usb_output_parser parser;
+    uint64_t bytes[USB_OUTPUT_KIND_COUNT];
+    uint32_t packets[USB_OUTPUT_KIND_COUNT];
+    uint32_t telemetry_values;
+    uint8_t link_protocol; /* As reported by the last version packet */
+    bool have_capabilities;
+    uint8_t capabilities[USB_CAPABILITY_PACKET_SIZE]; /* Last capability packet */
+    bool send_v2;
+    uint8_t send_sequence;
+    bool have_stats;
+    struct load_stats stats; /* Last link stats packet */
+    double stats_received_s; /* When it was read */
+    uint8_t ping_sequence;
+    uint32_t pongs;
+    uint32_t rtt_us; /* Round trip of the last pong, 0 before the first */
+    uint8_t rtt_sequence; /* Its ping's sequence number */
+};
+
+struct load_sent {
+    uint32_t commands;
+    uint32_t corrupted;
+    uint32_t configs;
+    uint32_t late; /* Send deadlines missed because the link blocked */
+    uint32_t pings;
+};
+
+static uint32_t rng_state = 0x9E3779B9u;
+
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double monotonic_s(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+static void usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s (--device path | --exec command) [--rate-hz n] [--duration-s x]\n"
+            "       [--corrupt-pct x] [--config-every n] [--speed n] [--throttle n]\n"
+            "       [--link-protocol 1|2] [--command-format full|packed|changed|delta]\n"
+            "       [--trajectory-points n] [--ping-hz x]\n",
+            program);
+}
+
+static const char *const command_format_names[USB_COMMAND_FORMAT_COUNT] = {
+    [USB_COMMAND_FORMAT_FULL] = "full",
+    [USB_COMMAND_FORMAT_PACKED] = "packed",
+    [USB_COMMAND_FORMAT_CHANGED] = "changed",
+    [USB_COMMAND_FORMAT_DELTA] = "delta",
+};
+
+static bool parse_command_format(const char *name, usb_command_format_t *format) {
+    for (int i = 0; i < USB_COMMAND_FORMAT_COUNT; ++i) {
+        if (strcmp(name, command_format_names[i]) == 0) {
+            *format = (usb_command_format_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_options(int argc, char **argv, struct load_options *options) {
+    memset(options, 0, sizeof(*options));
+    options->rate_hz = 1000.0;
+    options->duration_s = 5.0;
+    options->speed = 600;
+    options->throttle = CMD_THROTTLE_NEUTRAL;
+    options->link_protocol = LINK_PROTOCOL_V1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char *arg = argv[i];
+        const char *value = argv[i + 1];
+
+        if (strcmp(arg, "--device") == 0) {
+            options->device = value;
+        } else if (strcmp(arg, "--exec") == 0) {
+            options->command = value;
+        } else if (strcmp(arg, "--rate-hz") == 0) {
+            options->rate_hz = strtod(value, NULL);
+        } else if (strcmp(arg, "--duration-s") == 0) {
+            options->duration_s = strtod(value, NULL);
+        } else if (strcmp(arg, "--corrupt-pct") == 0) {
+            options->corrupt_pct = strtod(value, NULL);
+        } else if (strcmp(arg, "--config-every") == 0) {
+            options->config_every = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--speed") == 0) {
+            options->speed = (uint16_t)atoi(value);
+        } else if (strcmp(arg, "--throttle") == 0) {
+            options->throttle = (uint16_t)atoi(value);
+        } else if (strcmp(arg, "--link-protocol") == 0) {
+            options->link_protocol = (uint8_t)atoi(value);
+        } else if (strcmp(arg, "--command-format") == 0) {
+            if (!parse_command_format(value, &options->command_format)) {
+                return false;
+            }
+        } else if (strcmp(arg, "--trajectory-points") == 0) {
+            options->trajectory_points = (uint32_t)atoi(value);
+        } else if (strcmp(arg, "--ping-hz") == 0) {
+            options->ping_hz = strtod(value, NULL);
+        } else {
+            return false;
+        }
+    }
+
+    return argc % 2 == 1 && (options->device == NULL) != (options->command == NULL) &&
+           options->rate_hz > 0.0 && options->duration_s > 0.0 &&
+           (options->link_protocol == LINK_PROTOCOL_V1 ||
+            options->link_protocol == LINK_PROTOCOL_V2) &&
+           options->trajectory_points <= LOAD_TRAJECTORY_POINTS_MAX;
+}
+
+/* ---- Link ---- */
+
+static bool open_device(struct load_link *link, const char *path) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+
+    struct termios tty;
+    if (tcgetattr(fd, &tty) == 0) {
+        cfmakeraw(&tty);
+        tcsetattr(fd, TCSANOW, &tty);
+    }
+    link->read_fd = fd;
+    link->write_fd = fd;
+    return true;
+}
+
+static bool open_command(struct load_link *link, const char *command) {
+    int to_child[2];
+    int from_child[2];
+    if (pipe(to_child) != 0 || pipe(from_child) != 0) {
+        perror("pipe");
+        return false;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        dup2(to_child[0], STDIN_FILENO);
+        dup2(from_child[1], STDOUT_FILENO);
+        close(to_child[1]);
+        close(from_child[0]);
+        execl("/bin/sh", "sh", "-c", command, (char *)NULL);
+        _exit(127);
+    }
+
+    close(to_child[0]);
+    close(from_child[1]);
+    link->read_fd = from_child[0];
+    link->write_fd = to_child[1];
+    return true;
+}
+
+static void parse_link_stats(struct load_link *link, const uint8_t *packet) {
+    if (usb_calculate_checksum(packet, USB_LINK_STATS_PACKET_SIZE - 1) !=
+        packet[USB_LINK_STATS_PACKET_SIZE - 1]) {
+        return;
+    }
+    memcpy(&link->stats.input.command_packets, &packet[1], sizeof(uint32_t));
+    memcpy(&link->stats.input.config_packets, &packet[5], sizeof(uint32_t));
+    memcpy(&link->stats.input.checksum_errors, &packet[9], sizeof(uint32_t));
+    memcpy(&link->stats.input.bytes_discarded, &packet[13], sizeof(uint32_t));
+    memcpy(&link->stats.tx.bytes_written, &packet[17], sizeof(uint32_t));
+    memcpy(&link->stats.tx.write_time_us, &packet[21], sizeof(uint32_t));
+    memcpy(link->stats.dropped, &packet[25], sizeof(link->stats.dropped));
+    memcpy(&link->stats.input.sequence_gaps, &packet[41], sizeof(uint32_t));
+    memcpy(&link->stats.input.stale_commands, &packet[45], sizeof(uint32_t));
+    memcpy(&link->stats.time_us, &packet[49], sizeof(uint32_t));
+    memcpy(&link->stats.trajectory.points_late, &packet[53], sizeof(uint32_t));
+    memcpy(&link->stats.trajectory.points_dropped, &packet[57], sizeof(uint32_t));
+    memcpy(&link->stats.rtt_min_us, &packet[61], sizeof(uint32_t));
+    memcpy(&link->stats.rtt_mean_us, &packet[65], sizeof(uint32_t));
+    memcpy(&link->stats.rtt_max_us, &packet[69], sizeof(uint32_t));
+    link->stats_received_s = monotonic_s();
+    link->have_stats = true;
+}
+
+static uint32_t host_time_us(void) {
+    return (uint32_t)(uint64_t)(monotonic_s() * 1e6);
+}
+
+/* Round trip of a pong, less the time the firmware held the ping */
+static void parse_pong(struct load_link *link, const uint8_t *packet) {
+    uint32_t times_us[3]; /* Host send, MCU receive, MCU send */
+    if (usb_calculate_checksum(packet, CLOCK_SYNC_PONG_PACKET_SIZE - 1) !=
+        packet[CLOCK_SYNC_PONG_PACKET_SIZE - 1]) {
+        return;
+    }
+    memcpy(times_us, &packet[2], sizeof(times_us));
+    link->rtt_us = host_time_us() - times_us[0] - (times_us[2] - times_us[1]);
+    link->rtt_sequence = packet[1];
+    link->pongs++;
+}
+
+/* Read what the firmware sent, waiting up to timeout_ms for the first bytes */
+static void receive(struct load_link *link, int timeout_ms) {
+    struct pollfd pfd = {.fd = link->read_fd, .events = POLLIN};
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return;
+    }
+
+    ssize_t count =
+        read(link->read_fd, link->buffer + link->length, sizeof(link->buffer) - link->length);
+    if (count <= 0) {
+        return;
+    }
+    link->length += (size_t)count;
+
+    size_t offset = 0;
+    while (offset < link->length) {
+        enum usb_output_kind kind;
+        const uint8_t *packet;
+        size_t packet_len;
+        size_t length = usb_output_next_packet(&link->parser, link->buffer + offset,
+                                               link->length - offset, &packet, &packet_len, &kind);
+        if (length == 0) {
+            break;
+        }
+        link->bytes[kind] += length;
+        link->packets[kind]++;
+        if (packet_len > 0) {
+            link->telemetry_values += usb_output_telemetry_values(packet);
+        }
+        if (kind == USB_OUTPUT_LINK_STATS && packet_len == USB_LINK_STATS_PACKET_SIZE) {
+            parse_link_stats(link, packet);
+        }
+        if (kind == USB_OUTPUT_CLOCK_SYNC && packet_len == CLOCK_SYNC_PONG_PACKET_SIZE) {
+            parse_pong(link, packet);
+        }
+        if (kind == USB_OUTPUT_CAPABILITY && packet_len == USB_CAPABILITY_PACKET_SIZE &&
+            usb_calculate_checksum(packet, packet_len - 1) == packet[packet_len - 1]) {
+            memcpy(link->capabilities, packet, packet_len);
+            link->have_capabilities = true;
+        }
+        if (kind == USB_OUTPUT_VERSION) {
+            link->link_protocol =
+                packet_len == USB_VERSION_V2_PACKET_SIZE ? packet[7] : LINK_PROTOCOL_V1;
+        }
+        offset += length;
+    }
+    memmove(link->buffer, link->buffer + offset, link->length - offset);
+    link->length -= offset;
+}
+
+static void send_bytes(struct load_link *link, const uint8_t *data, size_t length) {
+    while (length > 0) {
+        ssize_t count = write(link->write_fd, data, length);
+        if (count < 0 && errno != EINTR) {
+            perror("write");
+            exit(1);
+        }
+        if (count > 0) {
+            data += count;
+            length -= (size_t)count;
+        }
+    }
+}
+
+/* Wait until a packet of `kind` arrives; returns false after timeout_ms */
+static bool wait_for(struct load_link *link, enum usb_output_kind kind, int timeout_ms) {
+    uint32_t start_count = link->packets[kind];
+    double deadline = monotonic_s() + (timeout_ms / 1e3);
+    while (link->packets[kind] == start_count && monotonic_s() < deadline) {
+        receive(link, 10);
+    }
+    return link->packets[kind] != start_count;
+}
+
+/* ---- Packets ---- */
+
+/*
+ * Send a v1 packet, framed in v2 if negotiated. A corrupted packet has one bit
+ * flipped after its start byte in v1, or anywhere before the delimiter in v2;
+ * either always breaks the checksum.
+ */
+static void send_packet(struct load_link *link, uint8_t *packet, size_t len, bool corrupt) {
+    uint8_t frame[LINK_FRAME_MAX_SIZE(USB_INPUT_PACKET_MAX)];
+    uint8_t *data = packet;
+    size_t data_len = len;
+    size_t first = 1;
+    if (link->send_v2) {
+        data = frame;
+        data_len = link_frame_encode(link->send_sequence++, packet, len - 1, frame);
+        first = 0;
+    }
+
+    if (corrupt) {
+        uint32_t bit = next_random() % ((uint32_t)(data_len - first - 1) * 8);
+        data[first + (bit / 8)] ^= (uint8_t)(1u << (bit % 8));
+    }
+    send_bytes(link, data, data_len);
+}
+
+static void send_config(struct load_link *link, uint16_t speed, usb_command_format_t format) {
+    uint8_t packet[USB_CONFIG_PACKET_SIZE] = {USB_CONFIG_START_BYTE,
+                                              (uint8_t)(THRUSTER_PROTOCOL_DSHOT | (format << 4)),
+                                              (uint8_t)(speed & 0xFF), (uint8_t)(speed >> 8)};
+    packet[USB_CONFIG_PACKET_SIZE - 1] = usb_calculate_checksum(packet, USB_CONFIG_PACKET_SIZE - 1);
+    send_packet(link, packet, sizeof(packet), false);
+}
+
+/* Always sent as v1; the firmware switches after reading it */
+static void send_link_protocol(struct load_link *link, uint8_t version) {
+    uint8_t packet[USB_LINK_PROTOCOL_PACKET_SIZE] = {USB_LINK_PROTOCOL_START_BYTE, version};
+    packet[USB_LINK_PROTOCOL_PACKET_SIZE - 1] =
+        usb_calculate_checksum(packet, USB_LINK_PROTOCOL_PACKET_SIZE - 1);
+    send_bytes(link, packet, sizeof(packet));
+}
+
+/* Ask for the capability packet without changing any feature */
+static void send_capability_query(struct load_link *link) {
+    uint8_t packet[USB_CAPABILITY_QUERY_PACKET_SIZE] = {USB_CAPABILITY_QUERY_START_BYTE, 0};
+    packet[USB_CAPABILITY_QUERY_PACKET_SIZE - 1] =
+        usb_calculate_checksum(packet, USB_CAPABILITY_QUERY_PACKET_SIZE - 1);
+    send_packet(link, packet, sizeof(packet), false);
+}
+
+/* Print the capability packet; returns the fastest DShot speed it lists */
+static uint16_t print_capabilities(const uint8_t *packet) {
+    static const uint16_t speeds[] = MCU_DSHOT_SPEEDS;
+    uint32_t capabilities;
+    uint32_t features;
+    uint16_t fastest = 0;
+
+    memcpy(&capabilities, &packet[1], sizeof(capabilities));
+    memcpy(&features, &packet[5], sizeof(features));
+    printf("capability: %u motors, DShot", packet[9]);
+    for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); ++i) {
+        if ((packet[10] >> i) & 1) {
+            printf(" %u", speeds[i]);
+            fastest = speeds[i];
+        }
+    }
+    printf(", flags 0x%08X, features 0x%08X, link protocols 0x%02X\n", capabilities, features,
+           packet[13]);
+    return fastest;
+}
+
+/* Every motor set to throttle, in the format's layout (src/usb_comm.h); returns the size */
+static size_t build_command(uint8_t *packet, usb_command_format_t format, uint16_t throttle) {
+    size_t len = 1;
+    switch (format) {
+    case USB_COMMAND_FORMAT_PACKED:
+        packet[0] = USB_INPUT_PACKED_START_BYTE;
+        for (int i = 0; i < NUM_MOTORS; i += 2) {
+            uint32_t pair = throttle & USB_COMMAND_VALUE_MAX;
+            if (i + 1 < NUM_MOTORS) {
+                pair |= (uint32_t)(throttle & USB_COMMAND_VALUE_MAX) << 12;
+            }
+            packet[len++] = (uint8_t)pair;
+            packet[len++] = (uint8_t)(pair >> 8);
+            if (i + 1 < NUM_MOTORS) {
+                packet[len++] = (uint8_t)(pair >> 16);
+            }
+        }
+        break;
+    case USB_COMMAND_FORMAT_CHANGED:
+        packet[0] = USB_INPUT_CHANGED_START_BYTE;
+        memset(&packet[1], 0, USB_INPUT_MASK_SIZE(NUM_MOTORS));
+        for (int i = 0; i < NUM_MOTORS; ++i) {
+            packet[1 + (i / 8)] |= (uint8_t)(1u << (i % 8));
+        }
+        len += USB_INPUT_MASK_SIZE(NUM_MOTORS);
+        break;
+    case USB_COMMAND_FORMAT_DELTA:
+        packet[0] = USB_INPUT_DELTA_START_BYTE;
+        memset(&packet[1], 0, NUM_MOTORS);
+        len += NUM_MOTORS;
+        break;
+    default:
+        packet[0] = USB_INPUT_START_BYTE;
+        break;
+    }
+    if (format == USB_COMMAND_FORMAT_FULL || format == USB_COMMAND_FORMAT_CHANGED) {
+        for (int i = 0; i < NUM_MOTORS; ++i) {
+            packet[len++] = (uint8_t)(throttle & 0xFF);
+            packet[len++] = (uint8_t)(throttle >> 8);
+        }
+    }
+    packet[len] = usb_calculate_checksum(packet, len);
+    return len + 1;
+}
+
+static bool send_command(struct load_link *link, usb_command_format_t format, uint16_t throttle,
+                         double corrupt_pct) {
+    uint8_t packet[LOAD_COMMAND_BUFFER_SIZE];
+    size_t len = build_command(packet, format, throttle);
+
+    bool corrupt = (next_random() % 1000000u) < (uint32_t)(corrupt_pct * 10000.0);
+    send_packet(link, packet, len, corrupt);
+    return corrupt;
+}
+
+static void send_ping(struct load_link *link) {
+    uint8_t packet[CLOCK_SYNC_PING_PACKET_SIZE] = {CLOCK_SYNC_PING_START_BYTE,
+                                                   link->ping_sequence++};
+    uint32_t host_us = host_time_us();
+    /* Only the previous ping's round trip is usable; 0 if its pong has not come back */
+    bool answered = link->pongs > 0 && link->rtt_sequence == (uint8_t)(packet[1] - 1);
+    uint32_t rtt_us = answered ? link->rtt_us : 0;
+    memcpy(&packet[2], &host_us, sizeof(host_us));
+    memcpy(&packet[6], &rtt_us, sizeof(rtt_us));
+    packet[CLOCK_SYNC_PING_PACKET_SIZE - 1] =
+        usb_calculate_checksum(packet, CLOCK_SYNC_PING_PACKET_SIZE - 1);
+    send_packet(link, packet, sizeof(packet), false);
+}
+
+/* The MCU clock now, from the last link stats packet; the link's latency makes it run late */
+static uint32_t mcu_time_us(const struct load_link *link) {
+    return link->stats.time_us + (uint32_t)((monotonic_s() - link->stats_received_s) * 1e6);
+}
+
+/* Every motor at throttle, points spread evenly over period_s */
+static bool send_trajectory(struct load_link *link, const struct load_options *options,
+                            double period_s) {
+    uint8_t packet[USB_INPUT_PACKET_MAX];
+    uint32_t count = options->trajectory_points;
+    uint32_t start_us = mcu_time_us(link) + LOAD_TRAJECTORY_LEAD_US;
+
+    packet[0] = TRAJECTORY_START_BYTE;
+    packet[1] = (uint8_t)((1u << NUM_MOTORS) - 1);
+    packet[2] = (uint8_t)count;
+    memcpy(&packet[3], &start_us, sizeof(start_us));
+    size_t len = TRAJECTORY_HEADER_SIZE;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint16_t offset_us = (uint16_t)(i * period_s * 1e6 / count);
+        packet[len++] = (uint8_t)(offset_us & 0xFF);
+        packet[len++] = (uint8_t)(offset_us >> 8);
+        for (int motor = 0; motor < NUM_MOTORS; ++motor) {
+            packet[len++] = (uint8_t)(options->throttle & 0xFF);
+            packet[len++] = (uint8_t)(options->throttle >> 8);
+        }
+    }
+    packet[len] = usb_calculate_checksum(packet, len);
+
+    bool corrupt = (next_random() % 1000000u) < (uint32_t)(options->corrupt_pct * 10000.0);
+    send_packet(link, packet, len + 1, corrupt);
+    return corrupt;
+}
+
+static void stream(struct load_link *link, const struct load_options *options,
+                   struct load_sent *sent) {
+    double period_s = 1.0 / options->rate_hz;
+    double start_s = monotonic_s();
+    double next_s = start_s;
+    double next_ping_s = start_s;
+    uint32_t total = (uint32_t)(options->duration_s * options->rate_hz);
+
+    memset(sent, 0, sizeof(*sent));
+    while (sent->commands < total) {
+        double now_s = monotonic_s();
+        if (now_s < next_s) {
+            receive(link, (int)((next_s - now_s) * 1e3));
+            continue;
+        }
+        if (now_s - next_s > period_s) {
+            sent->late++;
+        }
+
+        if (options->trajectory_points > 0) {
+            sent->corrupted += send_trajectory(link, options, period_s);
+        } else {
+            /* CHANGED and DELTA need values to build on */
+            usb_command_format_t format =
+                sent->commands == 0 ? USB_COMMAND_FORMAT_FULL : options->command_format;
+            sent->corrupted +=
+                send_command(link, format, options->throttle, options->corrupt_pct);
+        }
+        sent->commands++;
+        if (options->config_every > 0 && sent->commands % options->config_every == 0) {
+            send_config(link, options->speed, options->command_format);
+            sent->configs++;
+        }
+        if (options->ping_hz > 0 && now_s >= next_ping_s) {
+            send_ping(link);
+            sent->pings++;
+            next_ping_s += 1.0 / options->ping_hz;
+        }
+        next_s += period_s;
+        receive(link, 0);
+    }
+}
+
+static void print_report(const struct load_options *options, const struct load_link *link,
+                         const struct load_sent *sent, const struct load_stats *before,
+                         double seconds) {
+    printf("sent:       %u commands (%.0f/s, %u late), %u corrupted, %u configs\n",
+           sent->commands, sent->commands / seconds, sent->late, sent->corrupted, sent->configs);
+
+    if (link->have_stats) {
+        const usb_link_stats_t *input = &link->stats.input;
+        uint32_t accepted = input->command_packets - before->input.command_packets;
+        uint32_t bad = input->checksum_errors - before->input.checksum_errors;
+        uint32_t configs = input->config_packets - before->input.config_packets;
+        /* A damaged packet can fail more than once while the scan resyncs, so loss is
+         * counted over the intact packets sent */
+        uint32_t expected = sent->commands - sent->corrupted + sent->configs + sent->pings;
+        printf("accepted:   %u commands (%.0f/s of %.0f/s requested), %u configs\n", accepted,
+               accepted / seconds, options->rate_hz, configs);
+        printf("stale:      %u commands replaced by a newer one before use\n",
+               input->stale_commands - before->input.stale_commands);
+        printf("rejected:   %u checksum errors, %u bytes discarded, %u sequence gaps\n", bad,
+               input->bytes_discarded - before->input.bytes_discarded,
+               input->sequence_gaps - before->input.sequence_gaps);
+        printf("lost:       %d intact packets never accepted by usb_poll_multi()\n",
+               (int)(expected - accepted - configs));
+        if (options->trajectory_points > 0) {
+            const trajectory_stats_t *trajectory = &link->stats.trajectory;
+            printf("trajectory: %u points late, %u dropped (queue full)\n",
+                   trajectory->points_late - before->trajectory.points_late,
+                   trajectory->points_dropped - before->trajectory.points_dropped);
+        }
+        if (options->ping_hz > 0) {
+            printf("ping:       %u sent, %u answered, round trip %u/%u/%u us min/mean/max\n",
+                   sent->pings, link->pongs, link->stats.rtt_min_us, link->stats.rtt_mean_us,
+                   link->stats.rtt_max_us);
+        }
+        uint32_t tx_bytes = link->stats.tx.bytes_written - before->tx.bytes_written;
+        uint32_t tx_time_us = link->stats.tx.write_time_us - before->tx.write_time_us;
+        printf("written:    %.0f B/s by the firmware, %.1f%% of its time in the write path\n",
+               tx_bytes / seconds, tx_time_us / (seconds * 1e4));
+        const uint32_t *dropped = link->stats.dropped;
+        printf("dropped:    %u control, %u log, %u telemetry values, %u capture (link full)\n",
+               dropped[LINK_STREAM_CONTROL] - before->dropped[LINK_STREAM_CONTROL],
+               dropped[LINK_STREAM_LOG] - before->dropped[LINK_STREAM_LOG],
+               dropped[LINK_STREAM_TELEMETRY] - before->dropped[LINK_STREAM_TELEMETRY],
+               dropped[LINK_STREAM_CAPTURE] - before->dropped[LINK_STREAM_CAPTURE]);
+    } else {
+        printf("accepted:   unknown, no link stats packet from the firmware\n");
+    }
+
+    printf("received:   %.0f telemetry values/s\n", link->telemetry_values / seconds);
+    for (int kind = 0; kind < USB_OUTPUT_KIND_COUNT; ++kind) {
+        printf("  %-10s %8.0f B/s  %7.1f packets/s\n", usb_output_kind_names[kind],
+               link->bytes[kind] / seconds, link->packets[kind] / seconds);
+    }
+}
+
+int main(int argc, char **argv) {
+    static struct load_link link;
+    struct load_options options;
+    if (!parse_options(argc, argv, &options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    bool opened = options.device != NULL ? open_device(&link, options.device)
+                                          : open_command(&link, options.command);
+    if (!opened) {
+        return 1;
+    }
+
+    if (options.link_protocol == LINK_PROTOCOL_V2) {
+        send_link_protocol(&link, LINK_PROTOCOL_V2);
+        if (!wait_for(&link, USB_OUTPUT_VERSION, LOAD_VERSION_TIMEOUT_MS) ||
+            link.link_protocol != LINK_PROTOCOL_V2) {
+            fprintf(stderr, "usb_load: the firmware did not switch to link protocol v2\n");
+            return 1;
+        }
+        link.send_v2 = true;
+    }
+
+    send_capability_query(&link);
+    if (wait_for(&link, USB_OUTPUT_CAPABILITY, LOAD_CAPABILITY_TIMEOUT_MS)) {
+        uint16_t fastest = print_capabilities(link.capabilities);
+        if (options.speed == 0) {
+            options.speed = fastest;
+        }
+    }
+    if (options.speed == 0) {
+        fprintf(stderr, "usb_load: no capability packet to pick the speed from\n");
+        return 1;
+    }
+
+    send_config(&link, options.speed, options.command_format);
+    if (!wait_for(&link, USB_OUTPUT_VERSION, LOAD_VERSION_TIMEOUT_MS)) {
+        fprintf(stderr, "usb_load: no version packet after the runtime config\n");
+        return 1;
+    }
+    wait_for(&link, USB_OUTPUT_LINK_STATS, LOAD_LINK_STATS_TIMEOUT_MS);
+    struct load_stats before = link.stats;
+    bool had_stats = link.have_stats;
+    if (options.trajectory_points > 0 && !had_stats) {
+        fprintf(stderr, "usb_load: no link stats packet to time the trajectories by\n");
+        return 1;
+    }
+
+    memset(link.bytes, 0, sizeof(link.bytes));
+    memset(link.packets, 0, sizeof(link.packets));
+    link.telemetry_values = 0;
+    link.pongs = 0;
+
+    struct load_sent sent;
+    double start_s = monotonic_s();
+    stream(&link, &options, &sent);
+    double seconds = monotonic_s() - start_s;
+
+    /* The first stats packet may be sent before the firmware has read the last commands */
+    wait_for(&link, USB_OUTPUT_LINK_STATS, LOAD_LINK_STATS_TIMEOUT_MS);
+    wait_for(&link, USB_OUTPUT_LINK_STATS, LOAD_LINK_STATS_TIMEOUT_MS);
+    link.have_stats = had_stats && link.have_stats;
+    print_report(&options, &link, &sent, &before, seconds);
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "usb_output.h"
+#include "clock_sync.h"
+#include "dshot/capture_usb.h"
+#include "dshot/telemetry_usb.h"
+#include "link/frame.h"
+#include "log.h"
+#include "runtime_config.h"
+#include "usb_comm.h"
+#include <stdbool.h>
+#include <string.h>
+
+const char *const usb_output_kind_names[USB_OUTPUT_KIND_COUNT] = {
+    [USB_OUTPUT_TELEMETRY] = "telemetry",
+    [USB_OUTPUT_CAPTURE] = "capture",
+    [USB_OUTPUT_LOG] = "log",
+    [USB_OUTPUT_VERSION] = "version",
+    [USB_OUTPUT_LINK_STATS] = "link_stats",
+    [USB_OUTPUT_CLOCK_SYNC] = "clock_sync",
+    [USB_OUTPUT_CAPABILITY] = "capability",
+    [USB_OUTPUT_OTHER] = "other",
+};
+
+size_t usb_output_packet_length(const uint8_t *data, size_t length, enum usb_output_kind *kind) {
+    size_t needed;
+
+    switch (data[0]) {
+    case TELEMETRY_START_BYTE:
+        *kind = USB_OUTPUT_TELEMETRY;
+        needed = TELEMETRY_PACKET_SIZE;
+        break;
+    case TELEMETRY_BATCH_START_BYTE:
+        *kind = USB_OUTPUT_TELEMETRY;
+        needed = length < 2 ? SIZE_MAX : 2 + ((size_t)data[1] * TELEMETRY_BATCH_ENTRY_SIZE) + 1;
+        break;
+    case TELEMETRY_TIMED_BATCH_START_BYTE:
+        *kind = USB_OUTPUT_TELEMETRY;
+        needed = length < 2 ? SIZE_MAX
+                            : TELEMETRY_TIMED_BATCH_HEADER_SIZE +
+                                  ((size_t)data[1] * TELEMETRY_TIMED_BATCH_ENTRY_SIZE) + 1;
+        break;
+    case CAPTURE_START_BYTE:
+        *kind = USB_OUTPUT_CAPTURE;
+        needed = length < CAPTURE_HEADER_SIZE
+                     ? SIZE_MAX
+                     : CAPTURE_HEADER_SIZE + ((size_t)data[CAPTURE_HEADER_SIZE - 1] * 4) + 1;
+        break;
+    case LOG_START_BYTE:
+        *kind = USB_OUTPUT_LOG;
+        needed = length < 3 ? SIZE_MAX : 3 + (size_t)data[2] + 1;
+        break;
+    case LOG_TIMED_START_BYTE:
+        *kind = USB_OUTPUT_LOG;
+        needed = length < 3 ? SIZE_MAX : 7 + (size_t)data[2] + 1;
+        break;
+    case USB_VERSION_START_BYTE:
+        *kind = USB_OUTPUT_VERSION;
+        needed = USB_VERSION_PACKET_SIZE;
+        break;
+    case USB_LINK_STATS_START_BYTE:
+        *kind = USB_OUTPUT_LINK_STATS;
+        needed = USB_LINK_STATS_PACKET_SIZE;
+        break;
+    case CLOCK_SYNC_PONG_START_BYTE:
+        *kind = USB_OUTPUT_CLOCK_SYNC;
+        needed = CLOCK_SYNC_PONG_PACKET_SIZE;
+        break;
+    case USB_CAPABILITY_START_BYTE:
+        *kind = USB_OUTPUT_CAPABILITY;
+        needed = USB_CAPABILITY_PACKET_SIZE;
+        break;
+    default:
+        *kind = USB_OUTPUT_OTHER;
+        needed = 1;
+        break;
+    }
+    return needed <= length ? needed : 0;
+}
+
+static size_t next_v1_packet(const uint8_t *data, size_t length, const uint8_t **packet,
+                             size_t *packet_len, enum usb_output_kind *kind) {
+    size_t needed = usb_output_packet_length(data, length, kind);
+    *packet = data;
+    *packet_len = needed;
+    return needed;
+}
+
+/* Whether a known v1 packet starts at data: 1 if complete with a valid XOR, -1 if incomplete */
+static int v1_packet_at(const uint8_t *data, size_t length) {
+    enum usb_output_kind kind;
+    size_t needed = usb_output_packet_length(data, length, &kind);
+    if (kind == USB_OUTPUT_OTHER) {
+        return 0;
+    }
+    if (needed == 0) {
+        return -1;
+    }
+    return usb_calculate_checksum(data, needed - 1) == data[needed - 1];
+}
+
+size_t usb_output_next_packet(struct usb_output_parser *parser, const uint8_t *data,
+                              size_t length, const uint8_t **packet, size_t *packet_len,
+                              enum usb_output_kind *kind) {
+    if (!parser->v2) {
+        if (data[0] != LINK_FRAME_DELIMITER) {
+            return next_v1_packet(data, length, packet, packet_len, kind);
+        }
+        parser->v2 = true;
+        *packet = data;
+        *packet_len = 0;
+        *kind = USB_OUTPUT_OTHER;
+        return 1;
+    }
+
+    size_t frame_len = 0;
+    while (frame_len < length && frame_len <= USB_OUTPUT_FRAME_MAX &&
+           data[frame_len] != LINK_FRAME_DELIMITER) {
+        frame_len++;
+    }
+    if (frame_len == length) {
+        return 0;
+    }
+
+    uint8_t seq;
+    size_t decoded_len = 0;
+    if (frame_len <= USB_OUTPUT_FRAME_MAX && frame_len > 0 &&
+        link_frame_decode(data, frame_len, &seq, parser->packet, &decoded_len) &&
+        decoded_len > 0 && decoded_len < sizeof(parser->packet)) {
+        parser->packet[decoded_len] = usb_calculate_checksum(parser->packet, decoded_len);
+        usb_output_packet_length(parser->packet, decoded_len + 1, kind);
+        *packet = parser->packet;
+        *packet_len = decoded_len + 1;
+        return frame_len + 1;
+    }
+
+    int v1 = frame_len > 0 ? v1_packet_at(data, length) : 0;
+    if (v1 < 0) {
+        return 0;
+    }
+    if (v1 > 0) {
+        parser->v2 = false;
+        return next_v1_packet(data, length, packet, packet_len, kind);
+    }
+    *packet = data;
+    *packet_len = 0;
+    *kind = USB_OUTPUT_OTHER;
+    return frame_len <= USB_OUTPUT_FRAME_MAX ? frame_len + 1 : frame_len;
+}
+
+uint32_t usb_output_telemetry_values(const uint8_t *packet) {
+    if (packet[0] == TELEMETRY_BATCH_START_BYTE || packet[0] == TELEMETRY_TIMED_BATCH_START_BYTE) {
+        return packet[1];
+    }
+    return packet[0] == TELEMETRY_START_BYTE ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * Splits the firmware's USB output stream into packets by start byte, for
+ * host tools that measure or decode it. Packet formats are defined with the
+ * code that sends them: telemetry (src/dshot/telemetry_usb.h), captures
+ * (src/dshot/capture_usb.h), logs (src/log.h), version and capabilities
+ * (src/runtime_config.h), link stats (src/usb_comm.h) and clock sync pongs
+ * (src/clock_sync.h).
+ *
+ * In link protocol v2 the same packets arrive framed (src/link/frame.h);
+ * usb_output_next_packet() follows the switch and returns them as v1 packets.
+ */
+
+#ifndef TOOLS_USB_OUTPUT_H
+#define TOOLS_USB_OUTPUT_H
+
+#include "link/frame.h"
+#include "link/tx.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Longest v2 frame, delimiter excluded */
+#define USB_OUTPUT_FRAME_MAX (LINK_FRAME_MAX_SIZE(LINK_TX_PACKET_MAX_SIZE - 1) - 1)
+
+enum usb_output_kind {
+    USB_OUTPUT_TELEMETRY,
+    USB_OUTPUT_CAPTURE,
+    USB_OUTPUT_LOG,
+    USB_OUTPUT_VERSION,
+    USB_OUTPUT_LINK_STATS,
+    USB_OUTPUT_CLOCK_SYNC,
+    USB_OUTPUT_CAPABILITY,
+    USB_OUTPUT_OTHER, /* A byte that starts no known packet */
+    USB_OUTPUT_KIND_COUNT,
+};
+
+extern const char *const usb_output_kind_names[USB_OUTPUT_KIND_COUNT];
+
+/* Length of the complete packet at `data`, or 0 if more bytes are needed */
+size_t usb_output_packet_length(const uint8_t *data, size_t length, enum usb_output_kind *kind);
+
+/* Link protocol state of one output stream; zeroed, it starts in v1 */
+struct usb_output_parser {
+    bool v2;
+    uint8_t packet[LINK_TX_PACKET_MAX_SIZE]; /* Last decoded v2 packet */
+};
+
+/*
+ * Take the next packet from `data`: *packet points at it in v1 layout, XOR
+ * byte included, and *packet_len is 0 for bytes that carry no packet. Returns
+ * the wire bytes consumed, or 0 if more are needed.
+ *
+ * A 0x00 byte outside a v1 packet starts v2. A v2 frame that does not decode
+ * is skipped as USB_OUTPUT_OTHER, unless a valid v1 packet starts there: then
+ * the firmware has gone back to v1, and so does the parser.
+ */
+size_t usb_output_next_packet(struct usb_output_parser *parser, const uint8_t *data,
+                              size_t length, const uint8_t **packet, size_t *packet_len,
+                              enum usb_output_kind *kind);
+
+/* Telemetry values carried by a complete telemetry packet */
+uint32_t usb_output_telemetry_values(const uint8_t *packet);
+
+#endif
@@ -0,0 +1,58 @@
+#include "usb_session.h"
+#include <string.h>
+
+bool usb_session_write_header(FILE *file) {
+    uint8_t header[USB_SESSION_HEADER_SIZE] = {0};
+    memcpy(header, USB_SESSION_MAGIC, 4);
+    header[4] = USB_SESSION_VERSION;
+    return fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+bool usb_session_write_record(FILE *file, uint64_t timestamp_us, const uint8_t *data,
+                              size_t length) {
+    while (length > 0) {
+        size_t chunk = length < USB_SESSION_MAX_RECORD ? length : USB_SESSION_MAX_RECORD;
+        uint8_t header[USB_SESSION_RECORD_HEADER_SIZE];
+        for (int i = 0; i < 8; ++i) {
+            header[i] = (uint8_t)(timestamp_us >> (8 * i));
+        }
+        header[8] = (uint8_t)(chunk & 0xFF);
+        header[9] = (uint8_t)(chunk >> 8);
+
+        if (fwrite(header, 1, sizeof(header), file) != sizeof(header) ||
+            fwrite(data, 1, chunk, file) != chunk) {
+            return false;
+        }
+        data += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+bool usb_session_read_header(FILE *file) {
+    uint8_t header[USB_SESSION_HEADER_SIZE];
+    return fread(header, 1, sizeof(header), file) == sizeof(header) &&
+           memcmp(header, USB_SESSION_MAGIC, 4) == 0 && header[4] == USB_SESSION_VERSION;
+}
+
+int usb_session_read_record(FILE *file, struct usb_session_record *record) {
+    uint8_t header[USB_SESSION_RECORD_HEADER_SIZE];
+    size_t count = fread(header, 1, sizeof(header), file);
+    if (count == 0) {
+        return 0;
+    }
+    if (count != sizeof(header)) {
+        return -1;
+    }
+
+    record->timestamp_us = 0;
+    for (int i = 0; i < 8; ++i) {
+        record->timestamp_us |= (uint64_t)header[i] << (8 * i);
+    }
+    record->length = (uint16_t)(header[8] | (header[9] << 8));
+    if (record->length > USB_SESSION_MAX_RECORD ||
+        fread(record->data, 1, record->length, file) != record->length) {
+        return -1;
+    }
+    return 1;
+}
@@ -0,0 +1,45 @@
+/*
+ * Recorded host-to-MCU USB sessions.
+ *
+ * A session file holds the byte stream the host sent to the firmware
+ * (0x5A command packets, 0xC5 config packets and anything else on the link),
+ * as timestamped chunks in arrival order, so it can be replayed into the
+ * host-built firmware (tools/firmware_host.c --replay).
+ *
+ * File format, little-endian:
+ *   header: "USBS" [version] [reserved x3]
+ *   record: [timestamp_us: u64] [length: u16] [data: length bytes]
+ * Timestamps are microseconds from the start of the recording and never
+ * decrease.
+ */
+
+#ifndef TOOLS_USB_SESSION_H
+#define TOOLS_USB_SESSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define USB_SESSION_MAGIC "USBS"
+#define USB_SESSION_VERSION 1
+#define USB_SESSION_HEADER_SIZE 8
+#define USB_SESSION_RECORD_HEADER_SIZE 10
+#define USB_SESSION_MAX_RECORD 4096
+
+struct usb_session_record {
+    uint64_t timestamp_us;
+    uint16_t length;
+    uint8_t data[USB_SESSION_MAX_RECORD];
+};
+
+bool usb_session_write_header(FILE *file);
+/* Chunks longer than USB_SESSION_MAX_RECORD are split into several records */
+bool usb_session_write_record(FILE *file, uint64_t timestamp_us, const uint8_t *data,
+                              size_t length);
+
+bool usb_session_read_header(FILE *file);
+/* Returns 1 for a record, 0 at the end of the file, -1 for a truncated or bad record */
+int usb_session_read_record(FILE *file, struct usb_session_record *record);
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Records the host-to-MCU byte stream of a live USB session.
+ *
+ * Copies stdin to stdout unchanged and writes every chunk read, timestamped
+ * against CLOCK_MONOTONIC, to a session file (tools/usb_session.h). Put it
+ * between the host stack and the device, for example behind a pty:
+ *   socat PTY,link=/tmp/thrusters,raw,echo=0 \
+ *       SYSTEM:"build/tools/usb_session_record session.bin | socat - /dev/ttyACM0,raw"
+ * and point the host stack at /tmp/thrusters. Replay the file with
+ * `firmware_host --replay session.bin`.
+ *
+ * Usage: usb_session_record <session.bin>
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "usb_session.h"
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t monotonic_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000u) + ((uint64_t)now.tv_nsec / 1000u);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <session.bin>\n", argv[0]);
+        return 2;
+    }
+
+    FILE *session = fopen(argv[1], "wb");
+    if (session == NULL || !usb_session_write_header(session)) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    uint8_t buffer[USB_SESSION_MAX_RECORD];
+    uint64_t start_us = monotonic_us();
+    ssize_t count;
+    while ((count = read(STDIN_FILENO, buffer, sizeof(buffer))) > 0) {
+        uint64_t timestamp_us = monotonic_us() - start_us;
+        if (write(STDOUT_FILENO, buffer, (size_t)count) != count ||
+            !usb_session_write_record(session, timestamp_us, buffer, (size_t)count)) {
+            perror("usb_session_record");
+            break;
+        }
+        fflush(session);
+    }
+
+    fclose(session);
+    return 0;
+}